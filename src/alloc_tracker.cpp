@@ -0,0 +1,426 @@
+#include "alloc_tracker.h"
+
+#include "doctest/doctest.h"
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#ifdef _WIN32
+#include <malloc.h> // _aligned_malloc
+#endif
+
+namespace cst {
+namespace alloc_tracker {
+
+namespace {
+
+constexpr auto relaxed = std::memory_order_relaxed;
+constexpr unsigned max_scopes = 32;
+
+std::atomic<std::size_t> allocations{0};
+std::atomic<std::size_t> deallocations{0};
+std::atomic<std::size_t> bytes{0};
+std::atomic<std::size_t> live{0};
+// Bit i set - scope_peak[i] belongs to a live Scope.
+std::atomic<std::uint32_t> scopes_in_use{0};
+std::atomic<std::size_t> scope_peak[max_scopes];
+
+thread_local unsigned paused = 0;
+bool report_requested = false;
+
+void raise(std::atomic<std::size_t>& peak, std::size_t value) {
+  std::size_t old = peak.load(relaxed);
+  while (old < value && !peak.compare_exchange_weak(old, value, relaxed)) {
+  }
+}
+
+[[maybe_unused]] void on_allocate(std::size_t n) {
+  allocations.fetch_add(1, relaxed);
+  bytes.fetch_add(n, relaxed);
+  const std::size_t now = live.fetch_add(n, relaxed) + n;
+  const std::uint32_t mask = scopes_in_use.load(relaxed);
+  for (unsigned i = 0; i < max_scopes && (mask >> i) != 0; ++i) {
+    if ((mask >> i) & 1) {
+      raise(scope_peak[i], now);
+    }
+  }
+}
+
+[[maybe_unused]] void on_deallocate(std::size_t n) {
+  deallocations.fetch_add(1, relaxed);
+  live.fetch_sub(n, relaxed);
+}
+
+} // namespace
+
+Scope::Scope() : start_(totals()), start_live_(live.load(relaxed)) {
+  std::uint32_t mask = scopes_in_use.load(relaxed);
+  for (;;) {
+    unsigned i = 0;
+    while (i < max_scopes && ((mask >> i) & 1)) {
+      ++i;
+    }
+    if (i == max_scopes) {
+      return;
+    }
+    scope_peak[i].store(start_live_, relaxed);
+    if (scopes_in_use.compare_exchange_weak(mask, mask | (std::uint32_t{1} << i))) {
+      slot_ = static_cast<int>(i);
+      return;
+    }
+  }
+}
+
+Scope::~Scope() {
+  if (slot_ >= 0) {
+    scopes_in_use.fetch_and(~(std::uint32_t{1} << slot_));
+  }
+}
+
+Stats Scope::stats() const {
+  const Stats now = totals();
+  Stats s;
+  s.allocations = now.allocations - start_.allocations;
+  s.deallocations = now.deallocations - start_.deallocations;
+  s.bytes = now.bytes - start_.bytes;
+  if (slot_ >= 0) {
+    const std::size_t peak = scope_peak[slot_].load(relaxed);
+    s.peak_bytes = peak > start_live_ ? peak - start_live_ : 0;
+  }
+  return s;
+}
+
+Budget::~Budget() {
+  if (!enabled || std::uncaught_exceptions() != 0) {
+    return;
+  }
+  const Stats s = scope_.stats();
+  if (s.allocations > max_allocations_) {
+    Pause pause;
+    std::ostringstream msg;
+    msg << "allocation budget of " << max_allocations_ << " at " << file_ << ":" << line_ << " exceeded: "
+        << s.allocations << " allocations, " << s.bytes << " bytes";
+    FAIL_CHECK(msg.str());
+  }
+}
+
+Pause::Pause() { ++paused; }
+Pause::~Pause() { --paused; }
+
+Stats totals() {
+  Stats s;
+  s.allocations = allocations.load(relaxed);
+  s.deallocations = deallocations.load(relaxed);
+  s.bytes = bytes.load(relaxed);
+  return s;
+}
+
+std::size_t live_bytes() { return live.load(relaxed); }
+
+void apply_command_line(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--alloc-report") == 0) {
+      report_requested = true;
+    }
+  }
+  if (report_requested && !enabled) {
+    std::cerr << "[doctest] --alloc-report needs a build with -DCST_TRACK_ALLOCATIONS=ON\n";
+  }
+}
+
+namespace {
+
+// One row per test case and subcase, in the order they started.
+struct row {
+  std::string name;
+  unsigned depth = 0;
+  Stats stats;
+};
+
+class recorder {
+public:
+  void case_start(const char* name) {
+    rows_.push_back(row{name, 0, {}});
+    open_.clear();
+    open_.emplace_back(rows_.size() - 1, std::make_unique<Scope>());
+  }
+  void subcase_start(const char* name) {
+    const unsigned depth = static_cast<unsigned>(open_.size());
+    // A subcase runs once per re-entry of its test case, the numbers add up.
+    auto it = std::find_if(rows_.begin() + static_cast<std::ptrdiff_t>(open_.front().first), rows_.end(),
+                           [&](const row& r) { return r.depth == depth && r.name == name; });
+    if (it == rows_.end()) {
+      it = rows_.insert(rows_.end(), row{name, depth, {}});
+    }
+    open_.emplace_back(static_cast<std::size_t>(it - rows_.begin()), std::make_unique<Scope>());
+  }
+  void end() {
+    if (open_.empty()) {
+      return;
+    }
+    const Stats s = open_.back().second->stats();
+    Stats& total = rows_[open_.back().first].stats;
+    total.allocations += s.allocations;
+    total.deallocations += s.deallocations;
+    total.bytes += s.bytes;
+    total.peak_bytes = std::max(total.peak_bytes, s.peak_bytes);
+    open_.pop_back();
+  }
+
+  void print(std::ostream& os) const {
+    os << "===============================================================================\n"
+       << "[alloc] allocations        bytes   peak bytes  test case / subcase\n";
+    for (const auto& r : rows_) {
+      os << "[alloc] " << std::setw(11) << r.stats.allocations << std::setw(13) << r.stats.bytes << std::setw(13)
+         << r.stats.peak_bytes << "  " << std::string(2 * r.depth, ' ') << r.name << "\n";
+    }
+  }
+  void clear() {
+    rows_.clear();
+    open_.clear();
+  }
+
+private:
+  std::vector<row> rows_;
+  std::vector<std::pair<std::size_t, std::unique_ptr<Scope>>> open_;
+};
+
+struct alloc_listener : doctest::IReporter {
+  explicit alloc_listener(const doctest::ContextOptions&) {}
+
+  bool active() const { return enabled && report_requested; }
+
+  void report_query(const doctest::QueryData&) override {}
+  void test_run_start() override {
+    Pause pause;
+    rec.clear();
+  }
+  void test_run_end(const doctest::TestRunStats&) override {
+    if (active()) {
+      Pause pause;
+      rec.print(std::cout);
+    }
+  }
+  void test_case_start(const doctest::TestCaseData& tc) override {
+    if (active()) {
+      Pause pause;
+      rec.case_start(tc.m_name);
+    }
+  }
+  void test_case_reenter(const doctest::TestCaseData&) override {}
+  void test_case_end(const doctest::CurrentTestCaseStats&) override {
+    if (active()) {
+      Pause pause;
+      rec.end();
+    }
+  }
+  void test_case_exception(const doctest::TestCaseException&) override {}
+  void subcase_start(const doctest::SubcaseSignature& signature) override {
+    if (active()) {
+      Pause pause;
+      rec.subcase_start(signature.m_name);
+    }
+  }
+  void subcase_end() override {
+    if (active()) {
+      Pause pause;
+      rec.end();
+    }
+  }
+  void log_assert(const doctest::AssertData&) override {}
+  void log_message(const doctest::MessageData&) override {}
+  void test_case_skipped(const doctest::TestCaseData&) override {}
+
+  recorder rec;
+};
+
+REGISTER_LISTENER("cst-alloc-tracker", 2, alloc_listener);
+
+} // namespace
+
+} // namespace alloc_tracker
+} // namespace cst
+
+#ifdef CST_TRACK_ALLOCATIONS
+
+// Every block carries a header right below the returned pointer: the requested size and
+// the distance back to the start of the underlying malloc block. The top bit of the
+// distance marks blocks allocated during a Pause, those are not counted when freed.
+namespace {
+
+using cst::alloc_tracker::on_allocate;
+using cst::alloc_tracker::on_deallocate;
+using cst::alloc_tracker::paused;
+
+constexpr std::size_t default_alignment = alignof(std::max_align_t);
+constexpr std::size_t header_size =
+    2 * sizeof(std::size_t) > default_alignment ? 2 * sizeof(std::size_t) : default_alignment;
+constexpr std::size_t untracked = ~(~std::size_t{0} >> 1);
+
+void* raw_allocate(std::size_t size, std::size_t alignment) {
+  if (alignment <= default_alignment) {
+    return std::malloc(size);
+  }
+#ifdef _WIN32
+  return _aligned_malloc(size, alignment);
+#else
+  void* p = nullptr;
+  return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+#endif
+}
+
+void raw_free(void* p, std::size_t alignment) {
+#ifdef _WIN32
+  if (alignment > default_alignment) {
+    _aligned_free(p);
+    return;
+  }
+#else
+  static_cast<void>(alignment);
+#endif
+  std::free(p);
+}
+
+void* tracked_allocate(std::size_t size, std::size_t alignment) {
+  const std::size_t offset = std::max(header_size, alignment);
+  for (;;) {
+    if (void* raw = raw_allocate(size + offset, alignment)) {
+      auto* header = reinterpret_cast<std::size_t*>(static_cast<char*>(raw) + offset) - 2;
+      header[0] = paused != 0 ? offset | untracked : offset;
+      header[1] = size;
+      if (paused == 0) {
+        on_allocate(size);
+      }
+      return header + 2;
+    }
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+void* tracked_allocate_nothrow(std::size_t size, std::size_t alignment) noexcept {
+  try {
+    return tracked_allocate(size, alignment);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void tracked_deallocate(void* p, std::size_t alignment) noexcept {
+  if (p == nullptr) {
+    return;
+  }
+  auto* header = static_cast<std::size_t*>(p) - 2;
+  if ((header[0] & untracked) == 0) {
+    on_deallocate(header[1]);
+  }
+  raw_free(static_cast<char*>(p) - (header[0] & ~untracked), alignment);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return tracked_allocate(size, default_alignment); }
+void* operator new[](std::size_t size) { return tracked_allocate(size, default_alignment); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return tracked_allocate_nothrow(size, default_alignment);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return tracked_allocate_nothrow(size, default_alignment);
+}
+void* operator new(std::size_t size, std::align_val_t al) { return tracked_allocate(size, std::size_t(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return tracked_allocate(size, std::size_t(al)); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+  return tracked_allocate_nothrow(size, std::size_t(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+  return tracked_allocate_nothrow(size, std::size_t(al));
+}
+
+void operator delete(void* p) noexcept { tracked_deallocate(p, default_alignment); }
+void operator delete[](void* p) noexcept { tracked_deallocate(p, default_alignment); }
+void operator delete(void* p, std::size_t) noexcept { tracked_deallocate(p, default_alignment); }
+void operator delete[](void* p, std::size_t) noexcept { tracked_deallocate(p, default_alignment); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { tracked_deallocate(p, default_alignment); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { tracked_deallocate(p, default_alignment); }
+void operator delete(void* p, std::align_val_t al) noexcept { tracked_deallocate(p, std::size_t(al)); }
+void operator delete[](void* p, std::align_val_t al) noexcept { tracked_deallocate(p, std::size_t(al)); }
+void operator delete(void* p, std::size_t, std::align_val_t al) noexcept { tracked_deallocate(p, std::size_t(al)); }
+void operator delete[](void* p, std::size_t, std::align_val_t al) noexcept { tracked_deallocate(p, std::size_t(al)); }
+void operator delete(void* p, std::align_val_t al, const std::nothrow_t&) noexcept {
+  tracked_deallocate(p, std::size_t(al));
+}
+void operator delete[](void* p, std::align_val_t al, const std::nothrow_t&) noexcept {
+  tracked_deallocate(p, std::size_t(al));
+}
+
+#endif // CST_TRACK_ALLOCATIONS
+
+TEST_CASE("Allocation tracker") {
+  using cst::alloc_tracker::Scope;
+
+  SUBCASE("counts") {
+    Scope scope;
+    {
+      auto p = std::make_unique<char[]>(1000);
+      std::vector<int> v(10);
+      cst::alloc_tracker::Stats s = scope.stats();
+      if (cst::alloc_tracker::enabled) {
+        CHECK(s.allocations == 2);
+        CHECK(s.bytes == 1000 + 10 * sizeof(int));
+        CHECK(s.peak_bytes == s.bytes);
+      } else {
+        CHECK(s.allocations == 0);
+      }
+    }
+    const cst::alloc_tracker::Stats s = scope.stats();
+    CHECK(s.deallocations == s.allocations);
+    {
+      Scope inner;
+      auto p = std::make_unique<char[]>(10);
+      CHECK(inner.stats().peak_bytes <= scope.stats().peak_bytes);
+    }
+  }
+
+  SUBCASE("over-aligned") {
+    struct alignas(64) line {
+      char c[64];
+    };
+    Scope scope;
+    auto p = std::make_unique<line>();
+    CHECK(reinterpret_cast<std::uintptr_t>(p.get()) % 64 == 0);
+    CHECK(scope.stats().bytes == (cst::alloc_tracker::enabled ? sizeof(line) : 0));
+  }
+
+  SUBCASE("paused") {
+    Scope scope;
+    std::unique_ptr<int> p;
+    {
+      cst::alloc_tracker::Pause pause;
+      p = std::make_unique<int>(1);
+    }
+    p.reset();
+    CHECK(scope.stats().allocations == 0);
+    CHECK(scope.stats().deallocations == 0);
+  }
+
+  SUBCASE("budget") {
+    ALLOCATION_BUDGET(1);
+    auto p = std::make_shared<int>(42); // object and control block in one allocation
+    CHECK(*p == 42);
+  }
+}
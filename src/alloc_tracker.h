@@ -0,0 +1,95 @@
+#pragma once
+
+// Opt-in replacement of the global operator new/delete that counts allocations, bytes and
+// peak live bytes. Configure with -DCST_TRACK_ALLOCATIONS=ON; without it nothing is
+// replaced, the counters stay at zero and budgets are not checked.
+//
+//   TEST_CASE("Smart pointers") {
+//     ALLOCATION_BUDGET(1); // fails the case when the rest of the scope allocates more often
+//     auto p = std::make_unique<Foo>();
+//   }
+//
+//   cpp-std-test --alloc-report # allocations, bytes and peak per TEST_CASE and SUBCASE
+//
+// The counters are process wide, allocations made by other threads count as well.
+
+#include <cstddef>
+
+namespace cst {
+namespace alloc_tracker {
+
+#ifdef CST_TRACK_ALLOCATIONS
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+struct Stats {
+  std::size_t allocations = 0;
+  std::size_t deallocations = 0;
+  std::size_t bytes = 0;      // requested, never decremented
+  std::size_t peak_bytes = 0; // highest live bytes above those live when the scope began
+};
+
+// Counts from construction on. Up to 32 scopes track their peak at the same time,
+// further ones report a peak of 0.
+class Scope {
+public:
+  Scope();
+  ~Scope();
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+  Stats stats() const;
+
+private:
+  Stats start_;
+  std::size_t start_live_ = 0;
+  int slot_ = -1;
+};
+
+// Fails the current test case (FAIL_CHECK) at the end of the scope if more than
+// `max_allocations` allocations happened in it.
+class Budget {
+public:
+  Budget(std::size_t max_allocations, const char* file, int line)
+      : max_allocations_(max_allocations), file_(file), line_(line) {}
+  ~Budget();
+
+  Budget(const Budget&) = delete;
+  Budget& operator=(const Budget&) = delete;
+
+private:
+  Scope scope_;
+  std::size_t max_allocations_;
+  const char* file_;
+  int line_;
+};
+
+// Allocations on this thread while a Pause is alive are not counted, neither is their
+// deallocation. For the bookkeeping of the tracker's own listener.
+class Pause {
+public:
+  Pause();
+  ~Pause();
+
+  Pause(const Pause&) = delete;
+  Pause& operator=(const Pause&) = delete;
+};
+
+// Totals since the start of the process.
+Stats totals();
+std::size_t live_bytes();
+
+// Picks up --alloc-report; the listener prints the table at the end of every run.
+void apply_command_line(int argc, char** argv);
+
+} // namespace alloc_tracker
+} // namespace cst
+
+#define CST_ALLOC_CAT_IMPL(a, b) a##b
+#define CST_ALLOC_CAT(a, b) CST_ALLOC_CAT_IMPL(a, b)
+#define ALLOCATION_BUDGET(max_allocations)                                                         \
+  const cst::alloc_tracker::Budget CST_ALLOC_CAT(cst_allocation_budget_, __COUNTER__)(max_allocations, \
+                                                                                      __FILE__, __LINE__)
@@ -0,0 +1,251 @@
+#pragma once
+
+// std::any with a configurable inline buffer and casts that compare a per-type table
+// pointer instead of typeid:
+//
+//   cst::basic_any<64> a = std::array<char, 48>{}; // inline, std::any would allocate
+//   auto* p = cst::any_cast<std::array<char, 48>>(&a);
+//   cst::unique_any u = std::make_unique<int>(1);  // move-only values, move-only any
+//
+// Values that fit the buffer and have a noexcept move constructor are stored inline,
+// everything else on the heap. The casts need no RTTI, but the identity of a type is the
+// address of an inline variable, which shared libraries without symbol interposition
+// (Windows DLLs) may duplicate; keep an any inside one module there.
+
+#include <any> // std::bad_any_cast
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cst {
+
+template <std::size_t Size, std::size_t Align = alignof(std::max_align_t), bool Copyable = true>
+class basic_any;
+
+namespace detail {
+
+template <typename T>
+struct is_basic_any : std::false_type {};
+template <std::size_t Size, std::size_t Align, bool Copyable>
+struct is_basic_any<basic_any<Size, Align, Copyable>> : std::true_type {};
+
+template <typename T>
+struct is_in_place_type : std::false_type {};
+template <typename T>
+struct is_in_place_type<std::in_place_type_t<T>> : std::true_type {};
+
+// Stands in for the copy source of a move-only basic_any, whose real copy constructor is
+// then implicitly deleted by the user-declared move constructor.
+struct any_not_copyable {
+  any_not_copyable() = delete;
+};
+
+} // namespace detail
+
+template <std::size_t Size, std::size_t Align, bool Copyable>
+class basic_any {
+  union storage {
+    void* heap;
+    alignas(Align) unsigned char buffer[Size < sizeof(void*) ? sizeof(void*) : Size];
+  };
+
+  struct vtable {
+    void (*destroy)(storage&) noexcept;
+    void (*copy)(const storage& from, storage& to); // nullptr for move-only any
+    void (*move)(storage& from, storage& to) noexcept; // leaves `from` destroyed
+  };
+
+  using copy_source = std::conditional_t<Copyable, basic_any, detail::any_not_copyable>;
+
+public:
+  template <typename T>
+  static constexpr bool stores_inline = sizeof(T) <= sizeof(storage::buffer) && alignof(T) <= Align &&
+                                        std::is_nothrow_move_constructible_v<T>;
+
+  basic_any() noexcept = default;
+  basic_any(const copy_source& other) : vtable_(other.vtable_) {
+    if (vtable_ != nullptr) {
+      vtable_->copy(other.storage_, storage_);
+    }
+  }
+  basic_any(basic_any&& other) noexcept : vtable_(other.vtable_) {
+    if (vtable_ != nullptr) {
+      vtable_->move(other.storage_, storage_);
+      other.vtable_ = nullptr;
+    }
+  }
+  template <typename T, typename D = std::decay_t<T>,
+            typename = std::enable_if_t<!detail::is_basic_any<D>::value && !detail::is_in_place_type<D>::value>>
+  basic_any(T&& value) {
+    emplace<D>(std::forward<T>(value));
+  }
+  template <typename T, typename... Args>
+  explicit basic_any(std::in_place_type_t<T>, Args&&... args) {
+    emplace<T>(std::forward<Args>(args)...);
+  }
+  ~basic_any() { reset(); }
+
+  basic_any& operator=(const copy_source& other) {
+    basic_any(other).swap(*this);
+    return *this;
+  }
+  basic_any& operator=(basic_any&& other) noexcept {
+    basic_any(std::move(other)).swap(*this);
+    return *this;
+  }
+  template <typename T, typename = std::enable_if_t<!detail::is_basic_any<std::decay_t<T>>::value>>
+  basic_any& operator=(T&& value) {
+    basic_any(std::forward<T>(value)).swap(*this);
+    return *this;
+  }
+
+  template <typename T, typename... Args>
+  std::decay_t<T>& emplace(Args&&... args) {
+    using D = std::decay_t<T>;
+    static_assert(!Copyable || std::is_copy_constructible_v<D>,
+                  "basic_any needs copyable values, use a move-only basic_any (unique_any)");
+    reset();
+    D* p;
+    if constexpr (stores_inline<D>) {
+      p = ::new (static_cast<void*>(storage_.buffer)) D(std::forward<Args>(args)...);
+    } else {
+      p = new D(std::forward<Args>(args)...);
+      storage_.heap = p;
+    }
+    vtable_ = &vtable_for<D>;
+    return *p;
+  }
+
+  void reset() noexcept {
+    if (vtable_ != nullptr) {
+      vtable_->destroy(storage_);
+      vtable_ = nullptr;
+    }
+  }
+  void swap(basic_any& other) noexcept {
+    if (this == &other) {
+      return;
+    }
+    storage tmp;
+    if (other.vtable_ != nullptr) {
+      other.vtable_->move(other.storage_, tmp);
+    }
+    if (vtable_ != nullptr) {
+      vtable_->move(storage_, other.storage_);
+    }
+    if (other.vtable_ != nullptr) {
+      other.vtable_->move(tmp, storage_);
+    }
+    std::swap(vtable_, other.vtable_);
+  }
+
+  bool has_value() const noexcept { return vtable_ != nullptr; }
+  // Exact type test, like any_cast: no conversions, no cv-qualifiers.
+  template <typename T>
+  bool holds() const noexcept {
+    return vtable_ == &vtable_for<T>;
+  }
+
+  template <typename T>
+  T* get_if() noexcept {
+    return holds<T>() ? object<T>(storage_) : nullptr;
+  }
+  template <typename T>
+  const T* get_if() const noexcept {
+    return holds<T>() ? object<T>(const_cast<storage&>(storage_)) : nullptr;
+  }
+
+private:
+  template <typename T>
+  static T* object(storage& s) noexcept {
+    if constexpr (stores_inline<T>) {
+      return std::launder(reinterpret_cast<T*>(s.buffer));
+    } else {
+      return static_cast<T*>(s.heap);
+    }
+  }
+
+  template <typename T>
+  static void destroy(storage& s) noexcept {
+    if constexpr (stores_inline<T>) {
+      object<T>(s)->~T();
+    } else {
+      delete object<T>(s);
+    }
+  }
+  template <typename T>
+  static void copy(const storage& from, storage& to) {
+    const T& value = *object<T>(const_cast<storage&>(from));
+    if constexpr (stores_inline<T>) {
+      ::new (static_cast<void*>(to.buffer)) T(value);
+    } else {
+      to.heap = new T(value);
+    }
+  }
+  template <typename T>
+  static void move(storage& from, storage& to) noexcept {
+    if constexpr (stores_inline<T>) {
+      ::new (static_cast<void*>(to.buffer)) T(std::move(*object<T>(from)));
+      object<T>(from)->~T();
+    } else {
+      to.heap = from.heap;
+    }
+  }
+
+  template <typename T>
+  static constexpr auto copier() -> void (*)(const storage&, storage&) {
+    if constexpr (Copyable) {
+      return &copy<T>;
+    } else {
+      return nullptr; // T may be move-only
+    }
+  }
+
+  // One table per stored type; its address is the type's identity.
+  template <typename T>
+  static constexpr vtable vtable_for = {&destroy<T>, copier<T>(), &move<T>};
+
+  storage storage_;
+  const vtable* vtable_ = nullptr;
+};
+
+// 32 bytes inline: a std::string or four pointers.
+using any = basic_any<32>;
+using unique_any = basic_any<32, alignof(std::max_align_t), false>;
+
+template <typename T, std::size_t Size, std::size_t Align, bool Copyable>
+T* any_cast(basic_any<Size, Align, Copyable>* a) noexcept {
+  return a != nullptr ? a->template get_if<T>() : nullptr;
+}
+template <typename T, std::size_t Size, std::size_t Align, bool Copyable>
+const T* any_cast(const basic_any<Size, Align, Copyable>* a) noexcept {
+  return a != nullptr ? a->template get_if<T>() : nullptr;
+}
+// By value or reference, like std::any_cast; throws std::bad_any_cast on a type mismatch.
+template <typename T, std::size_t Size, std::size_t Align, bool Copyable>
+T any_cast(basic_any<Size, Align, Copyable>& a) {
+  auto* p = any_cast<std::remove_cv_t<std::remove_reference_t<T>>>(&a);
+  if (p == nullptr) {
+    throw std::bad_any_cast();
+  }
+  return static_cast<T>(*p);
+}
+template <typename T, std::size_t Size, std::size_t Align, bool Copyable>
+T any_cast(const basic_any<Size, Align, Copyable>& a) {
+  auto* p = any_cast<std::remove_cv_t<std::remove_reference_t<T>>>(&a);
+  if (p == nullptr) {
+    throw std::bad_any_cast();
+  }
+  return static_cast<T>(*p);
+}
+template <typename T, std::size_t Size, std::size_t Align, bool Copyable>
+T any_cast(basic_any<Size, Align, Copyable>&& a) {
+  auto* p = any_cast<std::remove_cv_t<std::remove_reference_t<T>>>(&a);
+  if (p == nullptr) {
+    throw std::bad_any_cast();
+  }
+  return static_cast<T>(std::move(*p));
+}
+
+} // namespace cst
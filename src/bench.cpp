@@ -0,0 +1,412 @@
+#include "bench.h"
+
+#include "doctest/doctest.h"
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+namespace cst {
+namespace bench {
+
+namespace {
+
+struct Case {
+  const char* name;
+  const char* file;
+  int line;
+  CaseFunction fn;
+};
+
+std::vector<Case>& registry() {
+  static std::vector<Case> cases;
+  return cases;
+}
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ns(Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+double time_batch(const std::function<void(std::uint64_t)>& batch, std::uint64_t n) {
+  auto start = Clock::now();
+  batch(n);
+  return elapsed_ns(start);
+}
+
+// Two-sided 97.5% quantiles of Student's t distribution, df = 1..30.
+double t_quantile(std::size_t df) {
+  static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                 2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                 2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+  if (df == 0) {
+    return 0;
+  }
+  return df <= 30 ? table[df - 1] : 1.96;
+}
+
+double quantile(const std::vector<double>& sorted, double q) {
+  double pos = q * (sorted.size() - 1);
+  auto lo = static_cast<std::size_t>(pos);
+  auto hi = std::min(lo + 1, sorted.size() - 1);
+  return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+}
+
+bool wildcard_match(const char* str, const char* pattern) {
+  if (*pattern == '\0') {
+    return *str == '\0';
+  }
+  if (*pattern == '*') {
+    return wildcard_match(str, pattern + 1) || (*str != '\0' && wildcard_match(str + 1, pattern));
+  }
+  if (*str != '\0' && (*pattern == '?' || std::tolower(*pattern) == std::tolower(*str))) {
+    return wildcard_match(str + 1, pattern + 1);
+  }
+  return false;
+}
+
+bool matches_filter(const char* name, const std::string& filter) {
+  std::stringstream ss(filter);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (wildcard_match(name, item.c_str())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string format_rate(double per_second, const char* unit) {
+  static const char* prefixes[] = {"", "K", "M", "G", "T"};
+  int i = 0;
+  while (per_second >= 1000 && i < 4) {
+    per_second /= 1000;
+    ++i;
+  }
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.2f %s%s", per_second, prefixes[i], unit);
+  return buf;
+}
+
+void print_result(std::ostream& os, const Result& r) {
+  char line[256];
+  double half_ci = (r.ns.ci_high - r.ns.ci_low) / 2;
+  double rel_ci = r.ns.mean > 0 ? 100 * half_ci / r.ns.mean : 0;
+  std::snprintf(line, sizeof(line), "  %-40s %12s %12s +-%5.1f%% %10llux%-3zu %3zu out", r.name.c_str(),
+                format_time(r.ns.median).c_str(), format_time(r.ns.mean).c_str(), rel_ci,
+                static_cast<unsigned long long>(r.iterations), r.ns.samples, r.ns.outliers);
+  os << line;
+  if (r.bytes_per_op > 0 && r.ns.mean > 0) {
+    os << "  " << format_rate(r.bytes_per_op * 1e9 / r.ns.mean, "B/s");
+  }
+  if (r.items_per_op > 0 && r.ns.mean > 0) {
+    os << "  " << format_rate(r.items_per_op * 1e9 / r.ns.mean, "items/s");
+  }
+  os << "\n";
+}
+
+void write_json(std::ostream& os, const std::vector<Result>& results) {
+  const auto precision = os.precision(17); // round-trips a double, the default 6 digits do not
+  os << "{\n  \"context\": {\"hardware_concurrency\": " << std::thread::hardware_concurrency()
+     << ", \"compiler\": \"" << json_escape(
+#if defined(__clang__)
+            "clang " __clang_version__
+#elif defined(__GNUC__)
+            "gcc " __VERSION__
+#elif defined(_MSC_VER)
+            "msvc " + std::to_string(_MSC_VER)
+#else
+            "unknown"
+#endif
+            ) << "\"},\n  \"benchmarks\": [";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const auto& r = results[i];
+    os << (i ? ",\n" : "\n") << "    {\"case\": \"" << json_escape(r.case_name) << "\", \"name\": \""
+       << json_escape(r.name) << "\", \"iterations\": " << r.iterations << ", \"samples\": " << r.ns.samples
+       << ", \"outliers\": " << r.ns.outliers << ", \"mean_ns\": " << r.ns.mean
+       << ", \"median_ns\": " << r.ns.median << ", \"stddev_ns\": " << r.ns.stddev
+       << ", \"ci95_low_ns\": " << r.ns.ci_low << ", \"ci95_high_ns\": " << r.ns.ci_high
+       << ", \"min_ns\": " << r.ns.min << ", \"max_ns\": " << r.ns.max;
+    if (r.items_per_op > 0 && r.ns.mean > 0) {
+      os << ", \"items_per_second\": " << r.items_per_op * 1e9 / r.ns.mean;
+    }
+    if (r.bytes_per_op > 0 && r.ns.mean > 0) {
+      os << ", \"bytes_per_second\": " << r.bytes_per_op * 1e9 / r.ns.mean;
+    }
+    os << ", \"counters\": {";
+    for (std::size_t j = 0; j < r.counters.size(); ++j) {
+      os << (j ? ", " : "") << "\"" << json_escape(r.counters[j].first) << "\": " << r.counters[j].second;
+    }
+    os << "}}";
+  }
+  os << "\n  ]\n}\n";
+  os.precision(precision);
+}
+
+} // namespace
+
+std::string format_time(double ns) {
+  char buf[32];
+  if (ns < 1e3) {
+    std::snprintf(buf, sizeof(buf), "%.2f ns", ns);
+  } else if (ns < 1e6) {
+    std::snprintf(buf, sizeof(buf), "%.2f us", ns / 1e3);
+  } else if (ns < 1e9) {
+    std::snprintf(buf, sizeof(buf), "%.2f ms", ns / 1e6);
+  } else {
+    std::snprintf(buf, sizeof(buf), "%.2f s", ns / 1e9);
+  }
+  return buf;
+}
+
+std::string json_escape(const std::string& s) {
+  std::string out;
+  for (char c : s) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+          out += buf;
+        } else {
+          out += c;
+        }
+    }
+  }
+  return out;
+}
+
+bool parse_option(const char* arg, const char* name, std::string& value) {
+  auto len = std::strlen(name);
+  if (std::strncmp(arg, name, len) != 0 || arg[len] != '=') {
+    return false;
+  }
+  value = arg + len + 1;
+  return true;
+}
+
+Summary summarize(std::vector<double> values) {
+  Summary s;
+  if (values.empty()) {
+    return s;
+  }
+  std::sort(values.begin(), values.end());
+  if (values.size() >= 4) {
+    double q1 = quantile(values, 0.25);
+    double q3 = quantile(values, 0.75);
+    double lo = q1 - 1.5 * (q3 - q1);
+    double hi = q3 + 1.5 * (q3 - q1);
+    auto first = std::lower_bound(values.begin(), values.end(), lo);
+    auto last = std::upper_bound(first, values.end(), hi);
+    s.outliers = values.size() - (last - first);
+    values = std::vector<double>(first, last);
+  }
+  s.samples = values.size();
+  s.min = values.front();
+  s.max = values.back();
+  s.median = quantile(values, 0.5);
+  double sum = 0;
+  for (double v : values) {
+    sum += v;
+  }
+  s.mean = sum / values.size();
+  double sq = 0;
+  for (double v : values) {
+    sq += (v - s.mean) * (v - s.mean);
+  }
+  s.stddev = values.size() > 1 ? std::sqrt(sq / (values.size() - 1)) : 0;
+  double half = t_quantile(values.size() - 1) * s.stddev / std::sqrt(static_cast<double>(values.size()));
+  s.ci_low = s.mean - half;
+  s.ci_high = s.mean + half;
+  return s;
+}
+
+Bench::Bench(const Options& opt, std::string case_name) : opt_(opt), case_name_(std::move(case_name)) {}
+
+unsigned Bench::max_threads() const {
+  if (opt_.max_threads != 0) {
+    return opt_.max_threads;
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+Bench& Bench::run_batched(const std::string& name, const std::function<void(std::uint64_t)>& batch) {
+  const double min_sample_ns = opt_.min_sample_ms * 1e6;
+  const double warmup_ns = opt_.warmup_ms * 1e6;
+
+  // Warmup doubles as calibration: grow the batch until one sample is long enough.
+  std::uint64_t n = iterations_ != 0 ? iterations_ : 1;
+  auto warmup_start = Clock::now();
+  double t = time_batch(batch, n);
+  if (iterations_ == 0) {
+    while (t < min_sample_ns) {
+      double scale = t > 0 ? min_sample_ns / t : 10;
+      n = static_cast<std::uint64_t>(n * std::min(10.0, std::max(2.0, scale * 1.1)));
+      t = time_batch(batch, n);
+    }
+  }
+  while (elapsed_ns(warmup_start) < warmup_ns) {
+    t = time_batch(batch, n);
+  }
+
+  std::size_t samples = opt_.samples;
+  if (t * samples > opt_.max_run_ms * 1e6) {
+    samples = std::max<std::size_t>(3, static_cast<std::size_t>(opt_.max_run_ms * 1e6 / std::max(t, 1.0)));
+  }
+  std::vector<double> per_op;
+  per_op.reserve(samples);
+  for (std::size_t i = 0; i < samples; ++i) {
+    per_op.push_back(time_batch(batch, n) / n);
+  }
+
+  Result r;
+  r.case_name = case_name_;
+  r.name = name;
+  r.iterations = n;
+  r.ns = summarize(std::move(per_op));
+  r.items_per_op = items_;
+  r.bytes_per_op = bytes_;
+  results_.push_back(r);
+  print_result(std::cout, r);
+  return *this;
+}
+
+Bench& Bench::counter(const std::string& name, double value) {
+  if (!results_.empty()) {
+    results_.back().counters.emplace_back(name, value);
+    std::cout << "    " << name << " = " << value << "\n";
+  }
+  return *this;
+}
+
+int register_case(const char* name, const char* file, int line, CaseFunction fn) {
+  registry().push_back(Case{name, file, line, fn});
+  return static_cast<int>(registry().size());
+}
+
+#if !defined(__GNUC__) && !defined(__clang__)
+void use_char_pointer(char const volatile*) {}
+#endif
+
+bool requested(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--bench", 7) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int run_main(int argc, char** argv) {
+  Options opt;
+  for (int i = 1; i < argc; ++i) {
+    std::string value;
+    if (parse_option(argv[i], "--bench", value)) {
+      opt.filter = value;
+    } else if (parse_option(argv[i], "--bench-json", value)) {
+      opt.json_path = value;
+    } else if (parse_option(argv[i], "--bench-samples", value)) {
+      opt.samples = std::max(1, std::stoi(value));
+    } else if (parse_option(argv[i], "--bench-warmup", value)) {
+      opt.warmup_ms = std::stod(value);
+    } else if (parse_option(argv[i], "--bench-min-time", value)) {
+      opt.min_sample_ms = std::stod(value);
+    } else if (parse_option(argv[i], "--bench-max-time", value)) {
+      opt.max_run_ms = std::stod(value);
+    } else if (parse_option(argv[i], "--bench-max-size", value)) {
+      opt.max_size = std::stoull(value);
+    } else if (parse_option(argv[i], "--bench-threads", value)) {
+      opt.max_threads = static_cast<unsigned>(std::stoul(value));
+    } else if (std::strcmp(argv[i], "--bench-list") == 0) {
+      opt.list = true;
+    }
+  }
+
+  std::vector<const Case*> cases;
+  for (const auto& c : registry()) {
+    if (matches_filter(c.name, opt.filter)) {
+      cases.push_back(&c);
+    }
+  }
+  std::sort(cases.begin(), cases.end(), [](const Case* a, const Case* b) {
+    return std::strcmp(a->name, b->name) < 0;
+  });
+
+  if (opt.list) {
+    for (const auto* c : cases) {
+      std::cout << c->name << "  (" << c->file << ":" << c->line << ")\n";
+    }
+    return 0;
+  }
+
+  // With the JSON report on stdout the human-readable output would corrupt it.
+  std::streambuf* console = nullptr;
+  std::ostringstream discard;
+  if (opt.json_path == "-") {
+    console = std::cout.rdbuf(discard.rdbuf());
+  }
+
+  std::vector<Result> results;
+  for (const auto* c : cases) {
+    std::cout << "\n" << c->name << "\n";
+    char header[256];
+    std::snprintf(header, sizeof(header), "  %-40s %12s %12s %8s %14s %7s\n", "benchmark", "median", "mean",
+                  "95% CI", "iters x samp", "outliers");
+    std::cout << header;
+    Bench bench(opt, c->name);
+    c->fn(bench);
+    results.insert(results.end(), bench.results().begin(), bench.results().end());
+  }
+
+  if (console != nullptr) {
+    std::cout.rdbuf(console);
+    write_json(std::cout, results);
+  } else if (!opt.json_path.empty()) {
+    std::ofstream out(opt.json_path);
+    if (!out) {
+      std::cerr << "cannot write " << opt.json_path << "\n";
+      return 1;
+    }
+    write_json(out, results);
+  }
+  return 0;
+}
+
+} // namespace bench
+} // namespace cst
+
+TEST_CASE("Benchmark statistics") {
+  SUBCASE("outliers") {
+    auto s = cst::bench::summarize({10, 11, 10, 12, 11, 10, 11, 500});
+    CHECK(s.outliers == 1);
+    CHECK(s.samples == 7);
+    CHECK(s.max == 12);
+    CHECK(s.median == 11);
+  }
+  SUBCASE("confidence interval") {
+    auto s = cst::bench::summarize({1, 2, 3, 4, 5});
+    CHECK(s.mean == doctest::Approx(3));
+    CHECK(s.stddev == doctest::Approx(std::sqrt(2.5)));
+    CHECK(s.ci_low < s.mean);
+    CHECK(s.ci_high > s.mean);
+    CHECK(s.ci_high - s.mean == doctest::Approx(2.776 * std::sqrt(2.5) / std::sqrt(5.0)));
+  }
+  SUBCASE("empty") {
+    auto s = cst::bench::summarize({});
+    CHECK(s.samples == 0);
+  }
+}
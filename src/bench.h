@@ -0,0 +1,145 @@
+#pragma once
+
+// Micro-benchmarks that live next to the TEST_CASEs and run with `cpp-std-test --bench`.
+//
+//   BENCH_CASE("Move semantics && std::move") {
+//     std::vector<int> src(1000);
+//     bench.run("copy", [&] { auto dst = src; cst::bench::do_not_optimize(dst); });
+//   }
+//
+// Every `run` warms up, picks an iteration count so that one sample takes at least
+// `--bench-min-time` ms, drops Tukey outliers and reports mean/median with a 95% CI.
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cst {
+namespace bench {
+
+struct Options {
+  std::string filter = "*";      // comma separated wildcards on BENCH_CASE names
+  std::string json_path;         // "-" writes the JSON report to stdout
+  std::size_t samples = 20;
+  double warmup_ms = 20;
+  double min_sample_ms = 5;      // a sample is never shorter than this
+  double max_run_ms = 2000;      // time budget of a single `run`, lowers the sample count
+  std::uint64_t max_size = 10000000; // upper bound for size-parameterised cases
+  unsigned max_threads = 0;      // 0 - std::thread::hardware_concurrency()
+  bool list = false;
+};
+
+// Statistics over per-operation times of the collected samples.
+struct Summary {
+  std::size_t samples = 0;
+  std::size_t outliers = 0;
+  double mean = 0;
+  double median = 0;
+  double stddev = 0;
+  double ci_low = 0;  // 95% confidence interval of the mean
+  double ci_high = 0;
+  double min = 0;
+  double max = 0;
+};
+
+struct Result {
+  std::string case_name;
+  std::string name;
+  std::uint64_t iterations = 0; // per sample
+  Summary ns;                   // nanoseconds per operation
+  double items_per_op = 0;
+  double bytes_per_op = 0;
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+// Drops values outside the Tukey fences (1.5 IQR) and summarizes the rest.
+Summary summarize(std::vector<double> values);
+
+class Bench {
+public:
+  Bench(const Options& opt, std::string case_name);
+
+  // Throughput annotations for the following runs; 0 disables them.
+  Bench& items(double per_op) { items_ = per_op; return *this; }
+  Bench& bytes(double per_op) { bytes_ = per_op; return *this; }
+  // Fixes the iterations per sample for the following runs (0 - adaptive).
+  Bench& iterations(std::uint64_t n) { iterations_ = n; return *this; }
+
+  template <typename Op>
+  Bench& run(const std::string& name, Op&& op) {
+    return run_batched(name, [&op](std::uint64_t n) {
+      for (std::uint64_t i = 0; i < n; ++i) {
+        op();
+      }
+    });
+  }
+  // `batch(n)` has to perform n operations.
+  Bench& run_batched(const std::string& name, const std::function<void(std::uint64_t)>& batch);
+
+  // Attaches a custom value (copies per element, p99 latency, ...) to the last run.
+  Bench& counter(const std::string& name, double value);
+
+  std::uint64_t max_size() const { return opt_.max_size; }
+  unsigned max_threads() const;
+  const std::vector<Result>& results() const { return results_; }
+
+private:
+  const Options& opt_;
+  std::string case_name_;
+  double items_ = 0;
+  double bytes_ = 0;
+  std::uint64_t iterations_ = 0;
+  std::vector<Result> results_;
+};
+
+using CaseFunction = void (*)(Bench&);
+int register_case(const char* name, const char* file, int line, CaseFunction fn);
+
+// Report helpers, shared with the test timings.
+std::string format_time(double ns);           // "12.34 us"
+std::string json_escape(const std::string& s);
+// Matches "<name>=<value>" and stores the value.
+bool parse_option(const char* arg, const char* name, std::string& value);
+
+// True if argv asks for benchmark mode instead of the doctest run.
+bool requested(int argc, char** argv);
+int run_main(int argc, char** argv);
+
+#if defined(__GNUC__) || defined(__clang__)
+template <typename T>
+inline void do_not_optimize(T const& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+template <typename T>
+inline void do_not_optimize(T& value) {
+  asm volatile("" : "+r,m"(value) : : "memory");
+}
+inline void clobber_memory() {
+  asm volatile("" : : : "memory");
+}
+#else
+void use_char_pointer(char const volatile*);
+template <typename T>
+inline void do_not_optimize(T const& value) {
+  use_char_pointer(&reinterpret_cast<char const volatile&>(value));
+}
+inline void clobber_memory() {
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+}
+#endif
+
+} // namespace bench
+} // namespace cst
+
+#define CST_BENCH_CAT_IMPL(a, b) a##b
+#define CST_BENCH_CAT(a, b) CST_BENCH_CAT_IMPL(a, b)
+#define CST_BENCH_CASE_IMPL(fn, name)                                                   \
+  static void fn(cst::bench::Bench& bench);                                            \
+  static const int CST_BENCH_CAT(fn, _registered) =                                    \
+      cst::bench::register_case(name, __FILE__, __LINE__, fn);                         \
+  static void fn(cst::bench::Bench& bench)
+#define BENCH_CASE(name) CST_BENCH_CASE_IMPL(CST_BENCH_CAT(cst_bench_case_, __COUNTER__), name)
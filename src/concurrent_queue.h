@@ -0,0 +1,205 @@
+#pragma once
+
+// Bounded lock-free queues over a power-of-two ring of slots:
+//
+//   cst::spsc_queue<int> q(1024);        // one producer thread, one consumer thread
+//   q.try_push(1);                       // false when full
+//   int x;
+//   if (q.try_pop(x)) {}                 // false when empty
+//
+//   cst::mpmc_queue<job> jobs(4096);     // any number of producers and consumers
+//
+// Neither call blocks; callers decide whether to spin, yield or sleep. The indices that
+// producers and consumers write live on separate cache lines, so the two sides do not
+// invalidate each other's line on every operation.
+//
+// spsc_queue: each side keeps a private copy of the other side's index and reloads it
+// only when the ring looks full (empty), so an uncontended push or pop touches one
+// shared cache line. mpmc_queue: Vyukov's bounded queue, every slot carries a sequence
+// number that tells producers and consumers whose turn it is; one CAS per operation.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cst {
+
+// Fixed rather than std::hardware_destructive_interference_size, which is missing from
+// older standard libraries and which GCC warns about using in headers.
+inline constexpr std::size_t cache_line_size = 64;
+
+namespace detail {
+
+inline std::size_t ring_capacity(std::size_t requested) {
+  std::size_t capacity = 2;
+  while (capacity < requested) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+template <typename T>
+struct ring_slot {
+  T* get() noexcept { return std::launder(reinterpret_cast<T*>(bytes)); }
+  alignas(T) unsigned char bytes[sizeof(T)];
+};
+
+} // namespace detail
+
+template <typename T>
+class spsc_queue {
+public:
+  // Rounds the capacity up to a power of two, at least 2.
+  explicit spsc_queue(std::size_t capacity)
+      : mask_(detail::ring_capacity(capacity) - 1), slots_(new detail::ring_slot<T>[mask_ + 1]) {}
+  ~spsc_queue() {
+    for (std::size_t i = head_.load(std::memory_order_relaxed); i != tail_.load(std::memory_order_relaxed); ++i) {
+      slots_[i & mask_].get()->~T();
+    }
+  }
+  spsc_queue(const spsc_queue&) = delete;
+  spsc_queue& operator=(const spsc_queue&) = delete;
+
+  // Producer side.
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ > mask_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ > mask_) {
+        return false;
+      }
+    }
+    ::new (static_cast<void*>(slots_[tail & mask_].bytes)) T(std::forward<Args>(args)...);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+  bool try_push(const T& value) { return try_emplace(value); }
+  bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+  // Consumer side. If the assignment to `out` throws, the element stays queued.
+  bool try_pop(T& out) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return false;
+      }
+    }
+    T* p = slots_[head & mask_].get();
+    out = std::move(*p);
+    p->~T();
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  std::size_t capacity() const { return mask_ + 1; }
+  // Exact only when called from one side while the other is idle.
+  std::size_t size() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+
+private:
+  const std::size_t mask_;
+  const std::unique_ptr<detail::ring_slot<T>[]> slots_;
+
+  // Written by the consumer.
+  alignas(cache_line_size) std::atomic<std::size_t> head_{0};
+  std::size_t cached_tail_ = 0;
+  // Written by the producer.
+  alignas(cache_line_size) std::atomic<std::size_t> tail_{0};
+  std::size_t cached_head_ = 0;
+};
+
+template <typename T>
+class mpmc_queue {
+  // A producer claims a slot before constructing the element in it, so a construction
+  // that throws would leave a hole no consumer could get past.
+  static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>,
+                "mpmc_queue needs a noexcept move constructor and move assignment");
+
+  struct cell {
+    std::atomic<std::size_t> sequence;
+    detail::ring_slot<T> slot;
+  };
+
+public:
+  // Rounds the capacity up to a power of two, at least 2.
+  explicit mpmc_queue(std::size_t capacity)
+      : mask_(detail::ring_capacity(capacity) - 1), cells_(new cell[mask_ + 1]) {
+    for (std::size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+  ~mpmc_queue() {
+    const std::size_t end = enqueue_pos_.load(std::memory_order_relaxed);
+    for (std::size_t i = dequeue_pos_.load(std::memory_order_relaxed); i != end; ++i) {
+      cells_[i & mask_].slot.get()->~T();
+    }
+  }
+  mpmc_queue(const mpmc_queue&) = delete;
+  mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+  // Only nothrow constructions; build the element first and push it otherwise.
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    static_assert(std::is_nothrow_constructible_v<T, Args&&...>,
+                  "mpmc_queue::try_emplace needs a noexcept constructor, try_push a constructed value instead");
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell& c = cells_[pos & mask_];
+      const std::size_t sequence = c.sequence.load(std::memory_order_acquire);
+      const auto lag = static_cast<std::intptr_t>(sequence - pos);
+      if (lag == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          ::new (static_cast<void*>(c.slot.bytes)) T(std::forward<Args>(args)...);
+          c.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lag < 0) {
+        return false; // the slot still holds the element from one lap ago
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+  bool try_push(T value) { return try_emplace(std::move(value)); }
+
+  bool try_pop(T& out) {
+    std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell& c = cells_[pos & mask_];
+      const std::size_t sequence = c.sequence.load(std::memory_order_acquire);
+      const auto lag = static_cast<std::intptr_t>(sequence - (pos + 1));
+      if (lag == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          T* p = c.slot.get();
+          out = std::move(*p);
+          p->~T();
+          c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lag < 0) {
+        return false; // not written yet
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+private:
+  const std::size_t mask_;
+  const std::unique_ptr<cell[]> cells_;
+
+  alignas(cache_line_size) std::atomic<std::size_t> enqueue_pos_{0};
+  alignas(cache_line_size) std::atomic<std::size_t> dequeue_pos_{0};
+};
+
+} // namespace cst
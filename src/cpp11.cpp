@@ -15,8 +15,36 @@ DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
 #include <array>
 #include <typeindex>
 #include <string> // std::stoi
+#include <string_view>
+#include <cstdlib> // std::strtol
+#include <cstdio> // std::snprintf
+#include <cstring> // std::memcpy
+#include <sstream>
+#include <charconv>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <random>
+#include <limits>
+#include <cstdint>
 DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
 
+#include "alloc_tracker.h"
+#include "bench.h"
+#include "flat_hash_map.h"
+#include "format_float.h"
+#include "lifecycle.h"
+#include "lookup_table.h"
+#include "parse_int.h"
+#include "simd.h"
+#include "small_vector.h"
+#include "soa_vector.h"
+#include "thread_pool.h"
+
 
 
 template <typename T>
@@ -33,6 +61,21 @@ TEST_CASE("Move semantics && std::move") {
         CHECK(vec1.size() == 4);
     }
 
+    SUBCASE("no hidden copies") {
+        std::vector<cst::instrumented> vec;
+        vec.reserve(4);
+        for (int i = 0; i < 4; ++i) vec.emplace_back(i, 64); // 64 heap bytes each
+        cst::lifecycle_scope scope;
+        std::vector<cst::instrumented> copied = vec;
+        CHECK(scope.counts().copies() == 4);
+        CHECK(scope.counts().heap_bytes == 4 * 64);
+        scope.reset();
+        std::vector<cst::instrumented> moved = std::move(vec);
+        CHECK(scope.counts().copies() == 0);
+        CHECK(scope.counts().moves() == 0); // the buffer is stolen, elements are untouched
+        CHECK(scope.counts().heap_bytes == 0);
+    }
+
     SUBCASE("std::uniqure_ptr") {
         std::unique_ptr<int> p(new int(1));
         CHECK(*p == 1);
@@ -43,6 +86,31 @@ TEST_CASE("Move semantics && std::move") {
     }
 }
 
+BENCH_CASE("Move semantics && std::move") {
+    for (std::size_t n : {16, 1024, 65536}) {
+        std::vector<int> src(n, 1);
+        bench.bytes(n * sizeof(int)).run("copy vector<int>(" + std::to_string(n) + ")", [&] {
+            std::vector<int> dst = src;
+            cst::bench::do_not_optimize(dst);
+        });
+        bench.bytes(0).run("move vector<int>(" + std::to_string(n) + ") there and back", [&] {
+            std::vector<int> dst = std::move(src);
+            cst::bench::do_not_optimize(dst);
+            src = std::move(dst);
+        });
+    }
+    std::string s(64, 'x'); // longer than the SSO buffer
+    bench.run("copy std::string(64)", [&] {
+        std::string dst = s;
+        cst::bench::do_not_optimize(dst);
+    });
+    bench.run("move std::string(64) there and back", [&] {
+        std::string dst = std::move(s);
+        cst::bench::do_not_optimize(dst);
+        s = std::move(dst);
+    });
+}
+
 TEST_CASE("Rvalue references") {
     int x = 0; // `x` is an lvalue of type `int`
     int& xl = x; // `xl` is an lvalue of type `int&`
@@ -129,7 +197,11 @@ struct arity {
 template <typename First, typename... Args>
 auto sum(const First first, const Args... args) -> decltype(first) {
   const auto values = {first, args...}; // 这里保证了first和args类型一致，否则编译报错，所以decltype(first)也是ok的
-  return std::accumulate(values.begin(), values.end(), First{0}); // TODO:First{0}初始化方式只能针对数字?
+  if constexpr (cst::simd::is_supported_v<First>) {
+    return cst::simd::sum(cst::span<const First>(values.begin(), values.size()));
+  } else {
+    return std::accumulate(values.begin(), values.end(), First{0}); // TODO:First{0}初始化方式只能针对数字?
+  }
 }
 
 TEST_CASE("Variadic templates") {
@@ -149,12 +221,7 @@ TEST_CASE("Variadic templates") {
 }
 
 int sum(const std::initializer_list<int>& list) {
-  int total = 0;
-  for (auto& e : list) {
-    total += e;
-  }
-
-  return total;
+  return cst::simd::sum(cst::span<const int>(list.begin(), list.size()));
 }
 TEST_CASE("Initializer lists") {
     auto list = {1, 2, 3};
@@ -190,6 +257,7 @@ TEST_CASE("auto") {
         CHECK(is_same_type<int&>(f));
         auto g = new auto(123); // int*
         CHECK(is_same_type<int*>(g));
+        delete g;
         const auto h = 1; // const int
         CHECK(is_same_type<int const>(h));
         auto i = 1, j = 2, k = 3; // int, int, int
@@ -288,6 +356,118 @@ TEST_CASE("Type aliases") {
     CHECK(is_same_type<String, std::string>());    
 }
 
+template <typename T>
+using SmallVec = cst::small_vector<T, 8>; // the first 8 elements need no allocation
+TEST_CASE("Small-buffer vectors") {
+    SUBCASE("inline until N") {
+        SmallVec<int> v {1, 2, 3};
+        CHECK(v.is_inline());
+        CHECK(v.size() == 3);
+        for (int i = 4; i <= 8; ++i) v.push_back(i);
+        CHECK(v.is_inline());
+        v.push_back(9);
+        CHECK_FALSE(v.is_inline());
+        CHECK(v.capacity() == 16);
+        CHECK(v == SmallVec<int>{1, 2, 3, 4, 5, 6, 7, 8, 9});
+        v.erase(v.begin() + 2, v.end());
+        v.shrink_to_fit();
+        CHECK(v.is_inline());
+        CHECK(v == SmallVec<int>{1, 2});
+    }
+
+    SUBCASE("vector interface") {
+        SmallVec<std::string> v(3, "x");
+        v.insert(v.begin() + 1, {"a", "b"});
+        v.emplace(v.begin(), 2, 'y');
+        CHECK(std::vector<std::string>(v.begin(), v.end()) ==
+              std::vector<std::string>{"yy", "x", "a", "b", "x", "x"});
+        v.insert(v.end(), v.begin(), v.end()); // the range is part of the vector and reallocates
+        CHECK(v.size() == 12);
+        CHECK(v[6] == "yy");
+        v.push_back(v.front()); // so is the pushed element
+        CHECK(v.back() == "yy");
+        v.resize(2);
+        CHECK(v == SmallVec<std::string>{"yy", "x"});
+        v.pop_back();
+        CHECK(v.at(0) == "yy");
+        CHECK_THROWS_AS(v.at(1), std::out_of_range);
+        CHECK(SmallVec<int>{1, 2} < SmallVec<int>{1, 3});
+    }
+
+    SUBCASE("moves") {
+        static_assert(std::is_nothrow_move_constructible_v<SmallVec<int>>);
+        static_assert(std::is_nothrow_move_assignable_v<SmallVec<std::string>>);
+        static_assert(!std::is_nothrow_move_constructible_v<SmallVec<cst::throwing_move_instrumented>>);
+
+        cst::small_vector<cst::instrumented, 2> inline_v;
+        inline_v.emplace_back(1, 64);
+        cst::lifecycle_scope scope;
+        auto moved = std::move(inline_v); // inline elements move one by one
+        CHECK(scope.counts().move_constructions == 1);
+        CHECK(scope.counts().copies() == 0);
+        CHECK(inline_v.empty());
+
+        for (int i = 0; i < 3; ++i) moved.emplace_back(i, 0);
+        scope.reset();
+        auto stolen = std::move(moved); // a heap buffer is stolen, like std::vector
+        CHECK(scope.counts().moves() == 0);
+        CHECK(stolen.size() == 4);
+        CHECK(moved.is_inline());
+
+        cst::small_vector<cst::throwing_move_instrumented, 1> copied;
+        copied.emplace_back(1, 0);
+        scope.reset();
+        copied.emplace_back(2, 0); // leaving the inline buffer copies, a throwing move could lose elements
+        CHECK(scope.counts().copy_constructions == 1);
+        CHECK(scope.counts().moves() == 0);
+    }
+}
+
+BENCH_CASE("Small-buffer vectors") {
+    // Sizes below, at and beyond the inline capacity of 8.
+    for (std::size_t n : {4, 8, 16, 64}) {
+        const std::string size = "(" + std::to_string(n) + ")";
+        bench.items(n);
+        bench.run("std::vector push_back" + size, [&] {
+            std::vector<int> v;
+            for (std::size_t i = 0; i < n; ++i) v.push_back(static_cast<int>(i));
+            cst::bench::do_not_optimize(v);
+        });
+        bench.run("SmallVec push_back" + size, [&] {
+            SmallVec<int> v;
+            for (std::size_t i = 0; i < n; ++i) v.push_back(static_cast<int>(i));
+            cst::bench::do_not_optimize(v);
+        });
+        bench.run("std::vector push/pop" + size, [&] {
+            std::vector<int> v;
+            for (std::size_t i = 0; i < n; ++i) v.push_back(static_cast<int>(i));
+            while (!v.empty()) v.pop_back();
+            cst::bench::do_not_optimize(v);
+        });
+        bench.run("SmallVec push/pop" + size, [&] {
+            SmallVec<int> v;
+            for (std::size_t i = 0; i < n; ++i) v.push_back(static_cast<int>(i));
+            while (!v.empty()) v.pop_back();
+            cst::bench::do_not_optimize(v);
+        });
+
+        // Many short sequences: contiguous for SmallVec, one heap block each for std::vector.
+        std::vector<std::vector<int>> vectors(1000, std::vector<int>(n, 1));
+        std::vector<SmallVec<int>> small_vectors(1000, SmallVec<int>(n, 1));
+        bench.items(1000 * n);
+        bench.run("std::vector iterate 1000x" + size, [&] {
+            long sum = 0;
+            for (const auto& v : vectors) for (int x : v) sum += x;
+            cst::bench::do_not_optimize(sum);
+        });
+        bench.run("SmallVec iterate 1000x" + size, [&] {
+            long sum = 0;
+            for (const auto& v : small_vectors) for (int x : v) sum += x;
+            cst::bench::do_not_optimize(sum);
+        });
+    }
+}
+
 //https://www.sohu.com/a/339977072_216613
 std::string foo(int) { return "int"; }
 std::string foo(char*) { return "char*"; }
@@ -368,6 +548,17 @@ TEST_CASE("constexpr") {
     static_assert(square(2) == 4);
     //static_assert(square2(2) == 4); // 编译错误：non-constant condition for static assertion
 
+    // Every square of a byte, computed by the compiler; the program only indexes the array.
+    constexpr auto squares = cst::make_lookup_table<256>(square);
+    static_assert(squares(15) == 225);
+    static_assert(squares.size() == 256 && squares.last() == 255);
+    int i = 255;
+    CHECK(squares(i) == square(i));
+    CHECK(!squares.contains(256));
+    CHECK_THROWS_AS(squares.at(-1), std::out_of_range);
+    constexpr auto shifted = cst::make_lookup_table<3>([](long x) { return x * x; }, -1L); // keys -1, 0, 1
+    CHECK(shifted(-1) == 1);
+
     const int x = 123;
     //constexpr const int& y = x; // error -- constexpr variable `y` must be initialized by a constant expression
 
@@ -397,12 +588,55 @@ long long operator "" _celsius(unsigned long long tempCelsius) {
 }
 
 // `const char*` and `std::size_t` required as parameters.
-int operator "" _int(const char* str, std::size_t) {
-  return std::stoi(str);
+int operator "" _int(const char* str, std::size_t len) {
+  return cst::parse_int<int>(std::string_view(str, len));
 }
 TEST_CASE("User-defined literals") {
     CHECK(24_celsius == 75);
     CHECK("123"_int == 123);
+    CHECK("-2147483648"_int == std::numeric_limits<int>::min());
+    CHECK_THROWS_AS("12 apples"_int, std::invalid_argument); // std::stoi would return 12
+    CHECK_THROWS_AS("2147483648"_int, std::out_of_range);
+
+    // A literal operator template sees the characters of the literal and runs at compile time.
+    using namespace cst::literals;
+    static_assert(123_i == 123, "");
+    static_assert(0x7f_i == 127 && 0b1010_i == 10 && 017_i == 15 && 1'000'000_i == 1000000, "");
+    static_assert(std::is_same<decltype(2147483647_i), int>::value, "");
+    static_assert(sizeof(9'000'000'000_i) == 8, ""); // long or long long
+    // 18446744073709551616_i, 12.5_i: compile errors
+}
+
+// 10^7 (--bench-max-size) numbers of up to 10 digits, one string each.
+BENCH_CASE("User-defined literals") {
+  const std::size_t n = static_cast<std::size_t>(bench.max_size());
+  std::mt19937 rng{3};
+  std::vector<std::string> strings(n);
+  for (auto& s : strings) s = std::to_string(static_cast<std::int32_t>(rng()) >> (rng() % 31));
+  const std::vector<std::string_view> views(strings.begin(), strings.end());
+  std::vector<std::int32_t> values(n);
+  bench.items(n);
+  bench.run("std::stoi", [&] {
+    for (std::size_t i = 0; i < n; ++i) values[i] = std::stoi(strings[i]);
+    cst::bench::do_not_optimize(values.data());
+  });
+  bench.run("std::strtol", [&] {
+    for (std::size_t i = 0; i < n; ++i) values[i] = static_cast<std::int32_t>(std::strtol(strings[i].c_str(), nullptr, 10));
+    cst::bench::do_not_optimize(values.data());
+  });
+  bench.run("cst::parse_int", [&] {
+    for (std::size_t i = 0; i < n; ++i) values[i] = cst::parse_int<std::int32_t>(views[i]);
+    cst::bench::do_not_optimize(values.data());
+  });
+  for (auto level : {cst::simd::isa::scalar, cst::simd::isa::sse2, cst::simd::isa::avx2, cst::simd::isa::avx512}) {
+    if (level <= cst::simd::best_isa()) {
+      cst::simd::set_isa(level);
+      bench.run(std::string("parse_integers ") + cst::simd::to_string(level), [&] {
+        cst::bench::do_not_optimize(cst::simd::parse_integers(views, values));
+      });
+    }
+  }
+  cst::simd::set_isa(cst::simd::best_isa());
 }
 
 
@@ -504,11 +738,13 @@ TEST_CASE("Range-based for loops") {
 
 struct A6 {
   std::string s;
+  cst::instrumented probe; // counts the special member calls below
   A6() : s{"test"} {}
-  A6(const A6& o) : s{o.s} {}
-  A6(A6&& o) : s{std::move(o.s)} {}
+  A6(const A6& o) : s{o.s}, probe{o.probe} {}
+  A6(A6&& o) : s{std::move(o.s)}, probe{std::move(o.probe)} {}
   A6& operator=(A6&& o) {
    s = std::move(o.s);
+   probe = std::move(o.probe);
    return *this;
   }
 };
@@ -517,11 +753,25 @@ A6 f(A6 a) {
   return a;
 }
 TEST_CASE("Special member functions for move semantics") {
+    cst::lifecycle_scope scope;
     A6 a1 = f(A6{}); // move-constructed from rvalue temporary
+    CHECK(scope.counts().constructions == 1); // A6{} initializes the parameter directly
+    CHECK(scope.counts().move_constructions == 1); // returning the parameter moves it
+    scope.reset();
     A6 a2 = std::move(a1); // move-constructed using std::move
+    CHECK(scope.counts().move_constructions == 1);
+    scope.reset();
     A6 a3 = A6{};
+    CHECK(scope.counts().moves() == 0); // guaranteed copy elision
+    scope.reset();
     a2 = std::move(a3); // move-assignment using std::move
+    CHECK(scope.counts().move_assignments == 1);
+    scope.reset();
     a1 = f(A6{}); // move-assignment from rvalue temporary
+    CHECK(scope.counts().move_constructions == 1);
+    CHECK(scope.counts().move_assignments == 1);
+    CHECK(scope.counts().destructions == 2); // the parameter and the returned temporary
+    CHECK_NO_COPIES(a1 = f(A6{}));
 }
 
 struct A7 {
@@ -621,6 +871,7 @@ TEST_CASE("Right angle brackets") {
 struct Bar {
   // ...
   int x;
+  cst::instrumented probe;
 };
 
 struct Foo2 {
@@ -634,14 +885,21 @@ struct Foo2 {
 TEST_CASE("Ref-qualified member functions") {
   Foo2 foo{};
   Bar bar = foo.getBar(); // calls `Bar getBar() &`
+  CHECK_COPIES(1, foo.getBar());
+  CHECK_MOVES(0, foo.getBar());
 
   const Foo2 foo2{};
   Bar bar2 = foo2.getBar(); // calls `Bar Foo::getBar() const&`
+  CHECK_COPIES(1, foo2.getBar());
 
   Foo2{}.getBar(); // calls `Bar Foo::getBar() &&`
+  CHECK_NO_COPIES(Foo2{}.getBar());
+  CHECK_MOVES(1, Foo2{}.getBar());
   std::move(foo).getBar(); // calls `Bar Foo::getBar() &&`
+  CHECK_NO_COPIES(std::move(foo).getBar());
 
   std::move(foo2).getBar(); // calls `Bar Foo::getBar() const&&`
+  CHECK_COPIES(1, std::move(foo2).getBar()); // a const rvalue cannot be moved from
 }
 
 
@@ -684,8 +942,99 @@ void g() noexcept {
     func4();          // valid, even if f throws
     throw 42;     // valid, effectively a call to std::terminate
 }
+// A6 with noexcept moves.
+struct A11 {
+  std::string s;
+  cst::instrumented probe;
+  A11() : s{"test"} {}
+  A11(const A11& o) : s{o.s}, probe{o.probe} {}
+  A11(A11&& o) noexcept : s{std::move(o.s)}, probe{std::move(o.probe)} {}
+  A11& operator=(A11&& o) noexcept {
+   s = std::move(o.s);
+   probe = std::move(o.probe);
+   return *this;
+  }
+};
+CST_ASSERT_NOTHROW_MOVE(A11);
+//CST_ASSERT_NOTHROW_MOVE(A6); // error -- A6 has a move constructor that may throw, containers will copy it instead
+
+// Copies made while growing a container to n elements one push_back at a time.
+template <typename Container>
+long growth_copies(std::size_t n) {
+  Container c;
+  cst::lifecycle_scope scope;
+  for (std::size_t i = 0; i < n; ++i) {
+    c.emplace_back();
+  }
+  return scope.counts().copies();
+}
+
 TEST_CASE("Noexcept specifier") {
   //g();  //std::terminate
+  static_assert(noexcept(func1()));
+  static_assert(!noexcept(func4()));
+
+  SUBCASE("move_if_noexcept audit") {
+    static_assert(cst::move_falls_back_to_copy_v<A6>); // A6(A6&&) is not noexcept
+    static_assert(!cst::move_falls_back_to_copy_v<A11>);
+    static_assert(cst::move_falls_back_to_copy_v<cst::throwing_move_instrumented>);
+    static_assert(!cst::move_falls_back_to_copy_v<std::string>);
+    static_assert(!cst::move_falls_back_to_copy_v<std::unique_ptr<int>>); // move-only, nothing to fall back to
+    static_assert(cst::any_move_falls_back_to_copy_v<int, A11, A6>);
+  }
+  SUBCASE("vector growth") {
+    // Every reallocation copies all existing A6 elements, A11 elements are moved.
+    CHECK(growth_copies<std::vector<A6>>(1000) >= 1000);
+    CHECK(growth_copies<std::vector<A11>>(1000) == 0);
+    CHECK(growth_copies<std::vector<cst::throwing_move_instrumented>>(1000) >= 1000);
+    CHECK(growth_copies<std::vector<cst::instrumented>>(1000) == 0);
+  }
+  SUBCASE("deque growth") {
+    // std::deque never relocates its elements.
+    CHECK(growth_copies<std::deque<A6>>(1000) == 0);
+    CHECK(growth_copies<std::deque<A11>>(1000) == 0);
+  }
+}
+
+template <typename Container>
+void bench_growth(cst::bench::Bench& bench, const std::string& name, std::size_t n, std::size_t payload) {
+  bench.items(n).run(name + " n=" + std::to_string(n), [&] {
+    Container c;
+    for (std::size_t i = 0; i < n; ++i) {
+      c.emplace_back(static_cast<int>(i), payload);
+    }
+    cst::bench::do_not_optimize(c);
+  });
+  Container c;
+  cst::lifecycle_scope scope;
+  for (std::size_t i = 0; i < n; ++i) {
+    c.emplace_back(static_cast<int>(i), payload);
+  }
+  bench.counter("copies/element", static_cast<double>(scope.counts().copies()) / n);
+}
+
+BENCH_CASE("Noexcept specifier") {
+  constexpr std::size_t payload = 48; // heap bytes per element, like a std::string past SSO
+  for (std::size_t n : {1000, 100000}) {
+    bench_growth<std::vector<cst::throwing_move_instrumented>>(bench, "vector, throwing move", n, payload);
+    bench_growth<std::vector<cst::instrumented>>(bench, "vector, noexcept move", n, payload);
+    bench_growth<std::deque<cst::throwing_move_instrumented>>(bench, "deque, throwing move", n, payload);
+    bench_growth<std::deque<cst::instrumented>>(bench, "deque, noexcept move", n, payload);
+  }
+  for (std::size_t n : {1000, 100000}) {
+    bench.items(n).run("vector<A6> push_back n=" + std::to_string(n), [&] {
+      std::vector<A6> v;
+      for (std::size_t i = 0; i < n; ++i) v.emplace_back();
+      cst::bench::do_not_optimize(v);
+    });
+    bench.counter("copies/element", static_cast<double>(growth_copies<std::vector<A6>>(n)) / n);
+    bench.items(n).run("vector<A11> push_back n=" + std::to_string(n), [&] {
+      std::vector<A11> v;
+      for (std::size_t i = 0; i < n; ++i) v.emplace_back();
+      cst::bench::do_not_optimize(v);
+    });
+    bench.counter("copies/element", static_cast<double>(growth_copies<std::vector<A11>>(n)) / n);
+  }
 }
 
 
@@ -696,18 +1045,22 @@ T&& my_forward(typename std::remove_reference<T>::type& arg) {
 
 struct A10 {
   A10() = default;
-  A10(const A10& o) { std::cout << "copied" << std::endl; }
-  A10(A10&& o) { std::cout << "moved" << std::endl; }
+  A10(const A10& o) : probe{o.probe} {} // copied
+  A10(A10&& o) : probe{std::move(o.probe)} {} // moved
+  cst::instrumented probe;
 };
 template <typename T>
 A10 wrapper(T&& arg) {
   return A10{std::forward<T>(arg)}; // std::move和std::forward的区别是move总是返回右值引用，而forward根据输入，只有输入是又值才返回右值引用
 }
 TEST_CASE("std::forward") {
-  wrapper(A10{}); // moved
+  CHECK_NO_COPIES(wrapper(A10{})); // moved
+  CHECK_MOVES(1, wrapper(A10{}));
   A10 a;
-  wrapper(a); // copied
-  wrapper(std::move(a)); // moved
+  CHECK_COPIES(1, wrapper(a)); // copied
+  CHECK_MOVES(0, wrapper(a));
+  CHECK_NO_COPIES(wrapper(std::move(a))); // moved
+  CHECK_MOVES(1, wrapper(std::move(a)));
 }
 
 // emplace_back: https://blog.csdn.net/p942005405/article/details/84764104
@@ -724,10 +1077,190 @@ TEST_CASE("std::thread") {
   }
 }
 
+// One OS thread per task is expensive; a pool reuses its workers instead.
+TEST_CASE("thread_pool") {
+  cst::thread_pool pool(4);
+  CHECK(pool.size() == 4);
+
+  SUBCASE("submit") {
+    auto f1 = pool.submit([] { return 42; });
+    auto f2 = pool.submit([] { thread_fun(true); });
+    CHECK(f1.get() == 42);
+    f2.get();
+    auto f3 = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+    CHECK_THROWS_AS(f3.get(), std::runtime_error);
+  }
+  SUBCASE("submit from inside a job") {
+    std::atomic<int> count{0};
+    std::mutex mx;
+    std::vector<std::future<void>> inner, outer;
+    for (int i = 0; i < 8; ++i) {
+      outer.push_back(pool.submit([&] {
+        for (int j = 0; j < 100; ++j) {
+          auto f = pool.submit([&] { count.fetch_add(1); }); // lands in this worker's deque, others may steal it
+          std::lock_guard<std::mutex> lk(mx);
+          inner.push_back(std::move(f));
+        }
+      }));
+    }
+    for (auto& f : outer) f.get();
+    for (auto& f : inner) f.get();
+    CHECK(count == 800);
+  }
+  SUBCASE("parallel_for") {
+    std::vector<int> v(100000, 1);
+    pool.parallel_for(0, v.size(), [&](std::size_t i) { v[i] += static_cast<int>(i % 3); });
+    CHECK(std::accumulate(v.begin(), v.end(), 0LL) == 100000 + 99999);
+    // Nested fork/join inside pool jobs must not deadlock.
+    std::atomic<int> total{0};
+    pool.parallel_for(0, 16, [&](std::size_t) {
+      pool.parallel_for(0, 100, [&](std::size_t) { total.fetch_add(1); }, 1);
+    }, 1);
+    CHECK(total == 1600);
+  }
+  SUBCASE("exceptions") {
+    CHECK_THROWS_AS(pool.parallel_for(0, 100, [](std::size_t i) {
+      if (i == 42) throw std::out_of_range("42");
+    }), std::out_of_range);
+  }
+}
+
+// 10^5 tiny tasks like async_task: a fresh OS thread per task vs the pool.
+int async_task();
+BENCH_CASE("thread_pool") {
+  constexpr int tasks = 100000;
+  constexpr int wave = 256; // keeps the number of live threads bounded
+  auto& pool = cst::thread_pool::shared();
+
+  // Latency: spawn one task and wait for it.
+  bench.run("std::thread spawn+join", [] {
+    int r = 0;
+    std::thread t([&r] { r = async_task(); });
+    t.join();
+    cst::bench::do_not_optimize(r);
+  });
+  bench.run("std::async spawn+get", [] {
+    cst::bench::do_not_optimize(std::async(std::launch::async, async_task).get());
+  });
+  bench.run("thread_pool submit+get", [&] {
+    cst::bench::do_not_optimize(pool.submit(async_task).get());
+  });
+
+  // Throughput: 10^5 tasks in flight as far as each approach allows.
+  bench.items(tasks);
+  bench.run("std::thread x 10^5 (waves of 256)", [] {
+    std::vector<std::thread> threads;
+    threads.reserve(wave);
+    for (int done = 0; done < tasks; done += wave) {
+      for (int i = 0; i < wave; ++i) threads.emplace_back(async_task);
+      for (auto& t : threads) t.join();
+      threads.clear();
+    }
+  });
+  bench.run("std::async x 10^5 (waves of 256)", [] {
+    std::vector<std::future<int>> futures;
+    futures.reserve(wave);
+    for (int done = 0; done < tasks; done += wave) {
+      for (int i = 0; i < wave; ++i) futures.push_back(std::async(std::launch::async, async_task));
+      for (auto& f : futures) cst::bench::do_not_optimize(f.get());
+      futures.clear();
+    }
+  });
+  bench.run("thread_pool submit x 10^5", [&] {
+    std::vector<std::future<int>> futures;
+    futures.reserve(tasks);
+    for (int i = 0; i < tasks; ++i) futures.push_back(pool.submit(async_task));
+    for (auto& f : futures) cst::bench::do_not_optimize(f.get());
+  });
+  bench.run("thread_pool parallel_for x 10^5", [&] {
+    std::atomic<int> sum{0};
+    pool.parallel_for(0, tasks, [&](std::size_t) { sum.fetch_add(async_task(), std::memory_order_relaxed); });
+    cst::bench::do_not_optimize(sum);
+  });
+}
+
 
 TEST_CASE("std::to_string") {
   CHECK(std::to_string(1.2) == "1.200000"); // == "1.2"  有精度问题
   CHECK(std::to_string(123) == "123"); // == "123"
+
+  // The shortest string that reads back as the same double, into a stack buffer.
+  char buf[cst::max_float_chars<double>];
+  CHECK(cst::format_float(1.2, buf) == "1.2");
+  CHECK(cst::format_float(0.1 + 0.2, buf) == "0.30000000000000004");
+  CHECK(cst::format_float(1e21, buf) == "1e+21");
+  CHECK(cst::format_float(-0.0, buf) == "-0");
+  CHECK(cst::format_float(1.0f / 3, buf) == "0.33333334");
+  CHECK(cst::format_float(std::numeric_limits<double>::infinity(), buf) == "inf");
+  CHECK(cst::format_float(-std::numeric_limits<double>::denorm_min(), buf) == "-5e-324");
+
+  std::mt19937_64 rng{7};
+  std::vector<double> values(1000);
+  for (auto& v : values) {
+    const std::uint64_t bits = rng();
+    std::memcpy(&v, &bits, sizeof(v)); // any bit pattern, including NaN and subnormals
+  }
+  values[0] = -std::numeric_limits<double>::max();
+  values[1] = std::numeric_limits<double>::min();
+  std::string csv = "values:";
+  cst::append_floats(values, csv, ',');
+  std::size_t i = 0;
+  for (std::size_t pos = 7; pos <= csv.size(); ++i) {
+    const std::size_t end = std::min(csv.find(',', pos), csv.size());
+    double parsed = 0;
+#if defined(__cpp_lib_to_chars)
+    CHECK(std::from_chars(csv.data() + pos, csv.data() + end, parsed).ptr == csv.data() + end);
+#else
+    const std::string field = csv.substr(pos, end - pos);
+    char* stop = nullptr;
+    parsed = std::strtod(field.c_str(), &stop);
+    CHECK(stop == field.c_str() + field.size());
+#endif
+    CHECK((parsed == values[i] || (parsed != parsed && values[i] != values[i])));
+    CHECK(std::signbit(parsed) == std::signbit(values[i]));
+    pos = end + 1;
+  }
+  CHECK(i == values.size());
+}
+
+// 10^6 doubles of mixed magnitudes, one string each or one buffer for all of them.
+BENCH_CASE("std::to_string") {
+  const std::size_t n = static_cast<std::size_t>(bench.max_size() / 10);
+  std::mt19937_64 rng{7};
+  std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+  std::uniform_int_distribution<int> exponent(-30, 30);
+  std::vector<double> values(n);
+  for (auto& v : values) v = std::ldexp(mantissa(rng), exponent(rng));
+  bench.items(n);
+  bench.run("std::to_string", [&] {
+    std::size_t chars = 0;
+    for (double v : values) chars += std::to_string(v).size();
+    cst::bench::do_not_optimize(chars);
+  });
+  bench.run("snprintf %.17g", [&] {
+    char buf[32];
+    std::size_t chars = 0;
+    for (double v : values) chars += static_cast<std::size_t>(std::snprintf(buf, sizeof(buf), "%.17g", v));
+    cst::bench::do_not_optimize(chars);
+  });
+  bench.run("ostringstream precision 17", [&] {
+    std::ostringstream out;
+    out.precision(17);
+    for (double v : values) out << v << ',';
+    cst::bench::do_not_optimize(out.tellp());
+  });
+  bench.run("cst::format_float", [&] {
+    char buf[cst::max_float_chars<double>];
+    std::size_t chars = 0;
+    for (double v : values) chars += cst::format_float(v, buf).size();
+    cst::bench::do_not_optimize(chars);
+  });
+  std::string out;
+  bench.run("cst::append_floats", [&] {
+    out.clear();
+    cst::append_floats(values, out, ',');
+    cst::bench::do_not_optimize(out.data());
+  });
 }
 
 
@@ -741,6 +1274,7 @@ TEST_CASE("Type traits") {
 
 TEST_CASE("Smart pointers") {
   SUBCASE("unique_ptr") {
+    ALLOCATION_BUDGET(1);  // moving ownership around never allocates
     std::unique_ptr<Foo> p1 {new Foo{}};  // `p1` owns `Foo`
     if (p1) {
       p1->bar();
@@ -761,6 +1295,7 @@ TEST_CASE("Smart pointers") {
     // `Foo` instance is destroyed when `p1` goes out of scope    
   }
   SUBCASE("shared_ptr") {
+    ALLOCATION_BUDGET(2);  // the int and the control block, std::make_shared would need 1
     std::shared_ptr<int> p1 {new int{}};
     // Perhaps these take place in another threads?
     // foo(p1);
@@ -810,6 +1345,85 @@ TEST_CASE("Tuples") {
   CHECK(t2 == "Frans Nielsen");
   CHECK(t3 == "NYI");
 
+  // Many records, stored column by column.
+  cst::soa_vector<std::tuple<int, std::string, std::string>> players {{51, "Frans Nielsen", "NYI"}};
+  players.push_back(playerProfile);
+  players.emplace_back(91, "John Tavares", "NYI");
+  players.push_back({13, "Mathew Barzal", "NYI"});
+  CHECK(players.size() == 4);
+  cst::span<int> numbers = cst::get<0>(players);
+  CHECK(std::accumulate(numbers.begin(), numbers.end(), 0) == 51 + 51 + 91 + 13);
+
+  auto [number, name, team] = players[2]; // references into the columns
+  number = 92;
+  CHECK(cst::get<0>(players)[2] == 92);
+  CHECK(name == "John Tavares");
+  std::tie(t1, std::ignore, t3) = players.back();
+  CHECK(t1 == 13);
+  CHECK(t3 == "NYI");
+  players[0] = std::make_tuple(27, "Anders Lee", "NYI");
+  CHECK(std::get<1>(players.front()) == "Anders Lee");
+
+  players.erase(players.begin() + 1);
+  CHECK(players.size() == 3);
+  int total = 0;
+  for (auto [n, player, club] : players) total += n;
+  CHECK(total == 27 + 92 + 13);
+  CHECK(cst::get<1>(players)[1] == "John Tavares");
+  CHECK_THROWS_AS(players.at(3), std::out_of_range);
+
+  // A field that fails to construct takes the rest of its row with it.
+  struct positive {
+    explicit positive(int v) : value(v) { if (v < 0) throw std::invalid_argument("negative"); }
+    int value;
+  };
+  cst::soa_vector<std::tuple<std::string, positive>> rows;
+  CHECK_THROWS_AS(rows.emplace_back("first", -1), std::invalid_argument);
+  CHECK(rows.empty());
+  CHECK(cst::get<0>(rows).empty());
+}
+
+// The same records as an array of tuples and as one array per field.
+BENCH_CASE("Tuples") {
+  const std::size_t n = bench.max_size() / 10;
+  std::vector<std::tuple<int, double, std::string>> rows;
+  cst::soa_vector<std::tuple<int, double, std::string>> columns;
+  auto fill = [n](auto& records) {
+    for (std::size_t i = 0; i < n; ++i) {
+      records.emplace_back(static_cast<int>(i % 100), 0.5 * static_cast<double>(i), "player " + std::to_string(i % 1000));
+    }
+  };
+  bench.items(static_cast<double>(n));
+  bench.run("push_back, std::vector<std::tuple>", [&] {
+    rows.clear();
+    rows.shrink_to_fit();
+    fill(rows);
+  });
+  bench.run("push_back, soa_vector", [&] {
+    columns = {};
+    fill(columns);
+  });
+
+  bench.run("column scan, std::vector<std::tuple>", [&] {
+    long long sum = 0;
+    for (const auto& row : rows) sum += std::get<0>(row);
+    cst::bench::do_not_optimize(sum);
+  });
+  bench.run("column scan, soa_vector", [&] {
+    long long sum = 0;
+    for (int x : cst::get<0>(columns)) sum += x;
+    cst::bench::do_not_optimize(sum);
+  });
+  bench.run("row iteration, std::vector<std::tuple>", [&] {
+    double sum = 0;
+    for (const auto& [number, score, name] : rows) sum += number + score + static_cast<double>(name.size());
+    cst::bench::do_not_optimize(sum);
+  });
+  bench.run("row iteration, soa_vector", [&] {
+    double sum = 0;
+    for (const auto& [number, score, name] : columns) sum += number + score + static_cast<double>(name.size());
+    cst::bench::do_not_optimize(sum);
+  });
 }
 
 
@@ -839,8 +1453,117 @@ TEST_CASE("std::array") {
 // unordered_map
 // unordered_multimap
 TEST_CASE("Unordered containers") {
+  SUBCASE("std") {
+    std::unordered_set<int> s {1, 2, 2, 3};
+    CHECK(s.size() == 3);
+    std::unordered_multiset<int> ms {1, 2, 2, 3};
+    CHECK(ms.count(2) == 2);
+    std::unordered_map<std::string, int> m {{"a", 1}, {"b", 2}};
+    m["c"] = 3;
+    CHECK(m.at("c") == 3);
+    std::unordered_multimap<std::string, int> mm {{"a", 1}, {"a", 2}};
+    CHECK(mm.count("a") == 2);
+  }
+  SUBCASE("cst::flat_hash_map") {
+    // Same interface, but the elements live in one flat array probed 16 slots at a time.
+    cst::flat_hash_map<std::string, int> m {{"a", 1}, {"b", 2}};
+    m["c"] = 3;
+    CHECK(m.size() == 3);
+    CHECK(m.at("c") == 3);
+    CHECK(m.contains("a"));
+    CHECK(m.count("z") == 0);
+    CHECK(m.find("z") == m.end());
+    CHECK_THROWS_AS(m.at("z"), std::out_of_range);
+    CHECK(m.insert({"a", 10}).second == false);
+    CHECK(m.try_emplace("d", 4).second);
+    m.insert_or_assign("a", 10);
+    CHECK(m["a"] == 10);
+    int sum = 0;
+    for (const auto& [key, value] : m) { // structured bindings work like with std::unordered_map
+      sum += value;
+    }
+    CHECK(sum == 10 + 2 + 3 + 4);
+    CHECK(m.erase("b") == 1);
+    CHECK(m.erase("b") == 0);
+    CHECK(m.size() == 3);
+    auto copy = m;
+    CHECK(copy == m);
+    m.clear();
+    CHECK(m.empty());
+    CHECK(copy.size() == 3);
+  }
+  SUBCASE("cst::flat_hash_map against std::unordered_map") {
+    cst::flat_hash_map<std::uint64_t, std::uint64_t> flat;
+    std::unordered_map<std::uint64_t, std::uint64_t> node;
+    std::mt19937_64 rng{7};
+    for (int i = 0; i < 200000; ++i) {
+      std::uint64_t key = rng() % 50000; // plenty of updates and erases of the same keys
+      switch (rng() % 3) {
+        case 0:
+          flat[key] = i;
+          node[key] = i;
+          break;
+        case 1:
+          REQUIRE(flat.erase(key) == node.erase(key));
+          break;
+        default:
+          auto it = flat.find(key);
+          auto nit = node.find(key);
+          REQUIRE((it == flat.end()) == (nit == node.end()));
+          if (nit != node.end()) REQUIRE(it->second == nit->second);
+      }
+    }
+    CHECK(flat.size() == node.size());
+    std::size_t visited = 0;
+    for (auto it = flat.begin(); it != flat.end();) {
+      CHECK(node.at(it->first) == it->second);
+      ++visited;
+      it = (it->first % 2 == 0) ? flat.erase(it) : std::next(it);
+    }
+    CHECK(visited == node.size());
+    for (const auto& [key, value] : flat) CHECK(key % 2 == 1);
+  }
+}
 
-
+// Insert, hit/miss lookup and erase over 10^3..min(10^8, --bench-max-size) random keys.
+BENCH_CASE("Unordered containers") {
+  for (std::uint64_t n = 1000; n <= std::min<std::uint64_t>(100000000, bench.max_size()); n *= 10) {
+    std::mt19937_64 rng{n};
+    std::vector<std::uint64_t> keys(n), misses(n);
+    for (auto& k : keys) k = rng() | 1;
+    for (auto& k : misses) k = rng() & ~std::uint64_t{1}; // even keys are never inserted
+    std::vector<std::uint64_t> shuffled = keys;
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+    const std::string size = " n=" + std::to_string(n);
+
+    auto run = [&](auto map, const std::string& name) {
+      bench.items(n);
+      bench.run(name + " insert" + size, [&] {
+        decltype(map) m;
+        for (auto k : keys) m.emplace(k, k);
+        cst::bench::do_not_optimize(m);
+      });
+      for (auto k : keys) map.emplace(k, k);
+      bench.run(name + " lookup hit" + size, [&] {
+        std::uint64_t sum = 0;
+        for (auto k : shuffled) sum += map.find(k)->second;
+        cst::bench::do_not_optimize(sum);
+      });
+      bench.run(name + " lookup miss" + size, [&] {
+        std::size_t found = 0;
+        for (auto k : misses) found += map.count(k);
+        cst::bench::do_not_optimize(found);
+      });
+      bench.items(2 * n).run(name + " insert + erase all" + size, [&] {
+        decltype(map) m;
+        for (auto k : keys) m.emplace(k, k);
+        for (auto k : shuffled) m.erase(k);
+        cst::bench::do_not_optimize(m);
+      });
+    };
+    run(std::unordered_map<std::uint64_t, std::uint64_t>{}, "std::unordered_map");
+    run(cst::flat_hash_map<std::uint64_t, std::uint64_t>{}, "cst::flat_hash_map");
+  }
 }
 
 
@@ -877,13 +1600,42 @@ TEST_CASE("Memory model") {
   auto handle = std::async(std::launch::async, async_task);  // create an async task
   auto result = handle.get();  // wait for the result
   CHECK(result == 1000);
+
+  auto pooled = cst::thread_pool::shared().submit(async_task); // reuses a worker instead of creating a thread
+  CHECK(pooled.get() == 1000);
+}
+
+BENCH_CASE("Memory model") {
+  bench.run("direct call", [] {
+    cst::bench::do_not_optimize(async_task());
+  });
+  bench.run("std::async(std::launch::deferred)", [] {
+    cst::bench::do_not_optimize(std::async(std::launch::deferred, async_task).get());
+  });
+  bench.run("std::async(std::launch::async)", [] {
+    cst::bench::do_not_optimize(std::async(std::launch::async, async_task).get());
+  });
+  bench.run("thread_pool::submit", [] {
+    cst::bench::do_not_optimize(cst::thread_pool::shared().submit(async_task).get());
+  });
 }
 
+// Contiguous ints, which the SIMD kernel can count.
+template <typename T, typename = void>
+struct is_contiguous_int : std::false_type {};
+template <typename T>
+struct is_contiguous_int<T, std::enable_if_t<std::is_same<decltype(std::data(std::declval<const T&>())), const int*>::value>>
+    : std::true_type {};
+
 template <typename T>
 int CountTwos(const T& container) {
-  return std::count_if(std::begin(container), std::end(container), [](int item) {
-    return item == 2;
-  });
+  if constexpr (is_contiguous_int<T>::value) {
+    return static_cast<int>(cst::simd::count_equal(cst::span<const int>(container), 2));
+  } else {
+    return std::count_if(std::begin(container), std::end(container), [](int item) {
+      return item == 2;
+    });
+  }
 }
 TEST_CASE("std::begin/end") {
   std::vector<int> vec = {2, 2, 43, 435, 4543, 534};
@@ -892,4 +1644,147 @@ TEST_CASE("std::begin/end") {
   auto b = CountTwos(arr);  // 1
   CHECK(a == 2);
   CHECK(b == 1);
+  std::list<int> list(vec.begin(), vec.end());
+  std::vector<long> longs(vec.begin(), vec.end());
+  CHECK(CountTwos(list) == 2);
+  CHECK(CountTwos(longs) == 2);
+}
+
+// Runs `check` once per instruction set the CPU supports, then restores the default.
+template <typename F>
+void for_each_isa(F check) {
+  const auto best = cst::simd::best_isa();
+  for (auto level : {cst::simd::isa::scalar, cst::simd::isa::sse2, cst::simd::isa::avx2, cst::simd::isa::avx512}) {
+    if (level <= best) {
+      cst::simd::set_isa(level);
+      INFO("isa: " << cst::simd::to_string(level));
+      check();
+    }
+  }
+  cst::simd::set_isa(best);
+}
+
+template <typename T>
+void check_kernels_match_std(std::mt19937& rng) {
+  // Few distinct values so that count_equal has matches; sizes and offsets cover the
+  // vector bodies, the scalar tails and unaligned starts.
+  std::uniform_int_distribution<int> value(-20, 20);
+  std::vector<T> storage(1100);
+  for (auto& e : storage) e = static_cast<T>(value(rng));
+  for (int round = 0; round < 50; ++round) {
+    const std::size_t offset = rng() % 8;
+    const std::size_t n = rng() % (storage.size() - offset);
+    cst::span<const T> data(storage.data() + offset, n);
+    const T needle = static_cast<T>(value(rng));
+    for_each_isa([&] {
+      CHECK(cst::simd::count_equal(data, needle) == static_cast<std::size_t>(std::count(data.begin(), data.end(), needle)));
+      // The values are small integers, so even float sums are exact in any order.
+      CHECK(cst::simd::sum(data) == std::accumulate(data.begin(), data.end(), T{0}));
+      if (n != 0) {
+        CHECK(cst::simd::min(data) == *std::min_element(data.begin(), data.end()));
+        CHECK(cst::simd::max(data) == *std::max_element(data.begin(), data.end()));
+      }
+    });
+  }
+}
+
+TEST_CASE("SIMD kernels") {
+  std::mt19937 rng{42};
+  SUBCASE("match the standard algorithms") {
+    check_kernels_match_std<std::int32_t>(rng);
+    check_kernels_match_std<std::int64_t>(rng);
+    check_kernels_match_std<float>(rng);
+    check_kernels_match_std<double>(rng);
+  }
+  SUBCASE("edge values") {
+    std::vector<std::int64_t> big(37, std::numeric_limits<std::int64_t>::max());
+    big[30] = std::numeric_limits<std::int64_t>::min();
+    big[3] = -1;
+    std::vector<std::int32_t> wrap(100, std::numeric_limits<std::int32_t>::max());
+    std::vector<double> empty;
+    for_each_isa([&] {
+      auto r = cst::simd::minmax(big);
+      CHECK(r.min == std::numeric_limits<std::int64_t>::min());
+      CHECK(r.max == std::numeric_limits<std::int64_t>::max());
+      CHECK(cst::simd::count_equal(big, std::numeric_limits<std::int64_t>::max()) == 35);
+      CHECK(cst::simd::sum(wrap) == static_cast<std::int32_t>(100u * 0x7fffffffu)); // wraps
+      CHECK(cst::simd::sum(empty) == 0.0);
+      CHECK(cst::simd::minmax(empty).min == std::numeric_limits<double>::max());
+    });
+  }
+  SUBCASE("integer parsing") {
+    const std::vector<std::string_view> text = {"0", "-0", "7", "-2147483648", "2147483647", "0000000000000000000042",
+                                                "1234567890123456", "-999999999999999999", "9223372036854775807"};
+    std::vector<std::int64_t> wide(text.size());
+    std::vector<std::int32_t> narrow(text.size());
+    for_each_isa([&] {
+      REQUIRE(cst::simd::parse_integers(text, wide) == text.size());
+      CHECK(wide == std::vector<std::int64_t>{0, 0, 7, -2147483648LL, 2147483647, 42, 1234567890123456,
+                                              -999999999999999999, std::numeric_limits<std::int64_t>::max()});
+      CHECK(cst::simd::parse_integers(text, narrow) == 6); // 1234567890123456 is out of range
+      CHECK(narrow[3] == std::numeric_limits<std::int32_t>::min());
+      for (std::string_view bad : {"", "-", "+1", " 1", "1 ", "12a4", "0x10", "2147483648", "--1", "1/", "9:"}) {
+        const std::string_view one[] = {"5", bad};
+        CHECK_MESSAGE(cst::simd::parse_integers(one, narrow) == 1, bad);
+      }
+    });
+    std::uniform_int_distribution<std::int64_t> value(std::numeric_limits<std::int64_t>::min());
+    std::vector<std::string> strings(1000);
+    std::vector<std::int64_t> expected(strings.size());
+    for (std::size_t i = 0; i < strings.size(); ++i) {
+      expected[i] = value(rng) >> (i % 64);
+      strings[i] = std::to_string(expected[i]);
+    }
+    const std::vector<std::string_view> views(strings.begin(), strings.end());
+    std::vector<std::int64_t> parsed(views.size());
+    for_each_isa([&] {
+      CHECK(cst::simd::parse_integers(views, parsed) == views.size());
+      CHECK(parsed == expected);
+    });
+  }
+  SUBCASE("floating point sums") {
+    std::uniform_real_distribution<double> value(0.0, 1.0);
+    std::vector<double> data(10007);
+    for (auto& e : data) e = value(rng);
+    const double expected = std::accumulate(data.begin(), data.end(), 0.0);
+    for_each_isa([&] { CHECK(cst::simd::sum(data) == doctest::Approx(expected).epsilon(1e-12)); });
+  }
+}
+
+// Throughput of every kernel at every available instruction set, in L1 (4096 elements)
+// and in memory (--bench-max-size elements, default 10^7).
+template <typename T>
+void bench_kernels(cst::bench::Bench& bench, const char* type) {
+  for (std::uint64_t n : {std::uint64_t(4096), bench.max_size()}) {
+    std::vector<T> data(n);
+    std::mt19937 rng{1};
+    for (auto& e : data) e = static_cast<T>(rng() % 1000);
+    const std::string suffix = std::string(" ") + type + " n=" + std::to_string(n);
+    bench.bytes(n * sizeof(T));
+    for (auto level : {cst::simd::isa::scalar, cst::simd::isa::sse2, cst::simd::isa::avx2, cst::simd::isa::avx512}) {
+      if (level > cst::simd::best_isa()) {
+        continue;
+      }
+      cst::simd::set_isa(level);
+      const std::string name = std::string(cst::simd::to_string(level)) + suffix;
+      bench.run("count_equal " + name, [&] { cst::bench::do_not_optimize(cst::simd::count_equal(data, T(7))); });
+      bench.run("sum " + name, [&] { cst::bench::do_not_optimize(cst::simd::sum(data)); });
+      bench.run("minmax " + name, [&] { cst::bench::do_not_optimize(cst::simd::minmax(data)); });
+    }
+    cst::simd::set_isa(cst::simd::best_isa());
+    bench.run("std::count" + suffix, [&] { cst::bench::do_not_optimize(std::count(data.begin(), data.end(), T(7))); });
+    bench.run("std::accumulate" + suffix, [&] {
+      cst::bench::do_not_optimize(std::accumulate(data.begin(), data.end(), T(0)));
+    });
+    bench.run("std::minmax_element" + suffix, [&] {
+      cst::bench::do_not_optimize(std::minmax_element(data.begin(), data.end()));
+    });
+  }
+}
+
+BENCH_CASE("SIMD kernels") {
+  bench_kernels<std::int32_t>(bench, "int32");
+  bench_kernels<std::int64_t>(bench, "int64");
+  bench_kernels<float>(bench, "float");
+  bench_kernels<double>(bench, "double");
 }
\ No newline at end of file
@@ -6,8 +6,15 @@ DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
 #include <memory> // std::make_unique
 #include <chrono>
 #include <array>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
 DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
 
+#include "bench.h"
+#include "lookup_table.h"
+
 TEST_CASE("Binary literals") {
     CHECK(0b110 == 6); // == 6
     CHECK(0b1111'1111 == 255); // == 255
@@ -36,6 +43,7 @@ TEST_CASE("Lambda capture initializers") {
         auto a = generator(); // == 0
         auto b = generator(); // == 1
         auto c = generator(); // == 2  
+        // C++20 coroutines write this as a loop with co_yield, see cst::generator in cpp20.cpp.
     }
     SUBCASE("move") {
         auto p = std::make_unique<int>(1);
@@ -122,6 +130,61 @@ constexpr int factorial(int n) {
 }
 TEST_CASE("Relaxing constraints on constexpr functions") {
     static_assert(factorial(5) == 120); // == 120
+
+    // The loop runs in the compiler, once per entry; at run time n! is an array read.
+    static_assert(cst::factorial_table<std::int64_t>.size() == 21);
+    static_assert(cst::factorial<std::int64_t>(20) == 2432902008176640000);
+    int n = 12;
+    CHECK(cst::factorial(n) == factorial(n));
+    CHECK_THROWS_AS(cst::factorial(21), std::overflow_error);
+    CHECK_THROWS_AS(cst::factorial(-1), std::domain_error);
+#ifdef CST_HAS_INT128
+    static_assert(cst::factorial_table<cst::int128>.size() == 34);
+    const cst::int128 f33 = cst::factorial<cst::int128>(33);
+    CHECK(f33 / cst::factorial<cst::int128>(32) == 33);
+    CHECK(f33 % 10000000 == 0); // seven trailing zeros: 33 / 5 + 33 / 25
+    CHECK(f33 % 100000000 != 0);
+    CHECK_THROWS_AS(cst::factorial<cst::int128>(34), std::overflow_error);
+#endif
+}
+
+template <typename T>
+constexpr T recursive_factorial(int n) {
+  return n <= 1 ? 1 : n * recursive_factorial<T>(n - 1);
+}
+
+// n! for random n in [0, 20], where it fits int64 (up to 33 with int128). The results
+// are XORed, a sum of that many factorials would overflow.
+BENCH_CASE("Relaxing constraints on constexpr functions") {
+    std::mt19937 rng{3};
+    std::vector<int> n(100000);
+    std::uniform_int_distribution<int> upto20(0, 20);
+    for (int& x : n) x = upto20(rng);
+    bench.items(static_cast<double>(n.size()));
+    bench.run("recursive, int64", [&] {
+        std::int64_t mix = 0;
+        for (int x : n) mix ^= recursive_factorial<std::int64_t>(x);
+        cst::bench::do_not_optimize(mix);
+    });
+    bench.run("factorial_table<int64_t>", [&] {
+        std::int64_t mix = 0;
+        for (int x : n) mix ^= cst::factorial_table<std::int64_t>(x);
+        cst::bench::do_not_optimize(mix);
+    });
+#ifdef CST_HAS_INT128
+    std::uniform_int_distribution<int> upto33(0, 33);
+    for (int& x : n) x = upto33(rng);
+    bench.run("recursive, int128", [&] {
+        cst::int128 mix = 0;
+        for (int x : n) mix ^= recursive_factorial<cst::int128>(x);
+        cst::bench::do_not_optimize(mix);
+    });
+    bench.run("factorial_table<int128>", [&] {
+        cst::int128 mix = 0;
+        for (int x : n) mix ^= cst::factorial_table<cst::int128>(x);
+        cst::bench::do_not_optimize(mix);
+    });
+#endif
 }
 
 // https://blog.csdn.net/lanchunhui/article/details/49835213
@@ -5,17 +5,36 @@ DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
 #include <unordered_map> // std::unordered_map
 #include <variant> // std::variant
 #include <any> // std::any
+#include <array>
 #include <functional> // std::invoke
 //#include <filesystem> // gcc8.1.0编译不过
 #include <cstddef> // std::to_integer
 #include <map> // std::map
+#include <memory> // std::make_unique
 #include <string>
 #include <set>
 #include <algorithm>
 #include <optional>
+#include <vector>
+#include <numeric> // std::inclusive_scan
+#include <random>
+#include <sstream>
+#include <mutex>
+#include <thread>
+#include <chrono>
 //#include <execution> // std::execution::par 不支持
 DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
 
+#include "any.h"
+#include "bench.h"
+#include "concurrent_queue.h"
+#include "flat_map.h"
+#include "function.h"
+#include "memory_resource.h"
+#include "parallel.h" // cst::execution::par, runs without TBB
+#include "tokenizer.h"
+#include "visit.h"
+
 
 // Automatic template argument deduction much like how it's done for functions, but now including class constructors.
 template <typename T = float>
@@ -183,6 +202,15 @@ TEST_CASE("Structured bindings") {
   for (const auto& [key, value] : mapping) {
     // Do something with key and value
   }
+
+  // The same map with its nodes and keys in an arena instead of the global heap.
+  cst::pmr::arena_resource arena;
+  cst::pmr::unordered_map<std::pmr::string, int> arena_mapping({{"a", 1}, {"b", 2}, {"c", 3}}, 0, &arena);
+  int sum = 0;
+  for (const auto& [key, value] : arena_mapping) {
+    sum += value;
+  }
+  CHECK(sum == 6);
 }
 
 #if 0
@@ -207,8 +235,168 @@ switch (Foo gadget(args); auto s = gadget.status()) {
 }
 #endif
 TEST_CASE("Selection statements with initializer") {
+  std::mutex mx;
+  std::vector<int> v;
+  if (std::lock_guard<std::mutex> lk(mx); v.empty()) {
+    v.push_back(1);
+  }
+  CHECK(v.size() == 1);
+
+  // The lock-free queues report full and empty instead of blocking.
+  cst::spsc_queue<std::string> spsc(3); // rounded up to 4
+  CHECK(spsc.capacity() == 4);
+  for (int i = 0; i < 4; ++i) CHECK(spsc.try_push(std::string(40, char('a' + i))));
+  CHECK_FALSE(spsc.try_push("full"));
+  if (std::string s; spsc.try_pop(s)) {
+    CHECK(s == std::string(40, 'a'));
+  }
+  CHECK(spsc.size() == 3); // the destructor frees the rest
+
+  cst::mpmc_queue<std::unique_ptr<int>> mpmc(2);
+  CHECK(mpmc.try_push(std::make_unique<int>(1)));
+  CHECK(mpmc.try_emplace(new int(2)));
+  CHECK_FALSE(mpmc.try_push(std::make_unique<int>(3)));
+  if (std::unique_ptr<int> p; mpmc.try_pop(p)) {
+    CHECK(*p == 1);
+  }
 
-  
+  // Every element arrives exactly once, in order per producer.
+  constexpr int producers = 4, per_producer = 20000;
+  cst::mpmc_queue<int> q(64);
+  std::vector<std::thread> threads;
+  std::vector<long long> sums(producers);
+  std::atomic<bool> in_order{true};
+  for (int t = 0; t < producers; ++t) {
+    threads.emplace_back([&q, t] {
+      for (int i = 0; i < per_producer; ++i) {
+        while (!q.try_push(t * per_producer + i)) std::this_thread::yield();
+      }
+    });
+    threads.emplace_back([&, t] {
+      std::vector<int> last(producers, -1);
+      for (int i = 0; i < per_producer; ++i) {
+        int x;
+        while (!q.try_pop(x)) std::this_thread::yield();
+        if (x % per_producer <= last[x / per_producer]) in_order = false;
+        last[x / per_producer] = x % per_producer;
+        sums[t] += x;
+      }
+    });
+  }
+  for (auto& th : threads) th.join();
+  const long long n = producers * per_producer;
+  CHECK(std::accumulate(sums.begin(), sums.end(), 0LL) == n * (n - 1) / 2);
+  CHECK(in_order);
+
+  cst::spsc_queue<int> ring(16);
+  long long sum = 0;
+  std::thread consumer([&] {
+    for (int i = 0; i < 100000; ++i) {
+      int x;
+      while (!ring.try_pop(x)) std::this_thread::yield();
+      sum += x == i ? x : -1;
+    }
+  });
+  for (int i = 0; i < 100000; ++i) {
+    while (!ring.try_push(i)) std::this_thread::yield();
+  }
+  consumer.join();
+  CHECK(sum == 100000LL * 99999 / 2);
+}
+
+// Moves `messages` ints from `threads` producers to as many consumers, timing every 16th
+// enqueue (including its retries) into `latencies`. Threads yield while full or empty.
+template <typename Push, typename Pop>
+void transfer(unsigned threads, std::size_t messages, Push push, Pop pop, std::vector<double>& latencies) {
+  using clock = std::chrono::steady_clock;
+  const std::size_t per_thread = messages / threads;
+  std::vector<std::vector<double>> timed(threads);
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      timed[t].reserve(per_thread / 16 + 1);
+      for (std::size_t i = 0; i < per_thread; ++i) {
+        const int value = static_cast<int>(i);
+        if (i % 16 == 0) {
+          const auto start = clock::now();
+          while (!push(value)) std::this_thread::yield();
+          timed[t].push_back(std::chrono::duration<double, std::nano>(clock::now() - start).count());
+        } else {
+          while (!push(value)) std::this_thread::yield();
+        }
+      }
+    });
+    workers.emplace_back([&] {
+      long long sum = 0;
+      for (std::size_t i = 0; i < per_thread; ++i) {
+        int value;
+        while (!pop(value)) std::this_thread::yield();
+        sum += value;
+      }
+      cst::bench::do_not_optimize(sum);
+    });
+  }
+  for (auto& w : workers) w.join();
+  latencies.clear();
+  for (auto& t : timed) latencies.insert(latencies.end(), t.begin(), t.end());
+}
+
+double p99(std::vector<double> values) {
+  if (values.empty()) return 0;
+  auto nth = values.begin() + static_cast<std::ptrdiff_t>(values.size() * 99 / 100);
+  std::nth_element(values.begin(), nth, values.end());
+  return *nth;
+}
+
+// 1..64 producers and as many consumers (threads=N), 2^18 messages per run through
+// queues of 1024 slots; thread start-up is part of every run.
+BENCH_CASE("Selection statements with initializer") {
+  constexpr std::size_t messages = 1 << 18;
+  bench.items(messages);
+  std::vector<double> latencies;
+  for (unsigned threads = 1; threads <= 64; threads *= 2) {
+    const std::string suffix = " threads=" + std::to_string(threads);
+    std::mutex mx;
+    std::vector<int> v;
+    bench.run("lock_guard + vector" + suffix, [&] {
+      transfer(
+          threads, messages,
+          [&](int x) {
+            std::lock_guard<std::mutex> lk(mx);
+            if (v.size() == 1024) return false;
+            v.push_back(x);
+            return true;
+          },
+          [&](int& x) {
+            if (std::lock_guard<std::mutex> lk(mx); !v.empty()) {
+              x = v.back();
+              v.pop_back();
+              return true;
+            }
+            return false;
+          },
+          latencies);
+    });
+    bench.counter("p99 enqueue ns", p99(latencies));
+
+    cst::mpmc_queue<int> mpmc(1024);
+    bench.run("mpmc_queue" + suffix, [&] {
+      transfer(
+          threads, messages, [&](int x) { return mpmc.try_push(x); }, [&](int& x) { return mpmc.try_pop(x); },
+          latencies);
+    });
+    bench.counter("p99 enqueue ns", p99(latencies));
+
+    if (threads == 1) {
+      cst::spsc_queue<int> spsc(1024);
+      bench.run("spsc_queue" + suffix, [&] {
+        transfer(
+            threads, messages, [&](int x) { return spsc.try_push(x); }, [&](int& x) { return spsc.try_pop(x); },
+            latencies);
+      });
+      bench.counter("p99 enqueue ns", p99(latencies));
+    }
+  }
 }
 
 // Write code that is instantiated depending on a compile-time condition.
@@ -287,6 +475,17 @@ TEST_CASE("fallthrough, nodiscard, maybe_unused attributes") {
 }
 
 
+template <std::size_t I>
+struct alternative {
+  int value;
+};
+template <typename Seq>
+struct wide_variant_of;
+template <std::size_t... Is>
+struct wide_variant_of<std::index_sequence<Is...>> {
+  using type = std::variant<alternative<Is>...>;
+};
+
 TEST_CASE("std::variant") {
   std::variant<int, double> v {12};
   CHECK(std::get<int>(v) == 12); // == 12
@@ -296,6 +495,139 @@ TEST_CASE("std::variant") {
   CHECK(std::get<1>(v) == 12.1); // == 12.1
   //CHECK_THROWS_WITH(std::get<int>(v) == 12, "Unexpected index"); // gcc exception: "Unexpected index"
   CHECK_THROWS(std::get<int>(v) == 12);
+
+  // Visiting dispatches on the active alternative; cst::fast_visit does it with a switch.
+  auto name = [](const auto& x) -> std::string { return std::is_same_v<std::decay_t<decltype(x)>, int> ? "int" : "double"; };
+  CHECK(std::visit(name, v) == "double");
+  CHECK(cst::fast_visit(name, v) == "double");
+  cst::fast_visit([](auto& x) { x *= 2; }, v);
+  CHECK(std::get<double>(v) == 24.2);
+
+  std::variant<std::string, int> s {"moved"};
+  const std::string taken = cst::fast_visit([](auto&& x) -> std::string {
+    if constexpr (std::is_same_v<decltype(x), std::string&&>) return std::move(x);
+    else return {};
+  }, std::move(s));
+  CHECK(taken == "moved");
+
+  // Several variants: one nested switch per variant.
+  std::variant<int, double> a {2}, b {0.5};
+  auto product = [](auto x, auto y) -> double { return x * y; };
+  CHECK(cst::fast_visit(product, a, b) == 1.0);
+  CHECK(cst::fast_visit(product, a, b) == std::visit(product, a, b));
+
+  struct throws_on_copy {
+    throws_on_copy() = default;
+    throws_on_copy(const throws_on_copy&) { throw 1; }
+    throws_on_copy& operator=(const throws_on_copy&) = default;
+  };
+  std::variant<int, throws_on_copy> valueless;
+  CHECK_THROWS(valueless.emplace<throws_on_copy>(throws_on_copy{})); // no move constructor, copies
+  CHECK(valueless.valueless_by_exception());
+  CHECK_THROWS_AS(cst::fast_visit([](const auto&) {}, valueless), std::bad_variant_access);
+
+  // 64 alternatives is the largest switch, one more goes through std::visit.
+  static_assert(cst::detail::fast_visit_max_alternatives == 64);
+  auto value_of = [](const auto& x) { return x.value; };
+  wide_variant_of<std::make_index_sequence<64>>::type switched {std::in_place_index<63>, alternative<63>{63}};
+  CHECK(cst::fast_visit(value_of, switched) == 63);
+  switched.emplace<0>(alternative<0>{0});
+  CHECK(cst::fast_visit(value_of, switched) == 0);
+  wide_variant_of<std::make_index_sequence<65>>::type fallback {std::in_place_index<64>, alternative<64>{64}};
+  CHECK(cst::fast_visit(value_of, fallback) == 64);
+  fallback.emplace<63>(alternative<63>{63});
+  CHECK(cst::fast_visit(value_of, fallback) == 63);
+
+  // Every alternative has to give the same return type, fast_visit does not convert.
+  auto identity = [](auto x) { return x; };
+  static_assert(!cst::detail::visit_returns_v<int, decltype(identity), std::variant<int, double>&>);
+  static_assert(cst::detail::visit_returns_v<std::string, decltype(name), std::variant<int, double>&>);
+  static_assert(cst::detail::visit_returns_v<double, decltype(product), std::variant<int, double>&, std::variant<int, double>&>);
+}
+
+using wide_variant = wide_variant_of<std::make_index_sequence<32>>::type;
+
+// The hand-written alternative to visiting: test the alternatives one after another.
+template <typename Variant, std::size_t... Is>
+double sum_get_if(const std::vector<Variant>& values, std::index_sequence<Is...>) {
+  double sum = 0;
+  for (const auto& v : values) {
+    static_cast<void>(((std::get_if<Is>(&v) ? (sum += static_cast<double>(*std::get_if<Is>(&v)), true) : false) || ...));
+  }
+  return sum;
+}
+
+// `skew` is the share of the first alternative, the rest is spread evenly.
+template <typename Variant, typename Make>
+std::vector<Variant> make_variants(std::size_t n, double skew, Make make) {
+  constexpr std::size_t k = std::variant_size_v<Variant>;
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> coin(0, 1);
+  std::uniform_int_distribution<std::size_t> pick(1, k - 1);
+  std::vector<Variant> values;
+  values.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    values.push_back(make(coin(rng) < skew ? 0 : pick(rng), static_cast<int>(i % 100)));
+  }
+  return values;
+}
+
+template <typename T>
+T make_value(int value) {
+  if constexpr (std::is_arithmetic_v<T>) {
+    return static_cast<T>(value);
+  } else {
+    return T{value};
+  }
+}
+
+template <typename Variant, std::size_t... Is>
+Variant make_alternative(std::size_t index, int value, std::index_sequence<Is...>) {
+  Variant v;
+  static_cast<void>(((index == Is ? (v.template emplace<Is>(make_value<std::variant_alternative_t<Is, Variant>>(value)), true) : false) || ...));
+  return v;
+}
+
+BENCH_CASE("std::variant") {
+  using small_variant = std::variant<int, double, float, long long, short, unsigned>;
+  constexpr std::size_t n = 100000;
+  auto as_double = [](auto x) { return static_cast<double>(x); };
+  auto value_of = [](auto x) { return static_cast<double>(x.value); };
+  bench.items(n);
+  for (double skew : {1.0 / 6, 0.9}) {
+    const std::string dist = skew < 0.5 ? " uniform" : " 90% int";
+    const auto values = make_variants<small_variant>(n, skew, [](std::size_t index, int value) {
+      return make_alternative<small_variant>(index, value, std::make_index_sequence<6>());
+    });
+    bench.run("std::visit 6 types" + dist, [&] {
+      double sum = 0;
+      for (const auto& v : values) sum += std::visit(as_double, v);
+      cst::bench::do_not_optimize(sum);
+    });
+    bench.run("get_if chain 6 types" + dist, [&] {
+      cst::bench::do_not_optimize(sum_get_if(values, std::make_index_sequence<6>()));
+    });
+    bench.run("fast_visit 6 types" + dist, [&] {
+      double sum = 0;
+      for (const auto& v : values) sum += cst::fast_visit(as_double, v);
+      cst::bench::do_not_optimize(sum);
+    });
+
+    const auto wide = make_variants<wide_variant>(n, skew == 0.9 ? 0.9 : 1.0 / 32, [](std::size_t index, int value) {
+      return make_alternative<wide_variant>(index, value, std::make_index_sequence<32>());
+    });
+    const std::string wide_dist = skew < 0.5 ? " uniform" : " 90% first";
+    bench.run("std::visit 32 types" + wide_dist, [&] {
+      double sum = 0;
+      for (const auto& v : wide) sum += std::visit(value_of, v);
+      cst::bench::do_not_optimize(sum);
+    });
+    bench.run("fast_visit 32 types" + wide_dist, [&] {
+      double sum = 0;
+      for (const auto& v : wide) sum += cst::fast_visit(value_of, v);
+      cst::bench::do_not_optimize(sum);
+    });
+  }
 }
 
 std::optional<std::string> create(bool b) {
@@ -321,6 +653,65 @@ TEST_CASE("std::any") {
   CHECK(std::any_cast<int>(x) == 5); // == 5
   std::any_cast<int&>(x) = 10;
   CHECK(std::any_cast<int>(x) == 10); // == 10
+
+  // cst::basic_any: the inline buffer size is a parameter, casts compare a table pointer.
+  cst::any y {5};
+  CHECK(cst::any_cast<int>(y) == 5);
+  cst::any_cast<int&>(y) = 10;
+  CHECK(cst::any_cast<int>(y) == 10);
+  CHECK(cst::any_cast<long>(&y) == nullptr); // exact type, no conversions
+  CHECK_THROWS_AS(cst::any_cast<double>(y), std::bad_any_cast);
+
+  y = std::string(100, 'x'); // larger than the buffer: heap
+  cst::any z = y;
+  CHECK(cst::any_cast<const std::string&>(z).size() == 100);
+  static_assert(!cst::any::stores_inline<std::array<char, 48>>);
+  static_assert(cst::basic_any<64>::stores_inline<std::array<char, 48>>);
+
+  cst::unique_any u {std::make_unique<int>(7)};
+  static_assert(!std::is_copy_constructible_v<cst::unique_any>);
+  cst::unique_any v = std::move(u);
+  CHECK_FALSE(u.has_value());
+  CHECK(*cst::any_cast<std::unique_ptr<int>&>(v) == 7);
+  u = std::move(v);
+  u.swap(v);
+  CHECK(v.holds<std::unique_ptr<int>>());
+}
+
+template <std::size_t N>
+struct any_payload {
+  char bytes[N];
+};
+
+template <typename Any, typename Cast>
+void bench_any(cst::bench::Bench& bench, const std::string& name, Cast cast) {
+  auto sizes = [&](auto payload) {
+    using P = decltype(payload);
+    const std::string suffix = " " + std::to_string(sizeof(P)) + " bytes";
+    bench.run(name + " construct" + suffix, [&] {
+      Any a(payload);
+      cst::bench::do_not_optimize(a);
+    });
+    Any a(payload);
+    bench.run(name + " copy" + suffix, [&] {
+      Any b(a);
+      cst::bench::do_not_optimize(b);
+    });
+    bench.run(name + " cast" + suffix, [&] {
+      cst::bench::do_not_optimize(cast(a, payload));
+    });
+  };
+  sizes(any_payload<8>{});
+  sizes(any_payload<32>{});
+  sizes(any_payload<128>{});
+}
+
+BENCH_CASE("std::any") {
+  auto std_cast = [](std::any& a, auto payload) { return std::any_cast<decltype(payload)>(&a); };
+  auto cst_cast = [](auto& a, auto payload) { return cst::any_cast<decltype(payload)>(&a); };
+  bench_any<std::any>(bench, "std::any", std_cast);
+  bench_any<cst::any>(bench, "cst::any", cst_cast);
+  bench_any<cst::basic_any<128>>(bench, "cst::basic_any<128>", cst_cast);
 }
 
 
@@ -339,6 +730,105 @@ TEST_CASE("std::string_view") {
   v.remove_prefix(std::min(v.find_first_not_of(" "), v.size()));
   CHECK(str == "   trim me"); //  == "   trim me"
   CHECK(v == "trim me"); // == "trim me"
+
+  // Splitting into views of the original buffer, 64 bytes per SIMD step.
+  const std::string text = "  alpha beta\tgamma\n" + std::string(100, ' ') + "delta  ";
+  std::vector<std::string_view> words;
+  for (std::string_view word : cst::split(text)) words.push_back(word);
+  CHECK(words == std::vector<std::string_view>{"alpha", "beta", "gamma", "delta"});
+  CHECK(words[0].data() == text.data() + 2); // no copies
+  std::vector<std::string_view> cells(cst::split("a,,b,", ",", true).begin(), cst::split::iterator());
+  CHECK(cells == std::vector<std::string_view>{"a", "", "b", ""});
+  CHECK(cst::split("   ").begin() == cst::split("   ").end());
+
+  const std::string table =
+      "id,name,comment\r\n"
+      "1,\"Smith, J.\",\"said \"\"hi\"\"\"\n"
+      "2,plain,\"multi\nline\"\n";
+  std::vector<std::string> fields;
+  std::size_t records = 0;
+  for (const cst::csv_field& f : cst::csv(table)) {
+    fields.push_back(f.value());
+    records += f.last ? 1 : 0;
+  }
+  CHECK(records == 3);
+  CHECK(fields == std::vector<std::string>{"id", "name", "comment", "1", "Smith, J.", "said \"hi\"", "2", "plain",
+                                           "multi\nline"});
+  auto last = *std::next(cst::csv("a;\"b\"\"\"", ';').begin());
+  CHECK(last.raw == "b\"\"");
+  CHECK(last.escaped);
+  CHECK(last.value() == "b\"");
+}
+
+// Word-per-token and CSV inputs of `bytes` bytes, with quoted fields.
+std::string generate_words(std::size_t bytes) {
+  static const char* const words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing"};
+  std::string text;
+  text.reserve(bytes + 16);
+  for (std::size_t i = 0; text.size() < bytes; ++i) {
+    text += words[i % 7];
+    text += i % 11 == 10 ? '\n' : ' ';
+  }
+  return text;
+}
+
+std::string generate_csv(std::size_t bytes) {
+  std::string text;
+  text.reserve(bytes + 64);
+  for (std::size_t i = 0; text.size() < bytes; ++i) {
+    text += std::to_string(i);
+    text += i % 5 == 0 ? ",\"Smith, John\"," : ",plain text,";
+    text += std::to_string(i * 7 % 1000);
+    text += ".25\n";
+  }
+  return text;
+}
+
+BENCH_CASE("std::string_view") {
+  // Hundreds of MB by default, scaled down with --bench-max-size.
+  const std::size_t bytes = static_cast<std::size_t>(std::min<std::uint64_t>(256u << 20, 32 * bench.max_size()));
+  bench.bytes(bytes);
+  {
+    const std::string text = generate_words(bytes);
+    bench.run("istringstream >> string", [&] {
+      std::istringstream in(text);
+      std::string word;
+      std::size_t n = 0;
+      while (in >> word) n += word.size();
+      cst::bench::do_not_optimize(n);
+    });
+    bench.run("cst::split", [&] {
+      std::size_t n = 0;
+      for (std::string_view word : cst::split(text)) n += word.size();
+      cst::bench::do_not_optimize(n);
+    });
+  }
+  {
+    const std::string text = generate_csv(bytes);
+    bench.run("getline lines, getline fields", [&] {
+      std::istringstream in(text);
+      std::string line, field;
+      std::size_t n = 0;
+      while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        while (std::getline(fields, field, ',')) n += field.size();
+      }
+      cst::bench::do_not_optimize(n);
+    });
+    bench.run("cst::csv", [&] {
+      std::size_t n = 0;
+      for (const cst::csv_field& f : cst::csv(text)) n += f.raw.size();
+      cst::bench::do_not_optimize(n);
+    });
+    bench.run("cst::csv scalar", [&] {
+      const auto best = cst::simd::active_isa();
+      cst::simd::set_isa(cst::simd::isa::scalar);
+      std::size_t n = 0;
+      for (const cst::csv_field& f : cst::csv(text)) n += f.raw.size();
+      cst::simd::set_isa(best);
+      cst::bench::do_not_optimize(n);
+    });
+  }
 }
 
 template <typename Callable>
@@ -352,12 +842,84 @@ public:
     return std::invoke(c, std::forward<Args>(args)...);
   }
 };
+static int twice(int x) { return 2 * x; }
 TEST_CASE("std::invoke") {
   auto add = [](int x, int y) {
     return x + y;
   };
   Proxy<decltype(add)> p {add};
   CHECK(p(1, 2) == 3); // == 3
+
+  // Type-erased and still without allocations: a view of the callable, or a copy of it
+  // in a fixed buffer.
+  cst::function_ref<int(int, int)> ref {add};
+  CHECK(ref(1, 2) == 3);
+  int (*plus)(int, int) = [](int x, int y) { return x + y; };
+  CHECK(cst::function_ref<int(int, int)>(plus)(2, 2) == 4);
+  cst::function_ref<int(int)> from_address = &twice; // the pointer is copied, not referenced
+  CHECK(from_address(21) == 42);
+
+  int calls = 0;
+  cst::inplace_function<int(int, int), 16> counted = [&calls, add](int x, int y) {
+    ++calls;
+    return add(x, y);
+  };
+  auto copy = counted;
+  CHECK(copy(1, 2) + counted(3, 4) == 10);
+  CHECK(calls == 2);
+  counted = nullptr;
+  CHECK_FALSE(counted);
+  CHECK_THROWS_AS(counted(1, 2), std::bad_function_call);
+  // A capture larger than the buffer does not compile:
+  // cst::inplace_function<void(), 16> too_big = [big = std::array<char, 32>{}] {};
+}
+
+BENCH_CASE("std::invoke") {
+  int x = 1;
+  std::array<long, 8> big {1, 2, 3, 4, 5, 6, 7, 8}; // 64 bytes, beyond the std::function buffer
+  auto small_capture = [&x](int y) { return x + y; };
+  auto large_capture = [big](int y) { return static_cast<int>(big[y & 7]) + y; };
+  constexpr int calls = 1000;
+  bench.items(calls);
+
+  auto run_calls = [&](const std::string& name, auto&& f) {
+    bench.run(name, [&] {
+      int sum = 0;
+      for (int i = 0; i < calls; ++i) {
+        cst::bench::do_not_optimize(f);
+        sum += f(i);
+      }
+      cst::bench::do_not_optimize(sum);
+    });
+  };
+  auto captures = [&](const std::string& capture, auto lambda) {
+    using L = decltype(lambda);
+    Proxy<L> proxy {lambda};
+    std::function<int(int)> function = lambda;
+    cst::function_ref<int(int)> ref = lambda;
+    cst::inplace_function<int(int), 64> inplace = lambda;
+    bench.items(calls);
+    run_calls("call Proxy" + capture, proxy);
+    run_calls("call std::function" + capture, function);
+    run_calls("call function_ref" + capture, ref);
+    run_calls("call inplace_function" + capture, inplace);
+
+    bench.items(1);
+    bench.run("construct std::function" + capture, [&] {
+      std::function<int(int)> f = lambda;
+      cst::bench::do_not_optimize(f);
+    });
+    bench.run("construct function_ref" + capture, [&] {
+      cst::function_ref<int(int)> f = lambda;
+      cst::bench::do_not_optimize(f);
+    });
+    bench.run("construct inplace_function" + capture, [&] {
+      cst::inplace_function<int(int), 64> f = lambda;
+      cst::bench::do_not_optimize(f);
+    });
+  };
+  captures(" small capture", small_capture);
+  captures(" 64 byte capture", large_capture);
 }
 
 
@@ -433,6 +995,374 @@ TEST_CASE("Splicing for maps and sets") {
   // m == { { 1, "one" }, { 3, "three" }, { 4, "two" } }
 }
 
+// The same operations on sorted-vector containers: no nodes to splice, but bulk inserts
+// and merges run in linear time over contiguous storage.
+TEST_CASE("Splicing for flat maps and sets") {
+  SUBCASE("extract and insert") {
+    cst::flat_map<int, std::string> src {{1, "one"}, {2, "two"}, {3, "buckle my shoe"}};
+    cst::flat_map<int, std::string> dst {{3, "three"}};
+    dst.insert(src.extract(src.find(1)));
+    dst.insert(src.extract(2));
+    CHECK(dst == cst::flat_map<int, std::string>{{1, "one"}, {2, "two"}, {3, "three"}});
+    CHECK(src.size() == 1);
+
+    auto r = dst.insert(src.extract(3)); // key taken, the node comes back
+    CHECK_FALSE(r.inserted);
+    CHECK(r.position->second == "three");
+    CHECK(r.node.mapped() == "buckle my shoe");
+    CHECK(src.extract(42).empty());
+  }
+
+  SUBCASE("merge") {
+    cst::flat_set<int> src {1, 3, 5};
+    cst::flat_set<int> dst {2, 4, 5};
+    dst.merge(src);
+    CHECK(src == cst::flat_set<int>{5});
+    CHECK(dst == cst::flat_set<int>{1, 2, 3, 4, 5});
+
+    cst::flat_map<int, std::string> a {{1, "a1"}, {4, "a4"}};
+    cst::flat_map<int, std::string> b {{0, "b0"}, {4, "b4"}, {9, "b9"}};
+    a.merge(b);
+    CHECK(a == cst::flat_map<int, std::string>{{0, "b0"}, {1, "a1"}, {4, "a4"}, {9, "b9"}});
+    CHECK(b == cst::flat_map<int, std::string>{{4, "b4"}});
+  }
+
+  SUBCASE("changing the key of an element") {
+    cst::flat_map<int, std::string> m {{1, "one"}, {2, "two"}, {3, "three"}};
+    auto e = m.extract(2);
+    e.key() = 4;
+    m.insert(std::move(e));
+    CHECK(m == cst::flat_map<int, std::string>{{1, "one"}, {3, "three"}, {4, "two"}});
+
+    cst::flat_set<std::string> s {"a", "c"};
+    auto n = s.extract("c");
+    n.value() = "b";
+    CHECK(s.insert(std::move(n)).inserted);
+    CHECK(std::is_sorted(s.begin(), s.end()));
+  }
+
+  SUBCASE("bulk insert") {
+    cst::flat_map<int, int> m {{5, 50}, {1, 10}, {5, 51}};
+    CHECK(m.size() == 2);
+    CHECK(m.at(5) == 50); // first one wins, like repeated single inserts
+
+    std::vector<std::pair<int, int>> more {{7, 70}, {0, 0}, {1, 11}, {7, 71}};
+    m.insert(more.begin(), more.end());
+    CHECK(m == cst::flat_map<int, int>{{0, 0}, {1, 10}, {5, 50}, {7, 70}});
+
+    std::vector<std::pair<int, int>> sorted {{2, 20}, {5, 55}, {8, 80}};
+    m.insert(cst::sorted_unique, sorted.begin(), sorted.end());
+    CHECK(m == cst::flat_map<int, int>{{0, 0}, {1, 10}, {2, 20}, {5, 50}, {7, 70}, {8, 80}});
+
+    m[3] = 30;
+    m.insert_or_assign(8, 88);
+    CHECK(m.try_emplace(0, 99).second == false);
+    CHECK(m.at(3) == 30);
+    CHECK(m.at(8) == 88);
+    CHECK_THROWS_AS(m.at(4), std::out_of_range);
+    CHECK(m.erase(7) == 1);
+    CHECK(m.lower_bound(6)->first == 8);
+    CHECK(m.upper_bound(8) == m.end());
+  }
+
+  SUBCASE("matches std::map") {
+    std::mt19937 rng{7};
+    std::map<int, int> ref;
+    cst::flat_map<int, int> flat;
+    for (int i = 0; i < 5000; ++i) {
+      int k = static_cast<int>(rng() % 512);
+      switch (rng() % 3) {
+        case 0: CHECK(flat.insert({k, i}).second == ref.insert({k, i}).second); break;
+        case 1: CHECK(flat.erase(k) == ref.erase(k)); break;
+        default: CHECK(flat.contains(k) == (ref.count(k) == 1)); break;
+      }
+    }
+    CHECK(std::vector<std::pair<int, int>>(flat.begin(), flat.end()) ==
+          std::vector<std::pair<int, int>>(ref.begin(), ref.end()));
+  }
+}
+
+// Counts the bytes a container holds through its allocator.
+struct allocation_meter {
+  std::size_t current = 0;
+  std::size_t peak = 0;
+};
+
+template <typename T>
+struct metered_allocator {
+  using value_type = T;
+  allocation_meter* meter;
+
+  explicit metered_allocator(allocation_meter* m) : meter(m) {}
+  template <typename U>
+  metered_allocator(const metered_allocator<U>& o) : meter(o.meter) {}
+
+  T* allocate(std::size_t n) {
+    meter->current += n * sizeof(T);
+    meter->peak = std::max(meter->peak, meter->current);
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, std::size_t n) {
+    meter->current -= n * sizeof(T);
+    std::allocator<T>().deallocate(p, n);
+  }
+  template <typename U>
+  bool operator==(const metered_allocator<U>& o) const { return meter == o.meter; }
+  template <typename U>
+  bool operator!=(const metered_allocator<U>& o) const { return meter != o.meter; }
+};
+
+// Node-based std::map against cst::flat_map for 10^4..--bench-max-size int -> int
+// entries: footprint (bytes/element counter, allocator bytes only, malloc headers not
+// included), building, iterating and merging two half-overlapping maps.
+BENCH_CASE("Splicing for flat maps and sets") {
+  using node_map = std::map<int, int, std::less<int>, metered_allocator<std::pair<const int, int>>>;
+  using flat = cst::flat_map<int, int, std::less<int>, metered_allocator<std::pair<int, int>>>;
+
+  for (std::uint64_t n = 10000; n <= bench.max_size(); n *= 10) {
+    std::vector<std::pair<int, int>> items(n);
+    std::mt19937 rng{3};
+    for (auto& e : items) e = {static_cast<int>(rng() >> 1), 1};
+    // Every other key of `other` also appears in `items`.
+    std::vector<std::pair<int, int>> other(n);
+    for (std::size_t i = 0; i < n; ++i) other[i] = {i % 2 ? items[i].first : static_cast<int>(rng() >> 1), 2};
+    const std::string size = " n=" + std::to_string(n);
+
+    allocation_meter node_bytes, flat_bytes;
+    node_map m{metered_allocator<std::pair<const int, int>>(&node_bytes)};
+    m.insert(items.begin(), items.end());
+    flat f{metered_allocator<std::pair<int, int>>(&flat_bytes)};
+    f.insert(items.begin(), items.end());
+    f.shrink_to_fit();
+
+    bench.items(n);
+    bench.run("std::map build" + size, [&] {
+      node_map tmp(items.begin(), items.end(), std::less<int>(), m.get_allocator());
+      cst::bench::do_not_optimize(tmp.size());
+    });
+    bench.counter("bytes/element", static_cast<double>(node_bytes.current) / m.size());
+    bench.run("cst::flat_map build (bulk insert)" + size, [&] {
+      flat tmp{f.get_allocator()};
+      tmp.insert(items.begin(), items.end());
+      cst::bench::do_not_optimize(tmp.size());
+    });
+    bench.counter("bytes/element", static_cast<double>(flat_bytes.current) / f.size());
+
+    bench.run("std::map iterate" + size, [&] {
+      long long sum = 0;
+      for (auto& kv : m) sum += kv.second;
+      cst::bench::do_not_optimize(sum);
+    });
+    bench.run("cst::flat_map iterate" + size, [&] {
+      long long sum = 0;
+      for (auto& kv : f) sum += kv.second;
+      cst::bench::do_not_optimize(sum);
+    });
+
+    // Includes building the source, which is what makes the loop repeatable.
+    bench.items(2 * n);
+    bench.run("std::map merge (node splicing)" + size, [&] {
+      node_map dst = m;
+      node_map src(other.begin(), other.end(), std::less<int>(), m.get_allocator());
+      dst.merge(src);
+      cst::bench::do_not_optimize(dst.size());
+    });
+    bench.run("cst::flat_map merge (linear)" + size, [&] {
+      flat dst = f;
+      flat src{f.get_allocator()};
+      src.insert(other.begin(), other.end());
+      dst.merge(src);
+      cst::bench::do_not_optimize(dst.size());
+    });
+  }
+}
+
+// Containers that are built, used and thrown away can take their memory from an arena
+// or a pool instead of the global heap; the allocator is part of the std::pmr type but
+// the resource is chosen at run time.
+TEST_CASE("Polymorphic memory resources") {
+  SUBCASE("arena") {
+    cst::pmr::counting_resource upstream;
+    {
+      cst::pmr::arena_resource arena(1024, &upstream);
+      cst::pmr::Vec<int> v(&arena);
+      for (int i = 0; i < 1000; ++i) v.push_back(i);
+      cst::pmr::map<int, std::pmr::string> m(&arena);
+      m[1] = "a string too long for the small string buffer"; // uses-allocator: the arena again
+      CHECK(m.begin()->second.get_allocator().resource() == &arena);
+      CHECK(upstream.allocations() < 10); // chunks double, v grew ~11 times
+      CHECK(upstream.deallocations() == 0);
+      CHECK(arena.reserved_bytes() == upstream.live_bytes());
+    }
+    CHECK(upstream.live_bytes() == 0);
+    CHECK(upstream.peak_bytes() >= 1000 * sizeof(int));
+  }
+
+  SUBCASE("arena, over-aligned request at the end of a chunk") {
+    cst::pmr::counting_resource upstream;
+    cst::pmr::arena_resource arena(256, &upstream);
+    arena.allocate(256 - 16 - 8, 8); // after the 16-byte chunk header, 8 bytes are left
+    REQUIRE(upstream.allocations() == 1);
+    void* p = arena.allocate(1, 4096);
+    CHECK(reinterpret_cast<std::uintptr_t>(p) % 4096 == 0);
+    CHECK(upstream.allocations() == 2); // from a new chunk, not past the end of the first
+  }
+
+  SUBCASE("pool") {
+    cst::pmr::counting_resource upstream;
+    cst::pmr::pool_resource pool(&upstream);
+    for (int i = 0; i < 100; ++i) {
+      void* p = pool.allocate(24);
+      pool.deallocate(p, 24);
+    }
+    CHECK(upstream.allocations() == 1); // one chunk for the 32-byte class, blocks are reused
+    void* aligned = pool.allocate(48, 64);
+    CHECK(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0);
+    pool.deallocate(aligned, 48, 64);
+    void* big = pool.allocate(100000);
+    CHECK(upstream.live_bytes() >= 100000);
+    pool.deallocate(big, 100000);
+    CHECK(upstream.live_bytes() < 100000);
+
+    {
+      cst::pmr::set<int> s(&pool);
+      cst::pmr::unordered_map<int, int> u(&pool);
+      for (int i = 0; i < 1000; ++i) {
+        s.insert(i);
+        u[i] = i;
+      }
+      for (int i = 0; i < 1000; i += 2) s.erase(i);
+      CHECK(s.size() == 500);
+    }
+    pool.release();
+    CHECK(upstream.live_bytes() == 0);
+  }
+
+  SUBCASE("huge pages") {
+    cst::pmr::page_resource pages(true);
+    cst::pmr::arena_resource arena(1 << 21, &pages);
+    cst::pmr::flat_map<int, int> m(&arena);
+    for (int i = 0; i < 10000; ++i) m.try_emplace(i, i);
+    CHECK(m.at(9999) == 9999);
+    void* p = pages.allocate(100);
+    CHECK(reinterpret_cast<std::uintptr_t>(p) % (1 << 21) == 0);
+    pages.deallocate(p, 100);
+  }
+
+  SUBCASE("splicing needs equal resources") {
+    // Node handles carry the allocator: extract/insert and merge are only valid between
+    // containers using the same resource.
+    cst::pmr::arena_resource arena;
+    cst::pmr::map<int, int> src({{1, 1}, {2, 2}}, &arena);
+    cst::pmr::map<int, int> dst(&arena);
+    dst.insert(src.extract(1));
+    dst.merge(src);
+    CHECK(dst.size() == 2);
+    CHECK(src.empty());
+  }
+}
+
+// Build, use and destroy a container with the default allocator and with each resource,
+// at 10^4..--bench-max-size elements. Counters: bytes the resource took from its
+// upstream at peak (the std::allocator row counts through new_delete_resource) and the
+// growth of the resident set while the container was alive (0 when the heap recycles
+// pages the timed runs already touched).
+template <typename Workload>
+void bench_resources(cst::bench::Bench& bench, const std::string& suffix, Workload workload) {
+  auto measure = [&](auto make_resource) {
+    cst::pmr::counting_resource upstream(std::pmr::new_delete_resource());
+    std::size_t rss_growth = 0;
+    {
+      auto resource = make_resource(&upstream);
+      const std::size_t rss = cst::pmr::resident_bytes();
+      workload(resource.get(), [&] {
+        const std::size_t now = cst::pmr::resident_bytes();
+        rss_growth = now > rss ? now - rss : 0;
+      });
+    }
+    bench.counter("peak upstream MB", upstream.peak_bytes() / 1e6);
+    bench.counter("RSS growth MB", rss_growth / 1e6);
+  };
+  struct no_resource {
+    std::pmr::memory_resource* upstream;
+    std::pmr::memory_resource* get() const { return upstream; }
+  };
+  const auto noop = [] {};
+
+  bench.run("std::allocator" + suffix, [&] { workload(nullptr, noop); });
+  measure([](std::pmr::memory_resource* up) { return no_resource{up}; });
+  bench.run("pmr arena" + suffix, [&] {
+    cst::pmr::arena_resource arena;
+    workload(&arena, noop);
+  });
+  measure([](std::pmr::memory_resource* up) { return std::make_unique<cst::pmr::arena_resource>(64 * 1024, up); });
+  bench.run("pmr arena on huge pages" + suffix, [&] {
+    cst::pmr::page_resource pages(true);
+    cst::pmr::arena_resource arena(2 << 20, &pages);
+    workload(&arena, noop);
+  });
+  bench.run("pmr pool" + suffix, [&] {
+    cst::pmr::pool_resource pool;
+    workload(&pool, noop);
+  });
+  measure([](std::pmr::memory_resource* up) { return std::make_unique<cst::pmr::pool_resource>(up); });
+  bench.run("std::pmr::unsynchronized_pool_resource" + suffix, [&] {
+    std::pmr::unsynchronized_pool_resource pool;
+    workload(&pool, noop);
+  });
+}
+
+BENCH_CASE("Polymorphic memory resources") {
+  for (std::uint64_t n = 10000; n <= bench.max_size(); n *= 10) {
+    const std::string size = " n=" + std::to_string(n);
+    bench.items(n);
+
+    // nullptr selects the std::allocator containers.
+    bench_resources(bench, " vector" + size, [n](std::pmr::memory_resource* mr, auto at_peak) {
+      long long sum = 0;
+      if (mr == nullptr) {
+        std::vector<long long> v;
+        for (std::uint64_t i = 0; i < n; ++i) v.push_back(i);
+        for (auto x : v) sum += x;
+      } else {
+        cst::pmr::Vec<long long> v(mr);
+        for (std::uint64_t i = 0; i < n; ++i) v.push_back(i);
+        for (auto x : v) sum += x;
+        at_peak();
+      }
+      cst::bench::do_not_optimize(sum);
+    });
+    bench_resources(bench, " map" + size, [n](std::pmr::memory_resource* mr, auto at_peak) {
+      long long sum = 0;
+      if (mr == nullptr) {
+        std::map<std::uint64_t, std::uint64_t> m;
+        for (std::uint64_t i = 0; i < n; ++i) m.emplace((i * 2654435761u) % n, i);
+        for (const auto& kv : m) sum += kv.second;
+      } else {
+        cst::pmr::map<std::uint64_t, std::uint64_t> m(mr);
+        for (std::uint64_t i = 0; i < n; ++i) m.emplace((i * 2654435761u) % n, i);
+        for (const auto& kv : m) sum += kv.second;
+        at_peak();
+      }
+      cst::bench::do_not_optimize(sum);
+    });
+    bench_resources(bench, " unordered_map" + size, [n](std::pmr::memory_resource* mr, auto at_peak) {
+      long long sum = 0;
+      if (mr == nullptr) {
+        std::unordered_map<std::uint64_t, std::uint64_t> m;
+        for (std::uint64_t i = 0; i < n; ++i) m.emplace(i, i);
+        for (std::uint64_t i = 0; i < n; i += 3) sum += m.at(i);
+      } else {
+        cst::pmr::unordered_map<std::uint64_t, std::uint64_t> m(mr);
+        for (std::uint64_t i = 0; i < n; ++i) m.emplace(i, i);
+        for (std::uint64_t i = 0; i < n; i += 3) sum += m.at(i);
+        at_peak();
+      }
+      cst::bench::do_not_optimize(sum);
+    });
+  }
+}
+
 // Many of the STL algorithms, such as the copy, find and sort methods, started to support the parallel execution policies: seq, par and par_unseq which translate to "sequentially", "parallel" and "parallel unsequenced".
 
 TEST_CASE("Parallel algorithms") {
@@ -443,4 +1373,103 @@ TEST_CASE("Parallel algorithms") {
   // Sort elements using sequential execution policy
   auto result2 = std::sort(std::execution::seq, std::begin(longVector), std::end(longVector));
 #endif
-}
\ No newline at end of file
+  // Same calls on the in-tree backend (parallel.h).
+  std::vector<int> longVector(1000000);
+  std::mt19937 rng{42};
+  std::uniform_int_distribution<int> dist{3, 1000};
+  for (auto& e : longVector) e = dist(rng);
+  longVector[700000] = 2;
+  longVector[900000] = 2;
+
+  SUBCASE("find") {
+    auto result1 = cst::find(cst::execution::par, std::begin(longVector), std::end(longVector), 2);
+    CHECK(result1 - longVector.begin() == 700000); // the first match wins like in std::find
+    CHECK(cst::find(cst::execution::par_unseq, longVector.begin(), longVector.end(), 1) == longVector.end());
+    CHECK(cst::find(cst::execution::seq, longVector.begin(), longVector.end(), 2) == result1);
+  }
+  SUBCASE("sort") {
+    auto expected = longVector;
+    std::sort(expected.begin(), expected.end());
+    cst::sort(cst::execution::par, std::begin(longVector), std::end(longVector));
+    CHECK(longVector == expected);
+    cst::sort(cst::execution::par.on(3), longVector.begin(), longVector.end(), std::greater<>{});
+    CHECK(std::is_sorted(longVector.rbegin(), longVector.rend()));
+  }
+  SUBCASE("transform_reduce") {
+    auto expected = std::transform_reduce(longVector.begin(), longVector.end(), 0LL, std::plus<>{},
+                                          [](int x) { return 2LL * x; });
+    auto sum = cst::transform_reduce(cst::execution::par, longVector.begin(), longVector.end(), 0LL,
+                                     std::plus<>{}, [](int x) { return 2LL * x; });
+    CHECK(sum == expected);
+    std::vector<long long> ones(longVector.size(), 1);
+    CHECK(cst::transform_reduce(cst::execution::par_unseq, longVector.begin(), longVector.end(), ones.begin(),
+                                0LL) == expected / 2);
+  }
+  SUBCASE("for_each") {
+    cst::for_each(cst::execution::par_unseq, longVector.begin(), longVector.end(), [](int& x) { x = 1; });
+    CHECK(std::all_of(longVector.begin(), longVector.end(), [](int x) { return x == 1; }));
+  }
+  SUBCASE("inclusive_scan") {
+    std::vector<long long> expected(longVector.size()), out(longVector.size());
+    std::inclusive_scan(longVector.begin(), longVector.end(), expected.begin(), std::plus<long long>{});
+    cst::inclusive_scan(cst::execution::par, longVector.begin(), longVector.end(), out.begin(),
+                        std::plus<long long>{});
+    CHECK(out == expected);
+  }
+  SUBCASE("small ranges") {
+    std::vector<int> v {3, 1, 2};
+    cst::sort(cst::execution::par, v.begin(), v.end());
+    CHECK(v == std::vector<int> {1, 2, 3});
+    std::vector<int> empty;
+    CHECK(cst::find(cst::execution::par, empty.begin(), empty.end(), 2) == empty.end());
+    cst::inclusive_scan(cst::execution::par, v.begin(), v.end(), v.begin());
+    CHECK(v == std::vector<int> {1, 3, 6});
+  }
+}
+
+// Scaling of the in-tree backend over 1..--bench-threads threads and 10^6..--bench-max-size
+// elements (10^9 ints need 4 GB, pass --bench-max-size=1000000000 explicitly).
+BENCH_CASE("Parallel algorithms") {
+  std::vector<unsigned> thread_counts;
+  for (unsigned t = 1; t < bench.max_threads(); t *= 2) thread_counts.push_back(t);
+  thread_counts.push_back(bench.max_threads());
+
+  for (std::uint64_t n = 1000000; n <= bench.max_size(); n *= 10) {
+    std::vector<int> data(n);
+    std::mt19937 rng{1};
+    for (auto& e : data) e = static_cast<int>(rng() >> 1);
+    std::vector<int> work(n);
+    const std::string size = " n=" + std::to_string(n);
+
+    bench.bytes(n * sizeof(int));
+    bench.run("std::find (seq)" + size, [&] {
+      cst::bench::do_not_optimize(std::find(data.begin(), data.end(), -1));
+    });
+    bench.run("std::sort (seq, includes copy)" + size, [&] {
+      std::copy(data.begin(), data.end(), work.begin());
+      std::sort(work.begin(), work.end());
+    });
+    for (unsigned t : thread_counts) {
+      const std::string suffix = size + " threads=" + std::to_string(t);
+      auto policy = cst::execution::par.on(t);
+      bench.run("find" + suffix, [&] {
+        cst::bench::do_not_optimize(cst::find(policy, data.begin(), data.end(), -1));
+      });
+      bench.run("sort (includes copy)" + suffix, [&] {
+        std::copy(data.begin(), data.end(), work.begin());
+        cst::sort(policy, work.begin(), work.end());
+      });
+      bench.run("transform_reduce" + suffix, [&] {
+        cst::bench::do_not_optimize(cst::transform_reduce(cst::execution::par_unseq.on(t), data.begin(),
+                                                          data.end(), 0LL, std::plus<>{},
+                                                          [](int x) { return static_cast<long long>(x); }));
+      });
+      bench.run("for_each" + suffix, [&] {
+        cst::for_each(cst::execution::par_unseq.on(t), work.begin(), work.end(), [](int& x) { x += 1; });
+      });
+      bench.run("inclusive_scan (xor)" + suffix, [&] {
+        cst::inclusive_scan(policy, data.begin(), data.end(), work.begin(), std::bit_xor<>{});
+      });
+    }
+  }
+}
@@ -3,13 +3,458 @@
 DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
 DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
 
+#include "alloc_tracker.h"
+#include "bench.h"
+#include "lifecycle.h"
+#include "small_vector.h"
+#include "thread_pool.h"
+
 #ifndef _MSC_VER
 
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <numbers>
+#include <ranges>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+#include "numeric.h"
+
+#ifdef __cpp_impl_coroutine
+#include "generator.h"
+#include "task.h"
+
+cst::generator<int> range(int start, int end) {
+  while (start < end) {
+    co_yield start;
+    start++;
+  }
+}
+
+cst::generator<unsigned long long> fibonacci() {
+  unsigned long long a = 0, b = 1;
+  for (;;) {
+    co_yield a;
+    b = std::exchange(a, b) + b;
+  }
+}
+
+cst::generator<std::string> lines(int n) {
+  for (int i = 0; i < n; ++i) {
+    co_yield "line " + std::to_string(i); // a temporary, alive until the caller moves on
+  }
+  throw std::runtime_error("no more lines");
+}
+
+TEST_CASE("Coroutines") {
+  int sum = 0;
+  for (int n : range(0, 10)) {
+    sum += n;
+  }
+  CHECK(sum == 45);
+
+  // Infinite, only computed as far as it is iterated.
+  std::vector<unsigned long long> fib;
+  for (auto f : fibonacci()) {
+    if (f > 50) break;
+    fib.push_back(f);
+  }
+  CHECK(fib == std::vector<unsigned long long>{0, 1, 1, 2, 3, 5, 8, 13, 21, 34});
+
+  auto gen = lines(2);
+  auto it = gen.begin();
+  CHECK(*it == "line 0");
+  CHECK((++it)->size() == 6);
+  CHECK_THROWS_AS(++it, std::runtime_error);
+  CHECK(it == gen.end());
+
+  cst::generator<int> moved = range(0, 3);
+  cst::generator<int> empty;
+  CHECK(empty.begin() == empty.end());
+  empty = std::move(moved);
+  int count = 0;
+  for (int n : empty) count += n + 1;
+  CHECK(count == 6);
+
+  // Frames are recycled: after the first one, short-lived generators do not allocate.
+  for (int n : range(0, 1)) (void)n;
+  const std::size_t reused = cst::detail::frame_cache::local().reused();
+  {
+    ALLOCATION_BUDGET(0);
+    for (int i = 0; i < 100; ++i) {
+      for (int n : range(0, 2)) sum += n;
+    }
+  }
+  CHECK(sum == 145);
+  CHECK(cst::detail::frame_cache::local().reused() - reused == 100);
+}
+
+// A counting iterator written out by hand, what the coroutine saves us from.
+class counting_iterator {
+public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = long long;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const long long*;
+  using reference = const long long&;
+
+  explicit counting_iterator(long long value) : value_(value) {}
+  reference operator*() const { return value_; }
+  counting_iterator& operator++() {
+    ++value_;
+    return *this;
+  }
+  bool operator==(const counting_iterator& other) const { return value_ == other.value_; }
+
+private:
+  long long value_;
+};
+
+cst::generator<long long> count_up(long long n) {
+  for (long long i = 0; i < n; ++i) {
+    co_yield i;
+  }
+}
+
+// 10^8 values (10 x --bench-max-size) produced lazily and summed.
+BENCH_CASE("Coroutines") {
+  const long long n = static_cast<long long>(10 * bench.max_size());
+  bench.items(static_cast<double>(n));
+  bench.run("mutable lambda", [&] {
+    auto next = [x = 0LL]() mutable { return x++; };
+    long long sum = 0;
+    for (long long i = 0; i < n; ++i) sum += next();
+    cst::bench::do_not_optimize(sum);
+  });
+  bench.run("hand-written iterator", [&] {
+    long long sum = 0;
+    for (counting_iterator it(0), end(n); it != end; ++it) sum += *it;
+    cst::bench::do_not_optimize(sum);
+  });
+  bench.run("cst::generator", [&] {
+    long long sum = 0;
+    for (long long x : count_up(n)) sum += x;
+    cst::bench::do_not_optimize(sum);
+  });
+  bench.items(1).run("create and destroy cst::generator", [] {
+    auto gen = count_up(1);
+    cst::bench::do_not_optimize(*gen.begin());
+  });
+}
+
+int async_job() {
+  /* Do something here, then return the result. */
+  return 1000;
+}
+
+template <typename Executor>
+cst::task<int> scheduled_job(Executor ex, cst::cancellation_token token = {}) {
+  co_await ex.schedule(std::move(token));
+  co_return async_job();
+}
+
+cst::task<int> add(cst::task<int> a, cst::task<int> b) {
+  const int x = co_await std::move(a);
+  co_return x + co_await std::move(b);
+}
+
+cst::task<int> failing(cst::event_loop::executor ex) {
+  co_await ex.schedule();
+  throw std::runtime_error("job failed");
+}
+
+// Polls its token between steps, the way long-running work notices cancellation.
+cst::task<int> slow_job(cst::event_loop::executor ex, cst::cancellation_token token, int steps, std::atomic<int>& done) {
+  for (int i = 0; i < steps; ++i) {
+    co_await ex.schedule();
+    if (token.cancellation_requested()) co_return -1;
+    ++done;
+  }
+  co_return steps;
+}
+
+TEST_CASE("Coroutine tasks") {
+  cst::event_loop loop;
+  auto ex = loop.get_executor();
+  CHECK(loop.run_until_complete(add(scheduled_job(ex), scheduled_job(ex))) == 2000);
+  CHECK(loop.pending() == 0);
+
+  // Fan-out/fan-in without a blocked thread per job.
+  std::vector<cst::task<int>> jobs;
+  for (int i = 0; i < 1000; ++i) jobs.push_back(scheduled_job(cst::pool_executor()));
+  auto results = cst::sync_wait(cst::when_all(std::move(jobs)));
+  CHECK(std::accumulate(results.begin(), results.end(), 0) == 1000 * 1000);
+  CHECK(cst::sync_wait(cst::when_all(std::vector<cst::task<int>>{})).empty());
+
+  std::vector<cst::task<int>> mixed;
+  mixed.push_back(scheduled_job(ex));
+  mixed.push_back(failing(ex));
+  CHECK_THROWS_AS(loop.run_until_complete(cst::when_all(std::move(mixed))), std::runtime_error);
+
+  // The first to finish wins and cancels the rest, which stop at their next check.
+  cst::cancellation_source cancel;
+  std::atomic<int> steps{0};
+  std::vector<cst::task<int>> racers;
+  racers.push_back(slow_job(ex, cancel.token(), 100, steps));
+  racers.push_back(slow_job(ex, cancel.token(), 3, steps));
+  racers.push_back(slow_job(ex, cancel.token(), 100, steps));
+  auto first = loop.run_until_complete(cst::when_any(std::move(racers), cancel));
+  CHECK(first.index == 1);
+  CHECK(first.value == 3);
+  CHECK(steps < 12); // the others stopped right after the winner, not after 100 steps
+  CHECK(loop.pending() == 0);
+
+  // A cancelled token makes schedule() throw instead of running the rest of the task.
+  cst::cancellation_source stop;
+  stop.request_cancellation();
+  CHECK_THROWS_AS(cst::sync_wait(scheduled_job(cst::pool_executor(), stop.token())), cst::operation_cancelled);
+
+  std::atomic<int> calls{0};
+  std::vector<cst::task<>> effects;
+  for (int i = 0; i < 10; ++i) {
+    effects.push_back([](cst::pool_executor pool, std::atomic<int>& n) -> cst::task<> {
+      co_await pool.schedule();
+      ++n;
+    }(cst::pool_executor(), calls));
+  }
+  cst::sync_wait(cst::when_all(std::move(effects)));
+  CHECK(calls == 10);
+}
+
+// Threads that ran a job since the last reset, counted once per thread.
+std::atomic<int> job_generation{0};
+std::atomic<int> job_threads{0};
+int counted_job() {
+  thread_local int seen = -1;
+  if (seen != job_generation.load(std::memory_order_relaxed)) {
+    seen = job_generation.load(std::memory_order_relaxed);
+    job_threads.fetch_add(1, std::memory_order_relaxed);
+  }
+  return async_job();
+}
+void reset_job_threads() {
+  job_generation.fetch_add(1);
+  job_threads = 0;
+}
+
+template <typename Executor>
+cst::task<int> counted_task(Executor ex) {
+  co_await ex.schedule();
+  co_return counted_job();
+}
+
+template <typename Executor>
+cst::task<long long> fan_out(Executor ex, std::size_t n) {
+  std::vector<cst::task<int>> jobs;
+  jobs.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) jobs.push_back(counted_task(ex));
+  auto values = co_await cst::when_all(std::move(jobs));
+  co_return std::accumulate(values.begin(), values.end(), 0LL);
+}
+
+// Fan-out/fan-in of 10^5 (--bench-max-size / 100) jobs. "threads" counts the threads that
+// ran jobs; with -DCST_TRACK_ALLOCATIONS=ON, "heap bytes/pending" is the heap in use per
+// job once all of them are in flight.
+BENCH_CASE("Coroutine tasks") {
+  const std::size_t n = static_cast<std::size_t>(bench.max_size() / 100);
+  bench.items(static_cast<double>(n));
+
+  // A std::async thread is joined only when its future is read, so all 10^5 at once run
+  // into the process thread limit; it fans out in waves of 1000 instead.
+  std::size_t pending_bytes = 0;
+  bench.run("std::async (waves of 1000)", [&] {
+    reset_job_threads();
+    long long sum = 0;
+    std::vector<std::future<int>> futures;
+    futures.reserve(1000);
+    for (std::size_t first = 0; first < n; first += 1000) {
+      const std::size_t before = cst::alloc_tracker::live_bytes();
+      for (std::size_t i = first; i < std::min(n, first + 1000); ++i) {
+        futures.push_back(std::async(std::launch::async, counted_job));
+      }
+      pending_bytes = (cst::alloc_tracker::live_bytes() - before) / futures.size();
+      for (auto& f : futures) sum += f.get();
+      futures.clear();
+    }
+    cst::bench::do_not_optimize(sum);
+  });
+  bench.counter("threads", job_threads);
+  if (cst::alloc_tracker::enabled) bench.counter("heap bytes/pending", static_cast<double>(pending_bytes));
+
+  bench.run("thread_pool::submit", [&] {
+    reset_job_threads();
+    const std::size_t before = cst::alloc_tracker::live_bytes();
+    std::vector<std::future<int>> futures;
+    futures.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) futures.push_back(cst::thread_pool::shared().submit(counted_job));
+    pending_bytes = cst::alloc_tracker::live_bytes() - before;
+    long long sum = 0;
+    for (auto& f : futures) sum += f.get();
+    cst::bench::do_not_optimize(sum);
+  });
+  bench.counter("threads", job_threads);
+  if (cst::alloc_tracker::enabled) bench.counter("heap bytes/pending", static_cast<double>(pending_bytes) / n);
+
+  bench.run("task + when_all, pool_executor", [&] {
+    reset_job_threads();
+    cst::bench::do_not_optimize(cst::sync_wait(fan_out(cst::pool_executor(), n)));
+  });
+  bench.counter("threads", job_threads);
+
+  cst::event_loop loop;
+  bench.run("task + when_all, event_loop", [&] {
+    reset_job_threads();
+    const std::size_t before = cst::alloc_tracker::live_bytes();
+    auto all = fan_out(loop.get_executor(), n);
+    // Every job is suspended in the loop's queue when the first one resumes.
+    auto probe = [&]() -> cst::task<long long> {
+      co_await loop.schedule();
+      pending_bytes = cst::alloc_tracker::live_bytes() - before;
+      co_return 0;
+    };
+    std::vector<cst::task<long long>> both;
+    both.push_back(probe());
+    both.push_back(std::move(all));
+    cst::bench::do_not_optimize(loop.run_until_complete(cst::when_all(std::move(both))));
+  });
+  bench.counter("threads", job_threads);
+  if (cst::alloc_tracker::enabled) bench.counter("heap bytes/pending", static_cast<double>(pending_bytes) / n);
+}
+#endif // __cpp_impl_coroutine
+
+template <cst::arithmetic T>
+T constrained_circular_area(T r) {
+  return static_cast<T>(std::numbers::pi * r * r);
+}
+template <typename T>
+concept has_constrained_circular_area = requires(T r) { constrained_circular_area(r); };
+
+// CountTwos from the C++11 tests, with the SIMD path picked by concepts instead of a trait.
+template <cst::arithmetic_range R>
+std::size_t count_twos(const R& numbers) {
+  return cst::count(numbers, 2);
+}
+
+// Owns a heap object through a pointer, nothing points back into it: memcpy is a valid move.
+struct relocatable {
+  cst::instrumented probe;
+};
+template <>
+struct cst::is_trivially_relocatable<relocatable> : std::true_type {};
+
 TEST_CASE("Concepts") {
+  CHECK(constrained_circular_area(2) == 12);
+  CHECK(constrained_circular_area(2.0) == doctest::Approx(4 * std::numbers::pi));
+  static_assert(!has_constrained_circular_area<std::string>);
+
+  static_assert(cst::simd_range<std::vector<int>>);
+  static_assert(cst::simd_range<double[4]>);
+  static_assert(cst::simd_range<cst::span<const float>>);
+  static_assert(cst::contiguous_arithmetic_range<std::vector<short>> && !cst::simd_range<std::vector<short>>);
+  static_assert(cst::arithmetic_range<std::list<int>> && !cst::contiguous_arithmetic_range<std::list<int>>);
+  static_assert(!cst::arithmetic_range<std::vector<std::string>>);
+
+  std::vector<int> v {2, 2, 43, 435, 4543, 534};
+  std::list<int> l(v.begin(), v.end());
+  std::vector<short> s(v.begin(), v.end());
+  CHECK(count_twos(v) == 2);
+  CHECK(count_twos(l) == 2);
+  CHECK(count_twos(s) == 2);
+  CHECK(cst::sum(v) == 5559);
+  CHECK(cst::sum(l) == 5559);
+  CHECK(cst::sum(std::vector<double>{0.5, 1.5}) == 2.0);
 
+  std::vector<int> out(6);
+  CHECK(cst::add(v, s, out) == 6);
+  CHECK(out[5] == 1068);
+  std::list<int> tail(3);
+  CHECK(cst::add(v, l, tail) == 3); // stops at the shortest range
+  CHECK(tail.back() == 86);
 
+  static_assert(cst::trivially_relocatable<int> && cst::trivially_relocatable<std::unique_ptr<int>>);
+  static_assert(!cst::trivially_relocatable<cst::small_vector<int, 4>>); // points into itself
+  cst::lifecycle_scope scope;
+  {
+    cst::small_vector<cst::instrumented, 2> moved;
+    cst::small_vector<relocatable, 2> copied;
+    for (int i = 0; i < 100; ++i) {
+      moved.emplace_back(i);
+      copied.push_back({cst::instrumented(i)});
+    }
+    CHECK(copied[99].probe.value() == 99);
+  }
+  // Growing moves every element of `moved` and destroys the husks; `copied` only memcpys.
+  CHECK(scope.counts().move_constructions == (2 + 4 + 8 + 16 + 32 + 64) + 100);
+  CHECK(scope.counts().live() == 0);
+}
+
+struct owner {
+  std::unique_ptr<int> p;
+  int x = 0;
+};
+struct relocatable_owner {
+  std::unique_ptr<int> p;
+  int x = 0;
+};
+template <>
+struct cst::is_trivially_relocatable<relocatable_owner> : std::true_type {};
+
+template <typename T>
+void ping_pong(cst::bench::Bench& bench, const std::string& name, std::size_t n) {
+  std::allocator<T> alloc;
+  T* a = alloc.allocate(n);
+  T* b = alloc.allocate(n);
+  std::uninitialized_value_construct_n(a, n);
+  bench.run(name, [&] {
+    cst::relocate(a, n, b);
+    cst::relocate(b, n, a);
+    cst::bench::do_not_optimize(a);
+  });
+  std::destroy_n(a, n);
+  alloc.deallocate(b, n);
+  alloc.deallocate(a, n);
+}
+
+// Generic loops against the overloads the concepts select for contiguous ranges.
+BENCH_CASE("Concepts") {
+  const std::size_t n = bench.max_size();
+  std::vector<int> a(n), b(n), out(n);
+  std::iota(a.begin(), a.end(), 0);
+  for (std::size_t i = 0; i < n; ++i) b[i] = static_cast<int>(i % 7);
+  // Same elements, but only random access: the arithmetic_range overloads.
+  auto a_view = a | std::views::transform(std::identity{});
+  auto b_view = b | std::views::transform(std::identity{});
+
+  bench.items(static_cast<double>(n)).bytes(static_cast<double>(n * sizeof(int)));
+  bench.run("sum, std::accumulate", [&] { cst::bench::do_not_optimize(std::accumulate(a.begin(), a.end(), 0)); });
+  bench.run("sum, arithmetic_range", [&] { cst::bench::do_not_optimize(cst::sum(a_view)); });
+  bench.run("sum, simd_range", [&] { cst::bench::do_not_optimize(cst::sum(a)); });
+  bench.run("count, std::count", [&] { cst::bench::do_not_optimize(std::count(b.begin(), b.end(), 2)); });
+  bench.run("count, arithmetic_range", [&] { cst::bench::do_not_optimize(cst::count(b_view, 2)); });
+  bench.run("count, simd_range", [&] { cst::bench::do_not_optimize(cst::count(b, 2)); });
+  bench.bytes(static_cast<double>(3 * n * sizeof(int)));
+  bench.run("add, arithmetic_range", [&] {
+    cst::add(a_view, b_view, out);
+    cst::bench::do_not_optimize(out.data());
+  });
+  bench.run("add, contiguous_arithmetic_range", [&] {
+    cst::add(a, b, out);
+    cst::bench::do_not_optimize(out.data());
+  });
+
+  // What a growing container does with its elements, back and forth between two buffers.
+  bench.bytes(static_cast<double>(2 * n * sizeof(owner))).items(static_cast<double>(2 * n));
+  ping_pong<owner>(bench, "relocate, move + destroy", n);
+  ping_pong<relocatable_owner>(bench, "relocate, trivially_relocatable", n);
 }
 
 struct A {
@@ -31,6 +476,11 @@ TEST_CASE("Template syntax for lambdas") {
     };
     std::vector<int> v {1,2,3};
     f(v);
+
+    // Short sequences without the heap allocation; N is deduced as well.
+    auto g = []<typename T, std::size_t N>(const cst::small_vector<T, N>& v) { return v.size() + N; };
+    cst::small_vector<int, 4> sv {1,2,3};
+    CHECK(g(sv) == 7);
 }
 
 
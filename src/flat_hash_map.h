@@ -0,0 +1,550 @@
+#pragma once
+
+// Open-addressing hash map in the style of Swiss tables (abseil, folly F14): one control
+// byte per slot holds 7 bits of the hash, and lookups compare 16 control bytes at once
+// (SSE2 when available), so a lookup usually touches one control group and one slot
+// instead of chasing bucket list pointers like std::unordered_map.
+//
+// The interface follows std::unordered_map except for the bucket interface and
+// allocators; iterators and references are invalidated by every rehash.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CST_FLAT_HASH_MAP_SSE2 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace cst {
+namespace detail {
+
+using ctrl_t = std::int8_t;
+constexpr ctrl_t ctrl_empty = -128;  // 0b10000000
+constexpr ctrl_t ctrl_deleted = -2;  // 0b11111110
+// Full slots store the low 7 bits of the hash: 0b0xxxxxxx.
+
+inline unsigned count_trailing_zeros(std::uint32_t x) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, x);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(x));
+#endif
+}
+
+// Bit i is set when control byte i of the group matched.
+class group_mask {
+public:
+  explicit group_mask(std::uint32_t bits) : bits_(bits) {}
+  explicit operator bool() const { return bits_ != 0; }
+  unsigned lowest() const { return count_trailing_zeros(bits_); }
+  group_mask& operator++() {
+    bits_ &= bits_ - 1;
+    return *this;
+  }
+
+private:
+  std::uint32_t bits_;
+};
+
+struct group {
+  static constexpr std::size_t width = 16;
+
+#ifdef CST_FLAT_HASH_MAP_SSE2
+  explicit group(const ctrl_t* pos) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+  group_mask match(ctrl_t h2) const {
+    return group_mask(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl))));
+  }
+  group_mask match_empty() const {
+    return group_mask(
+        static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(ctrl_empty), ctrl))));
+  }
+  // Empty and deleted bytes are the only negative ones.
+  group_mask match_empty_or_deleted() const { return group_mask(static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl))); }
+
+  __m128i ctrl;
+#else
+  explicit group(const ctrl_t* pos) { std::copy(pos, pos + width, ctrl); }
+  group_mask match(ctrl_t h2) const {
+    std::uint32_t bits = 0;
+    for (std::size_t i = 0; i < width; ++i) bits |= static_cast<std::uint32_t>(ctrl[i] == h2) << i;
+    return group_mask(bits);
+  }
+  group_mask match_empty() const { return match(ctrl_empty); }
+  group_mask match_empty_or_deleted() const {
+    std::uint32_t bits = 0;
+    for (std::size_t i = 0; i < width; ++i) bits |= static_cast<std::uint32_t>(ctrl[i] < 0) << i;
+    return group_mask(bits);
+  }
+
+  ctrl_t ctrl[width];
+#endif
+};
+
+// std::hash is the identity for integers on libstdc++; spread it over all bits.
+inline std::size_t mix_hash(std::size_t h) {
+  std::uint64_t x = static_cast<std::uint64_t>(h) * 0x9E3779B97F4A7C15ull;
+  return static_cast<std::size_t>(x ^ (x >> 32));
+}
+
+} // namespace detail
+
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class flat_hash_map {
+  // Both members share the layout; mutable_value lets a rehash move the key out, the
+  // same trick abseil's node-less maps use.
+  union slot_type {
+    slot_type() {}
+    ~slot_type() {}
+    std::pair<const Key, T> value;
+    std::pair<Key, T> mutable_value;
+  };
+  using ctrl_t = detail::ctrl_t;
+  using group = detail::group;
+
+public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+
+  template <bool Const>
+  class basic_iterator {
+    friend class flat_hash_map;
+    using slot_ptr = std::conditional_t<Const, const slot_type*, slot_type*>;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = flat_hash_map::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<Const, const value_type&, value_type&>;
+    using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+    basic_iterator() = default;
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    basic_iterator(const basic_iterator<false>& o) : ctrl_(o.ctrl_), end_(o.end_), slot_(o.slot_) {}
+
+    reference operator*() const { return slot_->value; }
+    pointer operator->() const { return &slot_->value; }
+    basic_iterator& operator++() {
+      ++ctrl_;
+      ++slot_;
+      skip_empty();
+      return *this;
+    }
+    basic_iterator operator++(int) {
+      auto tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.ctrl_ == b.ctrl_; }
+    friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return a.ctrl_ != b.ctrl_; }
+
+  private:
+    basic_iterator(const ctrl_t* ctrl, const ctrl_t* end, slot_ptr slot) : ctrl_(ctrl), end_(end), slot_(slot) {}
+    void skip_empty() {
+      while (ctrl_ != end_ && *ctrl_ < 0) {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+
+    const ctrl_t* ctrl_ = nullptr;
+    const ctrl_t* end_ = nullptr;
+    slot_ptr slot_ = nullptr;
+  };
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  flat_hash_map() = default;
+  explicit flat_hash_map(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& eq = KeyEqual())
+      : hash_(hash), eq_(eq) {
+    reserve(bucket_count);
+  }
+  template <typename InputIt>
+  flat_hash_map(InputIt first, InputIt last, size_type bucket_count = 0) {
+    reserve(bucket_count);
+    insert(first, last);
+  }
+  flat_hash_map(std::initializer_list<value_type> init, size_type bucket_count = 0)
+      : flat_hash_map(init.begin(), init.end(), std::max(bucket_count, init.size())) {}
+  flat_hash_map(const flat_hash_map& o) : hash_(o.hash_), eq_(o.eq_) {
+    reserve(o.size());
+    for (const auto& v : o) {
+      emplace_new(v.first, v);
+    }
+  }
+  flat_hash_map(flat_hash_map&& o) noexcept
+      : ctrl_(std::exchange(o.ctrl_, nullptr)), slots_(std::exchange(o.slots_, nullptr)),
+        capacity_(std::exchange(o.capacity_, 0)), size_(std::exchange(o.size_, 0)),
+        growth_left_(std::exchange(o.growth_left_, 0)), hash_(std::move(o.hash_)), eq_(std::move(o.eq_)) {}
+  flat_hash_map& operator=(const flat_hash_map& o) {
+    if (this != &o) {
+      flat_hash_map tmp(o);
+      swap(tmp);
+    }
+    return *this;
+  }
+  flat_hash_map& operator=(flat_hash_map&& o) noexcept {
+    flat_hash_map tmp(std::move(o));
+    swap(tmp);
+    return *this;
+  }
+  flat_hash_map& operator=(std::initializer_list<value_type> init) {
+    clear();
+    insert(init);
+    return *this;
+  }
+  ~flat_hash_map() { destroy(); }
+
+  iterator begin() { return make_begin<iterator>(slots_); }
+  const_iterator begin() const { return make_begin<const_iterator>(static_cast<const slot_type*>(slots_)); }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator(ctrl_ + capacity_, ctrl_ + capacity_, slots_ + capacity_); }
+  const_iterator end() const { return const_iterator(ctrl_ + capacity_, ctrl_ + capacity_, slots_ + capacity_); }
+  const_iterator cend() const { return end(); }
+
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+  size_type max_size() const { return std::numeric_limits<difference_type>::max() / sizeof(slot_type); }
+  size_type capacity() const { return capacity_; }
+  size_type bucket_count() const { return capacity_; }
+  float load_factor() const { return capacity_ == 0 ? 0.0f : static_cast<float>(size_) / capacity_; }
+  float max_load_factor() const { return 7.0f / 8.0f; }
+  hasher hash_function() const { return hash_; }
+  key_equal key_eq() const { return eq_; }
+
+  void clear() {
+    for (size_type i = 0; i < capacity_; ++i) {
+      if (ctrl_[i] >= 0) {
+        slots_[i].value.~value_type();
+      }
+    }
+    if (capacity_ != 0) {
+      std::fill(ctrl_, ctrl_ + capacity_ + group::width, detail::ctrl_empty);
+    }
+    size_ = 0;
+    growth_left_ = max_load(capacity_);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& v) { return emplace_key(v.first, v); }
+  std::pair<iterator, bool> insert(value_type&& v) { return emplace_key(v.first, std::move(v)); }
+  template <typename P, typename = std::enable_if_t<std::is_constructible<value_type, P&&>::value>>
+  std::pair<iterator, bool> insert(P&& v) {
+    return emplace(std::forward<P>(v));
+  }
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+  void insert(std::initializer_list<value_type> init) { insert(init.begin(), init.end()); }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    value_type v(std::forward<Args>(args)...);
+    return emplace_key(v.first, std::move(v));
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+    return emplace_key(key, std::piecewise_construct, std::forward_as_tuple(key),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+    return emplace_key(key, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj) {
+    auto r = try_emplace(key, std::forward<M>(obj));
+    if (!r.second) {
+      r.first->second = std::forward<M>(obj);
+    }
+    return r;
+  }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj) {
+    auto r = try_emplace(std::move(key), std::forward<M>(obj));
+    if (!r.second) {
+      r.first->second = std::forward<M>(obj);
+    }
+    return r;
+  }
+
+  T& operator[](const key_type& key) { return try_emplace(key).first->second; }
+  T& operator[](key_type&& key) { return try_emplace(std::move(key)).first->second; }
+  T& at(const key_type& key) {
+    auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("cst::flat_hash_map::at");
+    }
+    return it->second;
+  }
+  const T& at(const key_type& key) const { return const_cast<flat_hash_map*>(this)->at(key); }
+
+  iterator find(const key_type& key) {
+    size_type i = find_index(key, hash_key(key));
+    return i == capacity_ ? end() : iterator_at(i);
+  }
+  const_iterator find(const key_type& key) const { return const_cast<flat_hash_map*>(this)->find(key); }
+  bool contains(const key_type& key) const { return find_index(key, hash_key(key)) != capacity_; }
+  size_type count(const key_type& key) const { return contains(key) ? 1 : 0; }
+
+  size_type erase(const key_type& key) {
+    size_type i = find_index(key, hash_key(key));
+    if (i == capacity_) {
+      return 0;
+    }
+    erase_at(i);
+    return 1;
+  }
+  iterator erase(const_iterator pos) {
+    size_type i = static_cast<size_type>(pos.ctrl_ - ctrl_);
+    erase_at(i);
+    auto it = iterator_at(i);
+    it.skip_empty();
+    return it;
+  }
+  iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+  iterator erase(const_iterator first, const_iterator last) {
+    while (first != last) {
+      first = erase(first);
+    }
+    return iterator_at(static_cast<size_type>(last.ctrl_ - ctrl_));
+  }
+
+  void swap(flat_hash_map& o) noexcept {
+    using std::swap;
+    swap(ctrl_, o.ctrl_);
+    swap(slots_, o.slots_);
+    swap(capacity_, o.capacity_);
+    swap(size_, o.size_);
+    swap(growth_left_, o.growth_left_);
+    swap(hash_, o.hash_);
+    swap(eq_, o.eq_);
+  }
+
+  // Makes room for n elements without further rehashing.
+  void reserve(size_type n) {
+    if (n > size_ + growth_left_) {
+      rehash(capacity_for(n));
+    }
+  }
+  void rehash(size_type buckets) {
+    buckets = std::max(buckets, capacity_for(size_));
+    if (buckets != 0) {
+      resize(capacity_for_buckets(buckets));
+    }
+  }
+
+  friend bool operator==(const flat_hash_map& a, const flat_hash_map& b) {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (const auto& v : a) {
+      auto it = b.find(v.first);
+      if (it == b.end() || !(it->second == v.second)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  friend bool operator!=(const flat_hash_map& a, const flat_hash_map& b) { return !(a == b); }
+  friend void swap(flat_hash_map& a, flat_hash_map& b) noexcept { a.swap(b); }
+
+private:
+  static size_type max_load(size_type capacity) { return capacity - capacity / 8; }
+  static size_type capacity_for_buckets(size_type buckets) {
+    size_type c = group::width;
+    while (c < buckets) {
+      c *= 2;
+    }
+    return c;
+  }
+  static size_type capacity_for(size_type n) {
+    if (n == 0) {
+      return 0;
+    }
+    size_type c = group::width;
+    while (max_load(c) < n) {
+      c *= 2;
+    }
+    return c;
+  }
+
+  size_type hash_key(const key_type& key) const { return detail::mix_hash(hash_(key)); }
+  static ctrl_t h2(size_type hash) { return static_cast<ctrl_t>(hash & 0x7f); }
+  static size_type h1(size_type hash) { return hash >> 7; }
+
+  template <typename It, typename Slot>
+  It make_begin(Slot* slots) const {
+    It it(ctrl_, ctrl_ + capacity_, slots);
+    it.skip_empty();
+    return it;
+  }
+  iterator iterator_at(size_type i) { return iterator(ctrl_ + i, ctrl_ + capacity_, slots_ + i); }
+
+  // Groups are visited in triangular steps, which covers the whole table because the
+  // number of groups is a power of two.
+  size_type find_index(const key_type& key, size_type hash) const {
+    if (capacity_ == 0) {
+      return 0;
+    }
+    const size_type mask = capacity_ - 1;
+    size_type pos = h1(hash) & mask;
+    for (size_type step = group::width;; step += group::width) {
+      group g(ctrl_ + pos);
+      for (auto m = g.match(h2(hash)); m; ++m) {
+        size_type i = (pos + m.lowest()) & mask;
+        if (eq_(slots_[i].value.first, key)) {
+          return i;
+        }
+      }
+      if (g.match_empty()) {
+        return capacity_;
+      }
+      pos = (pos + step) & mask;
+    }
+  }
+
+  size_type find_free(size_type hash) const {
+    const size_type mask = capacity_ - 1;
+    size_type pos = h1(hash) & mask;
+    for (size_type step = group::width;; step += group::width) {
+      if (auto m = group(ctrl_ + pos).match_empty_or_deleted()) {
+        return (pos + m.lowest()) & mask;
+      }
+      pos = (pos + step) & mask;
+    }
+  }
+
+  void set_ctrl(size_type i, ctrl_t c) {
+    ctrl_[i] = c;
+    // The first group is mirrored after the end so that loads never wrap around.
+    if (i < group::width) {
+      ctrl_[capacity_ + i] = c;
+    }
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace_key(const key_type& key, Args&&... args) {
+    size_type hash = hash_key(key);
+    size_type i = find_index(key, hash);
+    if (capacity_ != 0 && i != capacity_) {
+      return {iterator_at(i), false};
+    }
+    return {iterator_at(insert_new(hash, std::forward<Args>(args)...)), true};
+  }
+
+  // For keys known to be absent (copy construction).
+  template <typename... Args>
+  void emplace_new(const key_type& key, Args&&... args) {
+    insert_new(hash_key(key), std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  size_type insert_new(size_type hash, Args&&... args) {
+    size_type i = capacity_ == 0 ? 0 : find_free(hash);
+    if (capacity_ == 0 || (growth_left_ == 0 && ctrl_[i] == detail::ctrl_empty)) {
+      grow();
+      i = find_free(hash);
+    }
+    ::new (static_cast<void*>(&slots_[i].value)) value_type(std::forward<Args>(args)...);
+    if (ctrl_[i] == detail::ctrl_empty) {
+      --growth_left_;
+    }
+    set_ctrl(i, h2(hash));
+    ++size_;
+    return i;
+  }
+
+  // Tombstones count against the load; when they make up a large part of it, rehashing
+  // at the same capacity is enough.
+  void grow() {
+    if (capacity_ != 0 && size_ <= capacity_ * 7 / 16) {
+      resize(capacity_);
+    } else {
+      resize(capacity_ == 0 ? group::width : capacity_ * 2);
+    }
+  }
+
+  void erase_at(size_type i) {
+    slots_[i].value.~value_type();
+    set_ctrl(i, detail::ctrl_deleted);
+    --size_;
+  }
+
+  void resize(size_type new_capacity) {
+    ctrl_t* old_ctrl = ctrl_;
+    slot_type* old_slots = slots_;
+    size_type old_capacity = capacity_;
+
+    ctrl_ = new ctrl_t[new_capacity + group::width];
+    std::fill(ctrl_, ctrl_ + new_capacity + group::width, detail::ctrl_empty);
+    slots_ = std::allocator<slot_type>().allocate(new_capacity);
+    capacity_ = new_capacity;
+    growth_left_ = max_load(new_capacity) - size_;
+
+    for (size_type i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] >= 0) {
+        size_type hash = hash_key(old_slots[i].value.first);
+        size_type j = find_free(hash);
+        ::new (static_cast<void*>(&slots_[j].mutable_value)) std::pair<Key, T>(std::move(old_slots[i].mutable_value));
+        old_slots[i].mutable_value.~pair();
+        set_ctrl(j, h2(hash));
+      }
+    }
+    if (old_capacity != 0) {
+      delete[] old_ctrl;
+      std::allocator<slot_type>().deallocate(old_slots, old_capacity);
+    }
+  }
+
+  void destroy() {
+    if (capacity_ == 0) {
+      return;
+    }
+    clear();
+    delete[] ctrl_;
+    std::allocator<slot_type>().deallocate(slots_, capacity_);
+    ctrl_ = nullptr;
+    slots_ = nullptr;
+    capacity_ = 0;
+    growth_left_ = 0;
+  }
+
+  ctrl_t* ctrl_ = nullptr;
+  slot_type* slots_ = nullptr;
+  size_type capacity_ = 0;  // 0 or a power of two >= group::width
+  size_type size_ = 0;
+  size_type growth_left_ = 0;
+  Hash hash_;
+  KeyEqual eq_;
+};
+
+} // namespace cst
@@ -0,0 +1,400 @@
+#pragma once
+
+// Sorted-vector associative containers, in the spirit of boost::container::flat_map and
+// C++23 std::flat_map. Elements are stored contiguously, so small keys cost no node
+// overhead and iteration is a linear scan; single inserts and erases are O(n), bulk
+// inserts and merges are O(n + m log m) and O(n + m).
+//
+//   cst::flat_map<int, std::string> dst {{3, "three"}};
+//   dst.insert(cst::sorted_unique, src.begin(), src.end()); // src already sorted
+//   dst.merge(other);                                       // linear, like std::map::merge
+//
+// flat_map iterators expose pair<Key, T>&, the key must not be modified through them.
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace cst {
+
+// Tag for ranges that are already sorted by the container's comparator and free of
+// duplicates.
+struct sorted_unique_t {
+  explicit sorted_unique_t() = default;
+};
+inline constexpr sorted_unique_t sorted_unique{};
+
+namespace detail {
+
+struct identity_key {
+  template <typename T>
+  const T& operator()(const T& v) const { return v; }
+};
+
+struct first_key {
+  template <typename P>
+  const typename P::first_type& operator()(const P& v) const { return v.first; }
+};
+
+// Shared implementation of flat_set and flat_map.
+template <typename Value, typename Key, typename KeyOf, typename Compare, typename Allocator>
+class flat_tree {
+public:
+  using key_type = Key;
+  using value_type = Value;
+  using key_compare = Compare;
+  using allocator_type = Allocator;
+  using container_type = std::vector<Value, Allocator>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using iterator = typename container_type::iterator;
+  using const_iterator = typename container_type::const_iterator;
+  using reverse_iterator = typename container_type::reverse_iterator;
+  using const_reverse_iterator = typename container_type::const_reverse_iterator;
+
+  flat_tree() = default;
+  explicit flat_tree(const Compare& comp, const Allocator& alloc = Allocator()) : data_(alloc), comp_(comp) {}
+  explicit flat_tree(const Allocator& alloc) : data_(alloc) {}
+
+  iterator begin() noexcept { return data_.begin(); }
+  const_iterator begin() const noexcept { return data_.begin(); }
+  const_iterator cbegin() const noexcept { return data_.begin(); }
+  iterator end() noexcept { return data_.end(); }
+  const_iterator end() const noexcept { return data_.end(); }
+  const_iterator cend() const noexcept { return data_.end(); }
+  reverse_iterator rbegin() noexcept { return data_.rbegin(); }
+  const_reverse_iterator rbegin() const noexcept { return data_.rbegin(); }
+  reverse_iterator rend() noexcept { return data_.rend(); }
+  const_reverse_iterator rend() const noexcept { return data_.rend(); }
+
+  bool empty() const noexcept { return data_.empty(); }
+  size_type size() const noexcept { return data_.size(); }
+  size_type max_size() const noexcept { return data_.max_size(); }
+  size_type capacity() const noexcept { return data_.capacity(); }
+  void reserve(size_type n) { data_.reserve(n); }
+  void shrink_to_fit() { data_.shrink_to_fit(); }
+  void clear() noexcept { data_.clear(); }
+  allocator_type get_allocator() const { return data_.get_allocator(); }
+  key_compare key_comp() const { return comp_; }
+
+  // Direct access to the sorted storage.
+  const container_type& sequence() const noexcept { return data_; }
+  // Moves the storage out and leaves the container empty.
+  container_type extract() && {
+    container_type out = std::move(data_);
+    data_.clear();
+    return out;
+  }
+  // Adopts storage that is already sorted and unique.
+  void replace(container_type&& sorted) { data_ = std::move(sorted); }
+
+  iterator find(const key_type& key) {
+    auto it = lower_bound(key);
+    return it != end() && !comp_(key, key_of(*it)) ? it : end();
+  }
+  const_iterator find(const key_type& key) const { return const_cast<flat_tree*>(this)->find(key); }
+  bool contains(const key_type& key) const { return find(key) != end(); }
+  size_type count(const key_type& key) const { return contains(key) ? 1 : 0; }
+  iterator lower_bound(const key_type& key) {
+    return std::lower_bound(begin(), end(), key, [this](const value_type& v, const key_type& k) {
+      return comp_(key_of(v), k);
+    });
+  }
+  const_iterator lower_bound(const key_type& key) const { return const_cast<flat_tree*>(this)->lower_bound(key); }
+  iterator upper_bound(const key_type& key) {
+    return std::upper_bound(begin(), end(), key, [this](const key_type& k, const value_type& v) {
+      return comp_(k, key_of(v));
+    });
+  }
+  const_iterator upper_bound(const key_type& key) const { return const_cast<flat_tree*>(this)->upper_bound(key); }
+  std::pair<iterator, iterator> equal_range(const key_type& key) {
+    auto first = lower_bound(key);
+    auto last = first != end() && !comp_(key, key_of(*first)) ? std::next(first) : first;
+    return {first, last};
+  }
+
+  std::pair<iterator, bool> insert(const value_type& v) { return insert_unique(key_of(v), v); }
+  std::pair<iterator, bool> insert(value_type&& v) { return insert_unique(key_of(v), std::move(v)); }
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    value_type v(std::forward<Args>(args)...);
+    return insert_unique(key_of(v), std::move(v));
+  }
+
+  // Bulk insert: appends, sorts only the new elements and merges in place. Elements
+  // whose key is already present are dropped, as with repeated single inserts.
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    auto mid = data_.size();
+    data_.insert(data_.end(), first, last);
+    std::stable_sort(data_.begin() + mid, data_.end(), value_less());
+    merge_tail(mid);
+  }
+  template <typename InputIt>
+  void insert(sorted_unique_t, InputIt first, InputIt last) {
+    auto mid = data_.size();
+    data_.insert(data_.end(), first, last);
+    merge_tail(mid);
+  }
+  void insert(std::initializer_list<value_type> init) { insert(init.begin(), init.end()); }
+
+  iterator erase(const_iterator pos) { return data_.erase(pos); }
+  iterator erase(iterator pos) { return data_.erase(pos); }
+  iterator erase(const_iterator first, const_iterator last) { return data_.erase(first, last); }
+  size_type erase(const key_type& key) {
+    auto it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+    data_.erase(it);
+    return 1;
+  }
+
+  // Moves every element whose key is not yet present out of `source`, in one linear
+  // pass over both containers; the duplicates stay in `source` (std::set::merge rules).
+  void merge(flat_tree& source) {
+    if (&source == this || source.empty()) {
+      return;
+    }
+    container_type merged(data_.get_allocator());
+    merged.reserve(data_.size() + source.data_.size());
+    container_type rest(source.data_.get_allocator());
+    auto a = data_.begin();
+    auto b = source.data_.begin();
+    while (a != data_.end() && b != source.data_.end()) {
+      if (comp_(key_of(*a), key_of(*b))) {
+        merged.push_back(std::move(*a++));
+      } else if (comp_(key_of(*b), key_of(*a))) {
+        merged.push_back(std::move(*b++));
+      } else {
+        rest.push_back(std::move(*b++));
+      }
+    }
+    std::move(a, data_.end(), std::back_inserter(merged));
+    std::move(b, source.data_.end(), std::back_inserter(merged));
+    data_.swap(merged);
+    source.data_.swap(rest);
+  }
+
+  void swap(flat_tree& o) noexcept {
+    using std::swap;
+    data_.swap(o.data_);
+    swap(comp_, o.comp_);
+  }
+
+  friend bool operator==(const flat_tree& a, const flat_tree& b) { return a.data_ == b.data_; }
+  friend bool operator!=(const flat_tree& a, const flat_tree& b) { return a.data_ != b.data_; }
+  friend bool operator<(const flat_tree& a, const flat_tree& b) { return a.data_ < b.data_; }
+
+protected:
+  static const key_type& key_of(const value_type& v) { return KeyOf()(v); }
+
+  auto value_less() const {
+    return [this](const value_type& a, const value_type& b) { return comp_(key_of(a), key_of(b)); };
+  }
+
+  template <typename V>
+  std::pair<iterator, bool> insert_unique(const key_type& key, V&& v) {
+    auto it = lower_bound(key);
+    if (it != end() && !comp_(key, key_of(*it))) {
+      return {it, false};
+    }
+    return {data_.insert(it, std::forward<V>(v)), true};
+  }
+
+  // [0, mid) and [mid, end) are sorted; merge them and drop later duplicates.
+  void merge_tail(std::size_t mid) {
+    std::inplace_merge(data_.begin(), data_.begin() + mid, data_.end(), value_less());
+    auto last = std::unique(data_.begin(), data_.end(), [this](const value_type& a, const value_type& b) {
+      return !comp_(key_of(a), key_of(b)) && !comp_(key_of(b), key_of(a));
+    });
+    data_.erase(last, data_.end());
+  }
+
+  void sort_unique() {
+    std::stable_sort(data_.begin(), data_.end(), value_less());
+    merge_tail(data_.size());
+  }
+
+  container_type data_;
+  Compare comp_;
+};
+
+} // namespace detail
+
+// Holds an element extracted from a flat container, the counterpart of the node handle
+// of std::map::extract. The key may be changed before inserting it back.
+template <typename Value>
+class flat_node {
+public:
+  flat_node() = default;
+  explicit flat_node(Value&& v) : value_(std::move(v)) {}
+
+  bool empty() const noexcept { return !value_; }
+  explicit operator bool() const noexcept { return value_.has_value(); }
+
+  // flat_set
+  Value& value() { return *value_; }
+  // flat_map
+  template <typename V = Value>
+  typename V::first_type& key() { return value_->first; }
+  template <typename V = Value>
+  typename V::second_type& mapped() { return value_->second; }
+
+  Value take() {
+    Value v = std::move(*value_);
+    value_.reset();
+    return v;
+  }
+
+private:
+  std::optional<Value> value_;
+};
+
+template <typename Iterator, typename Node>
+struct flat_insert_return {
+  Iterator position;
+  bool inserted;
+  Node node;
+};
+
+template <typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key>>
+class flat_set : public detail::flat_tree<Key, Key, detail::identity_key, Compare, Allocator> {
+  using base = detail::flat_tree<Key, Key, detail::identity_key, Compare, Allocator>;
+
+public:
+  using typename base::container_type;
+  using typename base::iterator;
+  using typename base::value_type;
+  using node_type = flat_node<Key>;
+  using insert_return_type = flat_insert_return<iterator, node_type>;
+  using base::erase;
+  using base::extract;
+  using base::insert;
+
+  flat_set() = default;
+  explicit flat_set(const Allocator& alloc) : base(alloc) {}
+  template <typename InputIt>
+  flat_set(InputIt first, InputIt last, const Compare& comp = Compare()) : base(comp) {
+    this->data_.assign(first, last);
+    this->sort_unique();
+  }
+  template <typename InputIt>
+  flat_set(sorted_unique_t, InputIt first, InputIt last, const Compare& comp = Compare()) : base(comp) {
+    this->data_.assign(first, last);
+  }
+  flat_set(std::initializer_list<Key> init, const Compare& comp = Compare())
+      : flat_set(init.begin(), init.end(), comp) {}
+
+  node_type extract(const Key& key) {
+    auto it = this->find(key);
+    return it == this->end() ? node_type() : extract(it);
+  }
+  node_type extract(iterator pos) {
+    node_type node(std::move(*pos));
+    this->data_.erase(pos);
+    return node;
+  }
+  insert_return_type insert(node_type&& node) {
+    if (node.empty()) {
+      return {this->end(), false, node_type()};
+    }
+    auto it = this->lower_bound(node.value());
+    if (it != this->end() && !this->comp_(node.value(), *it)) {
+      return {it, false, std::move(node)};
+    }
+    return {this->data_.insert(it, node.take()), true, node_type()};
+  }
+};
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<std::pair<Key, T>>>
+class flat_map : public detail::flat_tree<std::pair<Key, T>, Key, detail::first_key, Compare, Allocator> {
+  using base = detail::flat_tree<std::pair<Key, T>, Key, detail::first_key, Compare, Allocator>;
+
+public:
+  using mapped_type = T;
+  using typename base::container_type;
+  using typename base::iterator;
+  using typename base::value_type;
+  using node_type = flat_node<value_type>;
+  using insert_return_type = flat_insert_return<iterator, node_type>;
+  using base::erase;
+  using base::extract;
+  using base::insert;
+
+  flat_map() = default;
+  explicit flat_map(const Allocator& alloc) : base(alloc) {}
+  template <typename InputIt>
+  flat_map(InputIt first, InputIt last, const Compare& comp = Compare()) : base(comp) {
+    this->data_.assign(first, last);
+    this->sort_unique();
+  }
+  template <typename InputIt>
+  flat_map(sorted_unique_t, InputIt first, InputIt last, const Compare& comp = Compare()) : base(comp) {
+    this->data_.assign(first, last);
+  }
+  flat_map(std::initializer_list<value_type> init, const Compare& comp = Compare())
+      : flat_map(init.begin(), init.end(), comp) {}
+
+  T& operator[](const Key& key) { return try_emplace(key).first->second; }
+  T& at(const Key& key) {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      throw std::out_of_range("cst::flat_map::at");
+    }
+    return it->second;
+  }
+  const T& at(const Key& key) const { return const_cast<flat_map*>(this)->at(key); }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+    auto it = this->lower_bound(key);
+    if (it != this->end() && !this->comp_(key, it->first)) {
+      return {it, false};
+    }
+    return {this->data_.emplace(it, std::piecewise_construct, std::forward_as_tuple(key),
+                                std::forward_as_tuple(std::forward<Args>(args)...)),
+            true};
+  }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) {
+    auto r = try_emplace(key, std::forward<M>(obj));
+    if (!r.second) {
+      r.first->second = std::forward<M>(obj);
+    }
+    return r;
+  }
+
+  node_type extract(const Key& key) {
+    auto it = this->find(key);
+    return it == this->end() ? node_type() : extract(it);
+  }
+  node_type extract(iterator pos) {
+    node_type node(std::move(*pos));
+    this->data_.erase(pos);
+    return node;
+  }
+  insert_return_type insert(node_type&& node) {
+    if (node.empty()) {
+      return {this->end(), false, node_type()};
+    }
+    auto it = this->lower_bound(node.key());
+    if (it != this->end() && !this->comp_(node.key(), it->first)) {
+      return {it, false, std::move(node)};
+    }
+    return {this->data_.insert(it, node.take()), true, node_type()};
+  }
+};
+
+} // namespace cst
@@ -0,0 +1,110 @@
+#pragma once
+
+// Shortest round-trip formatting of floating point numbers into caller buffers:
+//
+//   char buf[cst::max_float_chars<double>];
+//   std::string_view s = cst::format_float(1.2, buf);  // "1.2", std::to_string gives "1.200000"
+//   cst::append_floats(values, json, ',');             // a whole vector, one allocation at most
+//
+// The output is the shortest string that parses back to the same value (std::to_chars
+// without a format, Ryu underneath in the common standard libraries): no locale, no
+// trailing zeros, scientific notation where it is shorter, "inf", "-inf" and "nan".
+// Standard libraries without it (libstdc++ before 11) fall back to snprintf, which
+// assumes the C locale.
+
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "span.h"
+
+namespace cst {
+
+// Enough for every value of T, e.g. "-2.2250738585072014e-308" for double.
+template <typename T>
+inline constexpr std::size_t max_float_chars = sizeof(T) <= 4 ? 16 : 32;
+
+#if !defined(__cpp_lib_to_chars)
+namespace detail {
+
+// Parsing as T, not as long double and then rounding, which can round a second time.
+template <typename T>
+T parse_float(const char* text) {
+  if constexpr (std::is_same<T, float>::value) {
+    return std::strtof(text, nullptr);
+  } else if constexpr (std::is_same<T, double>::value) {
+    return std::strtod(text, nullptr);
+  } else {
+    return std::strtold(text, nullptr);
+  }
+}
+
+// Before libstdc++ 11 there is no floating point std::to_chars: the fewest %g digits that
+// parse back to `value`. printf's notation, so 1e20 prints as "1e+20", not 20 digits.
+template <typename T>
+char* write_float_printf(char* out, T value) {
+  const auto v = static_cast<long double>(value);
+  int n = 0;
+  for (int precision = 1; precision <= std::numeric_limits<T>::max_digits10; ++precision) {
+    n = std::snprintf(out, max_float_chars<T>, "%.*Lg", precision, v);
+    if (parse_float<T>(out) == value || value != value) {
+      break;
+    }
+  }
+  return out + n;
+}
+
+} // namespace detail
+#endif
+
+// Writes `value` at `out`, at most max_float_chars<T> characters; returns the end.
+template <typename T>
+char* write_float(char* out, T value) {
+  static_assert(std::is_floating_point<T>::value, "write_float formats float, double and long double");
+#if defined(__cpp_lib_to_chars)
+  return std::to_chars(out, out + max_float_chars<T>, value).ptr;
+#else
+  return detail::write_float_printf(out, value);
+#endif
+}
+
+template <typename T, std::size_t N>
+std::string_view format_float(T value, char (&buffer)[N]) {
+  static_assert(N >= max_float_chars<T>, "the buffer is too small, use max_float_chars<T>");
+  return std::string_view(buffer, static_cast<std::size_t>(write_float(buffer, value) - buffer));
+}
+
+// `values` separated by `separator`, for which the buffer needs
+// values.size() * (max_float_chars<T> + 1) bytes; returns the end.
+template <typename T>
+char* write_floats(char* out, span<const T> values, char separator) {
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    if (i != 0) {
+      *out++ = separator;
+    }
+    out = write_float(out, values[i]);
+  }
+  return out;
+}
+
+// Appends write_floats output to `out`, growing it once to the worst case and back.
+template <typename T>
+void append_floats(span<const T> values, std::string& out, char separator) {
+  const std::size_t size = out.size();
+  out.resize(size + values.size() * (max_float_chars<T> + 1));
+  char* end = write_floats(&out[0] + size, values, separator);
+  out.resize(static_cast<std::size_t>(end - out.data()));
+}
+template <typename Range>
+void append_floats(const Range& values, std::string& out, char separator) {
+  append_floats(span<const std::remove_cv_t<std::remove_pointer_t<decltype(std::data(values))>>>(values), out,
+                separator);
+}
+
+} // namespace cst
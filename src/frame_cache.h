@@ -0,0 +1,85 @@
+#pragma once
+
+// Per-thread recycling of coroutine frames, for the operator new/delete of the promise
+// types in generator.h and task.h:
+//
+//   static void* operator new(std::size_t size) { return detail::frame_cache::local().allocate(size); }
+//   static void operator delete(void* p, std::size_t size) noexcept {
+//     detail::frame_cache::local().deallocate(p, size);
+//   }
+//
+// A frame freed on another thread than the one that allocated it joins the cache of the
+// freeing thread.
+
+#include <cstddef>
+#include <new>
+
+namespace cst {
+namespace detail {
+
+// Free lists of coroutine frames in 64-byte size classes up to 1 KiB, a few per class.
+class frame_cache {
+public:
+  static constexpr std::size_t granularity = 64;
+  static constexpr std::size_t classes = 16;
+  static constexpr unsigned max_cached = 8;
+
+  frame_cache() = default;
+  frame_cache(const frame_cache&) = delete;
+  frame_cache& operator=(const frame_cache&) = delete;
+  ~frame_cache() {
+    for (node* head : free_) {
+      while (head != nullptr) {
+        node* next = head->next;
+        ::operator delete(head);
+        head = next;
+      }
+    }
+  }
+
+  static frame_cache& local() {
+    thread_local frame_cache cache;
+    return cache;
+  }
+
+  void* allocate(std::size_t size) {
+    const std::size_t c = size_class(size);
+    if (c >= classes) {
+      return ::operator new(size);
+    }
+    if (node* n = free_[c]) {
+      free_[c] = n->next;
+      --cached_[c];
+      ++reused_;
+      return n;
+    }
+    return ::operator new((c + 1) * granularity);
+  }
+
+  void deallocate(void* p, std::size_t size) noexcept {
+    const std::size_t c = size_class(size);
+    if (c >= classes || cached_[c] == max_cached) {
+      ::operator delete(p);
+      return;
+    }
+    free_[c] = ::new (p) node{free_[c]};
+    ++cached_[c];
+  }
+
+  // How many allocations this thread served from the free lists.
+  std::size_t reused() const noexcept { return reused_; }
+
+private:
+  struct node {
+    node* next;
+  };
+
+  static std::size_t size_class(std::size_t size) { return size == 0 ? 0 : (size - 1) / granularity; }
+
+  node* free_[classes] = {};
+  unsigned cached_[classes] = {};
+  std::size_t reused_ = 0;
+};
+
+} // namespace detail
+} // namespace cst
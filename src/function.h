@@ -0,0 +1,187 @@
+#pragma once
+
+// Type-erased callables that never allocate:
+//
+//   int apply(cst::function_ref<int(int)> f) { return f(1); } // non-owning, two pointers
+//   apply([&](int x) { return x + offset; });
+//
+//   cst::inplace_function<void(), 32> cb = [this] { ++count_; }; // owning, 32 byte buffer
+//
+// A function_ref must not outlive the callable it was made from, like std::string_view;
+// functions and function pointers are the exception, it keeps the pointer itself.
+// An inplace_function stores the callable in its buffer; a callable that does not fit is
+// a compile-time error rather than a heap allocation. Its callables must be copyable,
+// as for std::function, and nothrow movable, which keeps its own moves noexcept.
+
+#include <cstddef>
+#include <functional> // std::invoke, std::bad_function_call
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cst {
+
+template <typename Signature>
+class function_ref;
+
+template <typename R, typename... Args>
+class function_ref<R(Args...)> {
+public:
+  template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, function_ref> &&
+                                                    std::is_invocable_r_v<R, F&, Args...>>>
+  function_ref(F&& f) noexcept {
+    using T = std::remove_reference_t<F>;
+    if constexpr (std::is_function_v<T>) {
+      // Function pointers do not convert to void*.
+      target_.fn = reinterpret_cast<void (*)()>(&f);
+      call_ = [](target t, Args... args) -> R {
+        return std::invoke(reinterpret_cast<T*>(t.fn), std::forward<Args>(args)...);
+      };
+    } else if constexpr (std::is_pointer_v<T> && std::is_function_v<std::remove_pointer_t<T>>) {
+      // By value: `&f` is a temporary that is gone after the full expression.
+      using P = std::remove_cv_t<T>;
+      target_.fn = reinterpret_cast<void (*)()>(static_cast<P>(f));
+      call_ = [](target t, Args... args) -> R {
+        return std::invoke(reinterpret_cast<P>(t.fn), std::forward<Args>(args)...);
+      };
+    } else {
+      target_.obj = const_cast<void*>(static_cast<const void*>(std::addressof(f)));
+      call_ = [](target t, Args... args) -> R {
+        return std::invoke(*static_cast<T*>(t.obj), std::forward<Args>(args)...);
+      };
+    }
+  }
+
+  R operator()(Args... args) const { return call_(target_, std::forward<Args>(args)...); }
+
+private:
+  union target {
+    void* obj;
+    void (*fn)();
+  };
+
+  target target_;
+  R (*call_)(target, Args...);
+};
+
+template <typename Signature, std::size_t Capacity = 32, std::size_t Align = alignof(std::max_align_t)>
+class inplace_function;
+
+namespace detail {
+
+template <typename T>
+struct is_inplace_function : std::false_type {};
+template <typename Signature, std::size_t Capacity, std::size_t Align>
+struct is_inplace_function<inplace_function<Signature, Capacity, Align>> : std::true_type {};
+
+} // namespace detail
+
+template <typename R, typename... Args, std::size_t Capacity, std::size_t Align>
+class inplace_function<R(Args...), Capacity, Align> {
+  struct ops {
+    void (*copy)(const void* from, void* to);
+    void (*move)(void* from, void* to) noexcept; // leaves `from` destroyed
+    void (*destroy)(void*) noexcept;
+  };
+
+public:
+  static constexpr std::size_t capacity = Capacity;
+
+  inplace_function() noexcept = default;
+  inplace_function(std::nullptr_t) noexcept {}
+  template <typename F, typename T = std::decay_t<F>,
+            typename = std::enable_if_t<!detail::is_inplace_function<T>::value && std::is_invocable_r_v<R, T&, Args...>>>
+  inplace_function(F&& f) {
+    static_assert(sizeof(T) <= Capacity, "the callable does not fit the inplace_function, raise its Capacity");
+    static_assert(alignof(T) <= Align, "the callable is over-aligned for the inplace_function, raise its Align");
+    static_assert(std::is_copy_constructible_v<T>, "inplace_function needs copyable callables");
+    static_assert(std::is_nothrow_move_constructible_v<T>, "inplace_function needs callables with a noexcept move");
+    ::new (static_cast<void*>(buffer_)) T(std::forward<F>(f));
+    call_ = [](void* p, Args... args) -> R { return std::invoke(*static_cast<T*>(p), std::forward<Args>(args)...); };
+    ops_ = &ops_for<T>;
+  }
+
+  inplace_function(const inplace_function& other) : call_(other.call_), ops_(other.ops_) {
+    if (ops_ != nullptr) {
+      ops_->copy(other.buffer_, buffer_);
+    }
+  }
+  inplace_function(inplace_function&& other) noexcept : call_(other.call_), ops_(other.ops_) {
+    if (ops_ != nullptr) {
+      ops_->move(other.buffer_, buffer_);
+      other.call_ = nullptr;
+      other.ops_ = nullptr;
+    }
+  }
+  ~inplace_function() { reset(); }
+
+  inplace_function& operator=(const inplace_function& other) {
+    if (this != &other) {
+      inplace_function copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+  inplace_function& operator=(inplace_function&& other) noexcept {
+    if (this != &other) {
+      reset();
+      call_ = other.call_;
+      ops_ = other.ops_;
+      if (ops_ != nullptr) {
+        ops_->move(other.buffer_, buffer_);
+        other.call_ = nullptr;
+        other.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+  inplace_function& operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+  template <typename F, typename = std::enable_if_t<!detail::is_inplace_function<std::decay_t<F>>::value>>
+  inplace_function& operator=(F&& f) {
+    return *this = inplace_function(std::forward<F>(f));
+  }
+
+  // Throws std::bad_function_call when empty.
+  R operator()(Args... args) const {
+    if (call_ == nullptr) {
+      throw std::bad_function_call();
+    }
+    return call_(const_cast<unsigned char*>(buffer_), std::forward<Args>(args)...);
+  }
+  explicit operator bool() const noexcept { return call_ != nullptr; }
+
+  void swap(inplace_function& other) noexcept {
+    inplace_function tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+private:
+  void reset() noexcept {
+    if (ops_ != nullptr) {
+      ops_->destroy(buffer_);
+      call_ = nullptr;
+      ops_ = nullptr;
+    }
+  }
+
+  template <typename T>
+  static constexpr ops ops_for = {
+      [](const void* from, void* to) { ::new (to) T(*static_cast<const T*>(from)); },
+      [](void* from, void* to) noexcept {
+        ::new (to) T(std::move(*static_cast<T*>(from)));
+        static_cast<T*>(from)->~T();
+      },
+      [](void* p) noexcept { static_cast<T*>(p)->~T(); },
+  };
+
+  R (*call_)(void*, Args...) = nullptr;
+  const ops* ops_ = nullptr;
+  alignas(Align) unsigned char buffer_[Capacity];
+};
+
+} // namespace cst
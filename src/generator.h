@@ -0,0 +1,132 @@
+#pragma once
+
+// A lazy sequence written as a C++20 coroutine:
+//
+//   cst::generator<int> range(int start, int end) {
+//     while (start < end) {
+//       co_yield start;
+//       start++;
+//     }
+//   }
+//   for (int n : range(0, 10)) {} // computes one value per iteration
+//
+// The body runs only while the caller iterates, up to the next co_yield. Yielded values
+// are not copied: the iterator refers to the yielded object, which stays alive until the
+// coroutine resumes. An exception thrown by the body propagates out of begin() or ++.
+//
+// Coroutine frames come from a per-thread cache of recently freed frames, so creating a
+// generator in a loop allocates once instead of on every call (compilers can elide the
+// allocation only when the generator does not escape the caller).
+
+#if !defined(__cpp_impl_coroutine)
+#error "generator.h needs C++20 coroutines (-std=c++20, or -std=c++2a -fcoroutines on GCC 10)"
+#endif
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "frame_cache.h"
+
+namespace cst {
+
+template <typename T>
+class generator {
+  static_assert(!std::is_reference_v<T>, "generator<T> yields values, it hands out const T&");
+
+public:
+  struct promise_type {
+    generator get_return_object() noexcept {
+      return generator(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    std::suspend_always final_suspend() const noexcept { return {}; }
+    // The yielded object outlives the suspension: it is either a local of the coroutine
+    // or a temporary of the full expression containing co_yield.
+    std::suspend_always yield_value(const T& value) noexcept {
+      value_ = std::addressof(value);
+      return {};
+    }
+    void return_void() noexcept {}
+    void unhandled_exception() { exception_ = std::current_exception(); }
+    // Generators produce values; waiting for something else inside one is a mistake.
+    template <typename U>
+    void await_transform(U&&) = delete;
+
+    static void* operator new(std::size_t size) { return detail::frame_cache::local().allocate(size); }
+    static void operator delete(void* p, std::size_t size) noexcept {
+      detail::frame_cache::local().deallocate(p, size);
+    }
+
+    const T* value_ = nullptr;
+    std::exception_ptr exception_;
+  };
+
+  using handle = std::coroutine_handle<promise_type>;
+
+  class iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    iterator() = default;
+    explicit iterator(handle h) : h_(h) {}
+
+    reference operator*() const { return *h_.promise().value_; }
+    pointer operator->() const { return h_.promise().value_; }
+    iterator& operator++() {
+      resume(h_);
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+
+    friend bool operator==(const iterator& it, std::default_sentinel_t) { return !it.h_ || it.h_.done(); }
+
+  private:
+    handle h_;
+  };
+
+  generator() noexcept = default;
+  generator(generator&& other) noexcept : h_(std::exchange(other.h_, {})) {}
+  generator& operator=(generator&& other) noexcept {
+    generator(std::move(other)).swap(*this);
+    return *this;
+  }
+  ~generator() {
+    if (h_) {
+      h_.destroy();
+    }
+  }
+
+  // Runs the body up to the first co_yield; call once.
+  iterator begin() {
+    if (h_) {
+      resume(h_);
+    }
+    return iterator(h_);
+  }
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+  void swap(generator& other) noexcept { std::swap(h_, other.h_); }
+
+private:
+  explicit generator(handle h) noexcept : h_(h) {}
+
+  static void resume(handle h) {
+    h.resume();
+    if (h.done() && h.promise().exception_) {
+      std::rethrow_exception(std::exchange(h.promise().exception_, nullptr));
+    }
+  }
+
+  handle h_;
+};
+
+} // namespace cst
@@ -0,0 +1,175 @@
+#pragma once
+
+// Object lifecycle instrumentation: a value type that counts its constructions, copies,
+// moves, destructions and heap bytes, so tests can assert on hidden copies instead of
+// printing "copied"/"moved".
+//
+//   struct A { cst::instrumented probe; };
+//   CHECK_NO_COPIES(wrapper(A{}));
+//
+//   cst::lifecycle_scope scope;
+//   std::vector<A> v(10);
+//   CHECK(scope.counts().copies() == 0);
+//
+// The counters are per thread; a scope reports what happened since it was opened, so
+// scopes nest freely.
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace cst {
+
+struct lifecycle_counts {
+  long constructions = 0;      // every constructor except copy and move
+  long copy_constructions = 0;
+  long move_constructions = 0;
+  long copy_assignments = 0;
+  long move_assignments = 0;
+  long destructions = 0;
+  long heap_allocations = 0;
+  long heap_bytes = 0;         // allocated, never decremented
+
+  long copies() const { return copy_constructions + copy_assignments; }
+  long moves() const { return move_constructions + move_assignments; }
+  long live() const { return constructions + copy_constructions + move_constructions - destructions; }
+
+  lifecycle_counts operator-(const lifecycle_counts& o) const {
+    lifecycle_counts r;
+    r.constructions = constructions - o.constructions;
+    r.copy_constructions = copy_constructions - o.copy_constructions;
+    r.move_constructions = move_constructions - o.move_constructions;
+    r.copy_assignments = copy_assignments - o.copy_assignments;
+    r.move_assignments = move_assignments - o.move_assignments;
+    r.destructions = destructions - o.destructions;
+    r.heap_allocations = heap_allocations - o.heap_allocations;
+    r.heap_bytes = heap_bytes - o.heap_bytes;
+    return r;
+  }
+};
+
+namespace detail {
+inline thread_local lifecycle_counts lifecycle_totals;
+} // namespace detail
+
+class lifecycle_scope {
+public:
+  lifecycle_scope() : start_(detail::lifecycle_totals) {}
+  lifecycle_counts counts() const { return detail::lifecycle_totals - start_; }
+  void reset() { start_ = detail::lifecycle_totals; }
+
+private:
+  lifecycle_counts start_;
+};
+
+// Counting value type; with a payload it also owns a heap buffer that copies duplicate
+// and moves steal, like the buffer of a std::string or std::vector. NothrowMove = false
+// leaves the moves without noexcept, which makes std::vector copy on reallocation.
+template <bool NothrowMove>
+class basic_instrumented {
+public:
+  basic_instrumented() noexcept { ++detail::lifecycle_totals.constructions; }
+  explicit basic_instrumented(int value, std::size_t payload_bytes = 0) : value_(value) {
+    ++detail::lifecycle_totals.constructions;
+    allocate(payload_bytes);
+  }
+  basic_instrumented(const basic_instrumented& o) : value_(o.value_) {
+    ++detail::lifecycle_totals.copy_constructions;
+    allocate(o.size_);
+    copy_payload(o);
+  }
+  basic_instrumented(basic_instrumented&& o) noexcept(NothrowMove)
+      : value_(o.value_), payload_(std::exchange(o.payload_, nullptr)), size_(std::exchange(o.size_, 0)) {
+    ++detail::lifecycle_totals.move_constructions;
+  }
+  basic_instrumented& operator=(const basic_instrumented& o) {
+    ++detail::lifecycle_totals.copy_assignments;
+    if (this != &o) {
+      if (size_ != o.size_) {
+        release();
+        allocate(o.size_);
+      }
+      copy_payload(o);
+      value_ = o.value_;
+    }
+    return *this;
+  }
+  basic_instrumented& operator=(basic_instrumented&& o) noexcept(NothrowMove) {
+    ++detail::lifecycle_totals.move_assignments;
+    if (this != &o) {
+      release();
+      value_ = o.value_;
+      payload_ = std::exchange(o.payload_, nullptr);
+      size_ = std::exchange(o.size_, 0);
+    }
+    return *this;
+  }
+  ~basic_instrumented() {
+    ++detail::lifecycle_totals.destructions;
+    release();
+  }
+
+  int value() const { return value_; }
+  std::size_t payload_size() const { return size_; }
+
+  friend bool operator==(const basic_instrumented& a, const basic_instrumented& b) { return a.value_ == b.value_; }
+  friend bool operator!=(const basic_instrumented& a, const basic_instrumented& b) { return a.value_ != b.value_; }
+  friend bool operator<(const basic_instrumented& a, const basic_instrumented& b) { return a.value_ < b.value_; }
+
+private:
+  void allocate(std::size_t bytes) {
+    if (bytes != 0) {
+      payload_ = new char[bytes];
+      size_ = bytes;
+      ++detail::lifecycle_totals.heap_allocations;
+      detail::lifecycle_totals.heap_bytes += static_cast<long>(bytes);
+    }
+  }
+  void copy_payload(const basic_instrumented& o) {
+    if (o.size_ != 0) {
+      std::memcpy(payload_, o.payload_, o.size_);
+    }
+  }
+  void release() {
+    delete[] payload_;
+    payload_ = nullptr;
+    size_ = 0;
+  }
+
+  int value_ = 0;
+  char* payload_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+using instrumented = basic_instrumented<true>;
+using throwing_move_instrumented = basic_instrumented<false>;
+
+// noexcept move audit: true if std::move_if_noexcept, and with it the reallocation of
+// std::vector, falls back to copying T because its move constructor may throw.
+template <typename T>
+struct move_falls_back_to_copy
+    : std::bool_constant<!std::is_nothrow_move_constructible<T>::value && std::is_copy_constructible<T>::value> {};
+template <typename T>
+inline constexpr bool move_falls_back_to_copy_v = move_falls_back_to_copy<T>::value;
+
+template <typename... Ts>
+inline constexpr bool any_move_falls_back_to_copy_v = (move_falls_back_to_copy_v<Ts> || ...);
+
+} // namespace cst
+
+// Put next to a type that is stored in vectors: CST_ASSERT_NOTHROW_MOVE(Widget);
+#define CST_ASSERT_NOTHROW_MOVE(...)                                                      \
+  static_assert(!cst::move_falls_back_to_copy_v<__VA_ARGS__>,                             \
+                #__VA_ARGS__ " has a move constructor that may throw, containers will copy it instead")
+
+// doctest assertions over the instrumented objects touched while evaluating an expression.
+#define CST_CHECK_LIFECYCLE_IMPL(what, n, ...)                                        \
+  do {                                                                                \
+    cst::lifecycle_scope cst_lifecycle_scope_;                                        \
+    static_cast<void>(__VA_ARGS__);                                                   \
+    CHECK(cst_lifecycle_scope_.counts().what() == (n));                               \
+  } while (false)
+#define CHECK_COPIES(n, ...) CST_CHECK_LIFECYCLE_IMPL(copies, n, __VA_ARGS__)
+#define CHECK_MOVES(n, ...) CST_CHECK_LIFECYCLE_IMPL(moves, n, __VA_ARGS__)
+#define CHECK_NO_COPIES(...) CHECK_COPIES(0, __VA_ARGS__)
@@ -0,0 +1,125 @@
+#pragma once
+
+// Compile-time lookup tables for constexpr functions over a small integer domain:
+//
+//   constexpr int square(int x) { return x * x; }
+//   constexpr auto squares = cst::make_lookup_table<256>(square); // square(0) .. square(255)
+//   int y = squares(x);                                            // one load, x in [0, 256)
+//
+//   auto f = cst::factorial<std::int64_t>(n); // n! from a table, throws if it does not fit
+//
+// The function runs once per entry while compiling (it has to be usable in a constant
+// expression, a lambda works as well), the program only reads the array. Worth it when
+// computing a value costs more than a load that misses the cache now and then: loops and
+// recursion like factorial, not a single multiplication.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace cst {
+
+#if defined(__SIZEOF_INT128__)
+#define CST_HAS_INT128 1
+__extension__ typedef __int128 int128; // __extension__ keeps -Wpedantic quiet
+#endif
+
+// f(first) .. f(first + N - 1).
+template <typename T, std::size_t N, typename Key = int>
+class lookup_table {
+  static_assert(std::is_integral<Key>::value, "lookup tables are indexed by integers");
+
+public:
+  template <typename F>
+  constexpr explicit lookup_table(F f, Key first = Key{}) : first_(first) {
+    for (std::size_t i = 0; i < N; ++i) {
+      values_[i] = f(static_cast<Key>(first + static_cast<Key>(i)));
+    }
+  }
+
+  constexpr bool contains(Key key) const { return key >= first_ && index(key) < N; }
+  // Precondition: contains(key).
+  constexpr const T& operator()(Key key) const { return values_[index(key)]; }
+  // Throws std::out_of_range if !contains(key).
+  constexpr const T& at(Key key) const {
+    if (!contains(key)) {
+      throw std::out_of_range("lookup_table: key outside the table");
+    }
+    return values_[index(key)];
+  }
+
+  constexpr Key first() const { return first_; }
+  constexpr Key last() const { return static_cast<Key>(first_ + static_cast<Key>(N - 1)); }
+  static constexpr std::size_t size() { return N; }
+  constexpr const std::array<T, N>& values() const { return values_; }
+
+private:
+  constexpr std::size_t index(Key key) const {
+    return static_cast<std::size_t>(key) - static_cast<std::size_t>(first_);
+  }
+
+  Key first_;
+  std::array<T, N> values_{};
+};
+
+// The table's element type is what `f` returns.
+template <std::size_t N, typename Key = int, typename F>
+constexpr auto make_lookup_table(F f, Key first = Key{}) {
+  using T = std::decay_t<decltype(f(first))>;
+  return lookup_table<T, N, Key>(f, first);
+}
+
+namespace detail {
+
+// numeric_limits is not specialized for __int128 in strict ISO mode.
+template <typename T>
+constexpr T max_signed() {
+  constexpr T half = T(1) << (sizeof(T) * 8 - 2);
+  return half - 1 + half;
+}
+
+// The largest n for which n! fits T.
+template <typename T>
+constexpr int max_factorial_argument() {
+  int n = 0;
+  T f = 1;
+  while (f <= max_signed<T>() / (n + 1)) {
+    f *= n + 1;
+    ++n;
+  }
+  return n;
+}
+
+template <typename T>
+constexpr T iterative_factorial(int n) {
+  T f = 1;
+  for (int i = 2; i <= n; ++i) {
+    f *= i;
+  }
+  return f;
+}
+
+} // namespace detail
+
+// 0! .. n! for every n! that fits the signed integer type T: 21 entries for int64, 34
+// for int128.
+template <typename T>
+inline constexpr auto factorial_table =
+    make_lookup_table<static_cast<std::size_t>(detail::max_factorial_argument<T>() + 1)>(
+        detail::iterative_factorial<T>);
+
+// Throws std::domain_error for n < 0 and std::overflow_error if n! does not fit T.
+template <typename T = std::int64_t>
+constexpr T factorial(int n) {
+  if (n < 0) {
+    throw std::domain_error("factorial: negative argument");
+  }
+  if (!factorial_table<T>.contains(n)) {
+    throw std::overflow_error("factorial: result does not fit the type");
+  }
+  return factorial_table<T>(n);
+}
+
+} // namespace cst
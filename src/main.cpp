@@ -1,9 +1,12 @@
 #define DOCTEST_CONFIG_IMPLEMENT
 #include "doctest/doctest.h"
 
-int main(int argc, char** argv) {
-    doctest::Context context;
+#include "alloc_tracker.h"
+#include "bench.h"
+#include "test_runner.h"
+#include "test_timings.h"
 
+static void configure(doctest::Context& context, int argc, char** argv) {
     // !!! THIS IS JUST AN EXAMPLE SHOWING HOW DEFAULTS/OVERRIDES ARE SET !!!
 
     // defaults
@@ -15,6 +18,19 @@ int main(int argc, char** argv) {
 
     // overrides
     context.setOption("no-breaks", true);             // don't break in the debugger when assertions fail
+}
+
+int main(int argc, char** argv) {
+    cst::alloc_tracker::apply_command_line(argc, argv); // --alloc-report prints allocations per TEST_CASE/SUBCASE
+    if (cst::bench::requested(argc, argv)) // --bench[=<filters>] runs the BENCH_CASEs instead of the tests
+        return cst::bench::run_main(argc, argv);
+    if (cst::test_timings::requested(argc, argv)) // --timings-* records/compares durations, always serial
+        return cst::test_timings::run_main(argc, argv, configure);
+    if (cst::test_runner::requested(argc, argv)) // --jobs N runs the test cases in N worker processes
+        return cst::test_runner::run_main(argc, argv, configure);
+
+    doctest::Context context;
+    configure(context, argc, argv);
 
     int res = context.run(); // run
 
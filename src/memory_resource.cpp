@@ -0,0 +1,228 @@
+#include "memory_resource.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define CST_PAGES_MMAP 1
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#define CST_PAGES_VIRTUALALLOC 1
+#endif
+
+namespace cst {
+namespace pmr {
+
+namespace {
+
+constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+std::size_t round_up(std::size_t n, std::size_t to) {
+  return (n + to - 1) / to * to;
+}
+
+} // namespace
+
+void* counting_resource::do_allocate(std::size_t bytes, std::size_t alignment) {
+  void* p = upstream_->allocate(bytes, alignment);
+  ++allocations_;
+  allocated_bytes_ += bytes;
+  live_bytes_ += bytes;
+  peak_bytes_ = std::max(peak_bytes_, live_bytes_);
+  return p;
+}
+
+void counting_resource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+  upstream_->deallocate(p, bytes, alignment);
+  ++deallocations_;
+  live_bytes_ -= bytes;
+}
+
+std::size_t page_resource::granularity() const {
+#ifdef CST_PAGES_MMAP
+  static const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  return huge_pages_ ? huge_page_size : page;
+#else
+  return huge_pages_ ? huge_page_size : 4096;
+#endif
+}
+
+void* page_resource::do_allocate(std::size_t bytes, std::size_t alignment) {
+  const std::size_t size = round_up(std::max<std::size_t>(bytes, 1), granularity());
+#if defined(CST_PAGES_MMAP)
+  // Over-allocate by one huge page and trim, mmap only guarantees page alignment.
+  const std::size_t slack = huge_pages_ ? huge_page_size : 0;
+  void* raw = mmap(nullptr, size + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  char* p = static_cast<char*>(raw);
+  if (slack != 0) {
+    char* aligned = reinterpret_cast<char*>(round_up(reinterpret_cast<std::uintptr_t>(p), huge_page_size));
+    if (aligned != p) {
+      munmap(p, static_cast<std::size_t>(aligned - p));
+    }
+    const std::size_t tail = slack - static_cast<std::size_t>(aligned - p);
+    if (tail != 0) {
+      munmap(aligned + size, tail);
+    }
+    p = aligned;
+#ifdef MADV_HUGEPAGE
+    madvise(p, size, MADV_HUGEPAGE); // a hint, failure only costs the speedup
+#endif
+  }
+  static_cast<void>(alignment); // page alignment covers every fundamental and SIMD alignment
+  return p;
+#elif defined(CST_PAGES_VIRTUALALLOC)
+  static_cast<void>(alignment);
+  void* p = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+#else
+  return ::operator new(size, std::align_val_t(std::max(alignment, granularity())));
+#endif
+}
+
+void page_resource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+  const std::size_t size = round_up(std::max<std::size_t>(bytes, 1), granularity());
+#if defined(CST_PAGES_MMAP)
+  static_cast<void>(alignment);
+  munmap(p, size);
+#elif defined(CST_PAGES_VIRTUALALLOC)
+  static_cast<void>(alignment);
+  static_cast<void>(size);
+  VirtualFree(p, 0, MEM_RELEASE);
+#else
+  ::operator delete(p, size, std::align_val_t(std::max(alignment, granularity())));
+#endif
+}
+
+void arena_resource::release() {
+  while (chunks_ != nullptr) {
+    chunk* next = chunks_->next;
+    upstream_->deallocate(chunks_, chunks_->size, alignof(std::max_align_t));
+    chunks_ = next;
+  }
+  cursor_ = end_ = nullptr;
+  reserved_ = 0;
+}
+
+void* arena_resource::do_allocate(std::size_t bytes, std::size_t alignment) {
+  auto aligned = [&](char* p) {
+    return reinterpret_cast<char*>(round_up(reinterpret_cast<std::uintptr_t>(p), alignment));
+  };
+  char* p = cursor_ != nullptr ? aligned(cursor_) : nullptr;
+  // Aligning a cursor near the end of the chunk can overshoot it.
+  if (p == nullptr || p > end_ || bytes > static_cast<std::size_t>(end_ - p)) {
+    const std::size_t needed = sizeof(chunk) + alignment + bytes;
+    while (next_chunk_ < needed) {
+      next_chunk_ *= 2;
+    }
+    auto* c = static_cast<chunk*>(upstream_->allocate(next_chunk_, alignof(std::max_align_t)));
+    c->next = chunks_;
+    c->size = next_chunk_;
+    chunks_ = c;
+    reserved_ += next_chunk_;
+    cursor_ = reinterpret_cast<char*>(c + 1);
+    end_ = reinterpret_cast<char*>(c) + next_chunk_;
+    next_chunk_ *= 2;
+    p = aligned(cursor_);
+  }
+  cursor_ = p + bytes;
+  return p;
+}
+
+std::size_t pool_resource::size_class(std::size_t bytes, std::size_t alignment) {
+  std::size_t size = min_block;
+  std::size_t cls = 0;
+  bytes = std::max(bytes, alignment);
+  while (size < bytes) {
+    size *= 2;
+    ++cls;
+  }
+  return cls;
+}
+
+void pool_resource::refill(std::size_t cls) {
+  const std::size_t block = min_block << cls;
+  // Chunks start at 4 KiB (or 8 blocks) and double up to 1 MiB per class.
+  std::size_t& chunk = next_chunk_[cls];
+  chunk = chunk == 0 ? std::max<std::size_t>(4096, 8 * block) : std::min<std::size_t>(chunk * 2, 1 << 20);
+  // Aligned to the block size, so every block satisfies alignments up to its size.
+  const std::size_t alignment = std::min<std::size_t>(block, 4096);
+  char* p = static_cast<char*>(upstream_->allocate(chunk, alignment));
+  blocks_.push_back({p, chunk, alignment});
+  reserved_ += chunk;
+  for (std::size_t offset = chunk; offset >= block; offset -= block) {
+    auto* b = reinterpret_cast<free_block*>(p + offset - block);
+    b->next = free_[cls];
+    free_[cls] = b;
+  }
+}
+
+void* pool_resource::do_allocate(std::size_t bytes, std::size_t alignment) {
+  if (bytes > max_pooled || alignment > max_pooled) {
+    void* p = upstream_->allocate(bytes, alignment);
+    blocks_.push_back({p, bytes, alignment});
+    reserved_ += bytes;
+    return p;
+  }
+  const std::size_t cls = size_class(bytes, alignment);
+  if (free_[cls] == nullptr) {
+    refill(cls);
+  }
+  free_block* b = free_[cls];
+  free_[cls] = b->next;
+  return b;
+}
+
+void pool_resource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+  if (bytes > max_pooled || alignment > max_pooled) {
+    auto it = std::find_if(blocks_.begin(), blocks_.end(), [p](const upstream_block& b) { return b.p == p; });
+    if (it != blocks_.end()) {
+      upstream_->deallocate(it->p, it->bytes, it->alignment);
+      reserved_ -= it->bytes;
+      blocks_.erase(it);
+    }
+    return;
+  }
+  const std::size_t cls = size_class(bytes, alignment);
+  auto* b = static_cast<free_block*>(p);
+  b->next = free_[cls];
+  free_[cls] = b;
+}
+
+void pool_resource::release() {
+  for (const auto& b : blocks_) {
+    upstream_->deallocate(b.p, b.bytes, b.alignment);
+  }
+  blocks_.clear();
+  std::fill(std::begin(free_), std::end(free_), nullptr);
+  std::fill(std::begin(next_chunk_), std::end(next_chunk_), 0);
+  reserved_ = 0;
+}
+
+std::size_t resident_bytes() {
+#if defined(__linux__)
+  std::FILE* f = std::fopen("/proc/self/statm", "r");
+  if (f == nullptr) {
+    return 0;
+  }
+  unsigned long size = 0, resident = 0;
+  const int read = std::fscanf(f, "%lu %lu", &size, &resident);
+  std::fclose(f);
+  return read == 2 ? resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+  return 0;
+#endif
+}
+
+} // namespace pmr
+} // namespace cst
@@ -0,0 +1,172 @@
+#pragma once
+
+// std::pmr building blocks for containers that are built, used and thrown away:
+//
+//   cst::pmr::arena_resource arena;            // bump allocation, freed all at once
+//   cst::pmr::Vec<int> v(&arena);              // std::pmr::vector<int>
+//   cst::pmr::map<int, std::string> m(&arena); // keys and values share the arena
+//
+//   cst::pmr::page_resource pages(true);       // page-granular, transparent huge pages
+//   cst::pmr::pool_resource pool(&pages);      // size-class free lists on top
+//
+//   cst::pmr::counting_resource counter;       // wraps any resource, counts and tracks peak
+//   cst::pmr::arena_resource counted(64 << 10, &counter);
+//
+// None of the resources are thread safe, like std::pmr::unsynchronized_pool_resource.
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "flat_map.h"
+
+namespace cst {
+namespace pmr {
+
+template <typename T>
+using Vec = std::pmr::vector<T>;
+template <typename Key, typename T, typename Compare = std::less<Key>>
+using map = std::pmr::map<Key, T, Compare>;
+template <typename Key, typename Compare = std::less<Key>>
+using set = std::pmr::set<Key, Compare>;
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+using unordered_map = std::pmr::unordered_map<Key, T, Hash, KeyEqual>;
+template <typename Key, typename T, typename Compare = std::less<Key>>
+using flat_map = cst::flat_map<Key, T, Compare, std::pmr::polymorphic_allocator<std::pair<Key, T>>>;
+
+// Forwards to `upstream` and counts what passes through.
+class counting_resource : public std::pmr::memory_resource {
+public:
+  explicit counting_resource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : upstream_(upstream) {}
+
+  std::size_t allocations() const { return allocations_; }
+  std::size_t deallocations() const { return deallocations_; }
+  std::size_t allocated_bytes() const { return allocated_bytes_; } // total, never decremented
+  std::size_t live_bytes() const { return live_bytes_; }
+  std::size_t peak_bytes() const { return peak_bytes_; }
+  void reset_peak() { peak_bytes_ = live_bytes_; }
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+  std::pmr::memory_resource* upstream_;
+  std::size_t allocations_ = 0;
+  std::size_t deallocations_ = 0;
+  std::size_t allocated_bytes_ = 0;
+  std::size_t live_bytes_ = 0;
+  std::size_t peak_bytes_ = 0;
+};
+
+// Whole pages straight from the OS (mmap/VirtualAlloc). With `huge_pages` the blocks
+// are 2 MiB aligned and madvise(MADV_HUGEPAGE)d on Linux, which saves TLB misses for
+// big arenas; elsewhere the flag is ignored. Meant as the upstream of the arena and
+// the pool, not for small allocations.
+class page_resource : public std::pmr::memory_resource {
+public:
+  explicit page_resource(bool huge_pages = false) : huge_pages_(huge_pages) {}
+
+  bool huge_pages() const { return huge_pages_; }
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+  std::size_t granularity() const;
+
+  bool huge_pages_;
+};
+
+// Monotonic arena: allocation is a pointer bump, deallocation does nothing and the
+// chunks, each twice the size of the previous one, go back upstream in release() or
+// the destructor.
+class arena_resource : public std::pmr::memory_resource {
+public:
+  explicit arena_resource(std::size_t initial_chunk = 64 * 1024,
+                          std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : upstream_(upstream), next_chunk_(initial_chunk < 256 ? 256 : initial_chunk) {}
+  ~arena_resource() override { release(); }
+
+  arena_resource(const arena_resource&) = delete;
+  arena_resource& operator=(const arena_resource&) = delete;
+
+  void release();
+  // Bytes obtained from upstream.
+  std::size_t reserved_bytes() const { return reserved_; }
+
+private:
+  struct chunk {
+    chunk* next;
+    std::size_t size;
+  };
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void*, std::size_t, std::size_t) override {}
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+  std::pmr::memory_resource* upstream_;
+  std::size_t next_chunk_;
+  chunk* chunks_ = nullptr;
+  char* cursor_ = nullptr;
+  char* end_ = nullptr;
+  std::size_t reserved_ = 0;
+};
+
+// Size-class pool: requests up to max_pooled bytes are rounded up to a power of two and
+// served from a free list per class, refilled a chunk at a time; freed blocks are
+// reused immediately. Larger requests go straight upstream. release() or the
+// destructor returns everything.
+class pool_resource : public std::pmr::memory_resource {
+public:
+  static constexpr std::size_t min_block = 8;
+  static constexpr std::size_t max_pooled = 4096;
+
+  explicit pool_resource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : upstream_(upstream) {}
+  ~pool_resource() override { release(); }
+
+  pool_resource(const pool_resource&) = delete;
+  pool_resource& operator=(const pool_resource&) = delete;
+
+  void release();
+  std::size_t reserved_bytes() const { return reserved_; }
+
+private:
+  static constexpr std::size_t classes = 10; // 8 .. 4096
+  struct free_block {
+    free_block* next;
+  };
+  struct upstream_block {
+    void* p;
+    std::size_t bytes;
+    std::size_t alignment;
+  };
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+  static std::size_t size_class(std::size_t bytes, std::size_t alignment);
+  void refill(std::size_t cls);
+
+  std::pmr::memory_resource* upstream_;
+  free_block* free_[classes] = {};
+  std::size_t next_chunk_[classes] = {};
+  std::vector<upstream_block> blocks_; // chunks and large allocations
+  std::size_t reserved_ = 0;
+};
+
+// Resident set size of the process in bytes, 0 where it cannot be read (non-Linux).
+std::size_t resident_bytes();
+
+} // namespace pmr
+} // namespace cst
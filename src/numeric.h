@@ -0,0 +1,111 @@
+#pragma once
+
+// Numeric algorithms over ranges that pick their implementation from concepts:
+//
+//   std::vector<int> v = ...;
+//   cst::sum(v);             // contiguous int32: the vectorized kernel in simd.h
+//   cst::sum(std::list{...}); // any other range of numbers: a plain loop
+//   cst::count(v, 2);
+//   cst::add(a, b, out);      // out[i] = a[i] + b[i]
+//
+// The overloads differ only in their constraints, the most specific one that holds wins:
+// simd_range refines contiguous_arithmetic_range, which refines arithmetic_range. sum
+// and count have a simd_range overload; every other range, contiguous or not, takes the
+// iterator loop. add has a contiguous_arithmetic_range overload, a counted loop over
+// pointers. A range of strings never matches. Results follow the kernels: integer sums
+// wrap around, floating point sums may differ from a sequential loop in the last bits.
+
+#if !defined(__cpp_concepts)
+#error "numeric.h needs C++20 concepts"
+#endif
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+
+#include "relocate.h"
+#include "simd.h"
+#include "span.h"
+
+namespace cst {
+
+template <typename T>
+concept arithmetic = std::is_arithmetic_v<T>;
+
+template <typename R>
+concept arithmetic_range = std::ranges::input_range<R> && arithmetic<std::ranges::range_value_t<R>>;
+
+// Elements laid out like an array, so algorithms can work on pointers.
+template <typename R>
+concept contiguous_arithmetic_range =
+    arithmetic_range<R> && std::ranges::contiguous_range<R> && std::ranges::sized_range<R>;
+
+// Contiguous elements of a type the simd kernels take.
+template <typename R>
+concept simd_range = contiguous_arithmetic_range<R> && simd::is_supported_v<std::ranges::range_value_t<R>>;
+
+template <typename T>
+concept trivially_relocatable = is_trivially_relocatable_v<T>;
+
+namespace detail {
+template <typename R>
+span<const std::ranges::range_value_t<R>> as_span(const R& r) {
+  return {std::ranges::data(r), static_cast<std::size_t>(std::ranges::size(r))};
+}
+} // namespace detail
+
+template <arithmetic_range R>
+std::ranges::range_value_t<R> sum(const R& r) {
+  std::ranges::range_value_t<R> total{};
+  for (const auto& x : r) {
+    total += x;
+  }
+  return total;
+}
+template <simd_range R>
+std::ranges::range_value_t<R> sum(const R& r) {
+  return simd::sum(detail::as_span(r));
+}
+
+template <arithmetic_range R>
+std::size_t count(const R& r, std::ranges::range_value_t<R> value) {
+  return static_cast<std::size_t>(std::ranges::count(r, value));
+}
+template <simd_range R>
+std::size_t count(const R& r, std::ranges::range_value_t<R> value) {
+  return simd::count_equal(detail::as_span(r), value);
+}
+
+// out[i] = a[i] + b[i] for the first min(size) elements; returns how many were written.
+template <arithmetic_range A, arithmetic_range B, std::ranges::forward_range Out>
+std::size_t add(const A& a, const B& b, Out&& out) {
+  std::size_t n = 0;
+  auto x = std::ranges::begin(a);
+  auto y = std::ranges::begin(b);
+  auto z = std::ranges::begin(out);
+  for (; x != std::ranges::end(a) && y != std::ranges::end(b) && z != std::ranges::end(out); ++x, ++y, ++z, ++n) {
+    *z = *x + *y;
+  }
+  return n;
+}
+// Counted loop over pointers, which the compiler vectorizes (after a runtime overlap
+// check); the iterator loop above has three end tests per element instead.
+template <contiguous_arithmetic_range A, contiguous_arithmetic_range B, contiguous_arithmetic_range Out>
+  requires(!std::is_const_v<std::remove_reference_t<std::ranges::range_reference_t<Out>>>)
+std::size_t add(const A& a, const B& b, Out&& out) {
+  const std::size_t n = std::min({static_cast<std::size_t>(std::ranges::size(a)),
+                                  static_cast<std::size_t>(std::ranges::size(b)),
+                                  static_cast<std::size_t>(std::ranges::size(out))});
+  const auto* x = std::ranges::data(a);
+  const auto* y = std::ranges::data(b);
+  auto* z = std::ranges::data(out);
+  for (std::size_t i = 0; i < n; ++i) {
+    z[i] = x[i] + y[i];
+  }
+  return n;
+}
+
+} // namespace cst
@@ -0,0 +1,305 @@
+#pragma once
+
+// Dependency-free stand-ins for the C++17 parallel algorithms. libstdc++ only runs
+// std::execution::par on top of Intel TBB, these run on cst::thread_pool::shared().
+//
+//   cst::sort(cst::execution::par, v.begin(), v.end());
+//   cst::find(cst::execution::par.on(4), v.begin(), v.end(), 2); // at most 4 threads
+//
+// Only random-access iterators are supported.
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#define CST_PRAGMA_IVDEP _Pragma("GCC ivdep")
+#elif defined(__clang__)
+#define CST_PRAGMA_IVDEP _Pragma("clang loop vectorize(enable)")
+#else
+#define CST_PRAGMA_IVDEP
+#endif
+
+namespace cst {
+namespace execution {
+
+struct sequenced_policy {};
+
+struct parallel_policy {
+  unsigned concurrency = 0; // 0 - every worker of the shared pool plus the caller
+  parallel_policy on(unsigned threads) const { return parallel_policy{threads}; }
+};
+
+// Like parallel_policy, but element accesses inside a chunk may also be vectorized.
+struct parallel_unsequenced_policy : parallel_policy {
+  parallel_unsequenced_policy on(unsigned threads) const { return parallel_unsequenced_policy{{threads}}; }
+};
+
+inline constexpr sequenced_policy seq{};
+inline constexpr parallel_policy par{};
+inline constexpr parallel_unsequenced_policy par_unseq{};
+
+template <typename T>
+struct is_execution_policy
+    : std::bool_constant<std::is_base_of_v<parallel_policy, std::decay_t<T>> ||
+                         std::is_same_v<sequenced_policy, std::decay_t<T>>> {};
+template <typename T>
+inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+} // namespace execution
+
+namespace detail {
+
+template <typename It>
+inline constexpr bool is_random_access_v =
+    std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<It>::iterator_category>;
+
+template <typename Policy>
+inline constexpr bool is_unsequenced_v =
+    std::is_same_v<std::decay_t<Policy>, execution::parallel_unsequenced_policy>;
+
+// Below this many elements per chunk the fork/join costs more than it saves.
+inline constexpr std::size_t min_grain = 4096;
+
+inline unsigned concurrency_of(const execution::parallel_policy& policy) {
+  unsigned all = thread_pool::shared().size() + 1;
+  return policy.concurrency == 0 ? all : std::min(policy.concurrency, all);
+}
+
+// Splits [0, n) into contiguous chunks, a few per thread for load balancing.
+struct chunking {
+  chunking(std::size_t n, unsigned threads, std::size_t per_thread = 4)
+      : n(n), count(std::max<std::size_t>(1, std::min<std::size_t>(threads * per_thread, n / min_grain))) {}
+  std::size_t begin(std::size_t i) const { return n * i / count; }
+  std::size_t end(std::size_t i) const { return n * (i + 1) / count; }
+
+  std::size_t n;
+  std::size_t count;
+};
+
+template <typename F>
+void parallel_chunks(const execution::parallel_policy& policy, const chunking& c, F&& f) {
+  if (c.count == 1) {
+    f(std::size_t{0}, c.begin(0), c.end(0));
+    return;
+  }
+  thread_pool::shared().fork_join(c.count, [&](std::size_t i) { f(i, c.begin(i), c.end(i)); },
+                                  concurrency_of(policy));
+}
+
+} // namespace detail
+
+template <typename Policy, typename It, typename F,
+          std::enable_if_t<execution::is_execution_policy_v<Policy>, int> = 0>
+void for_each(Policy&& policy, It first, It last, F f) {
+  static_assert(detail::is_random_access_v<It>, "cst::for_each requires random-access iterators");
+  if constexpr (std::is_same_v<std::decay_t<Policy>, execution::sequenced_policy>) {
+    std::for_each(first, last, f);
+  } else {
+    detail::chunking c(last - first, detail::concurrency_of(policy));
+    detail::parallel_chunks(policy, c, [&](std::size_t, std::size_t b, std::size_t e) {
+      It it = first + b;
+      if constexpr (detail::is_unsequenced_v<Policy>) {
+        CST_PRAGMA_IVDEP
+        for (std::size_t i = 0; i < e - b; ++i) {
+          f(it[i]);
+        }
+      } else {
+        std::for_each(it, first + e, f);
+      }
+    });
+  }
+}
+
+template <typename Policy, typename It, typename Pred,
+          std::enable_if_t<execution::is_execution_policy_v<Policy>, int> = 0>
+It find_if(Policy&& policy, It first, It last, Pred pred) {
+  static_assert(detail::is_random_access_v<It>, "cst::find_if requires random-access iterators");
+  if constexpr (std::is_same_v<std::decay_t<Policy>, execution::sequenced_policy>) {
+    return std::find_if(first, last, pred);
+  } else {
+    const std::size_t n = last - first;
+    // Position of the leftmost match so far; chunks to the right of it stop early.
+    std::atomic<std::size_t> found{n};
+    detail::chunking c(n, detail::concurrency_of(policy), 16);
+    detail::parallel_chunks(policy, c, [&](std::size_t, std::size_t b, std::size_t e) {
+      constexpr std::size_t stride = 1024;
+      for (std::size_t i = b; i < e; i += stride) {
+        if (found.load(std::memory_order_relaxed) < i) {
+          return;
+        }
+        auto block_end = first + std::min(e, i + stride);
+        auto it = std::find_if(first + i, block_end, pred);
+        if (it != block_end) {
+          std::size_t pos = it - first;
+          std::size_t current = found.load(std::memory_order_relaxed);
+          while (pos < current && !found.compare_exchange_weak(current, pos)) {
+          }
+          return;
+        }
+      }
+    });
+    return first + found.load();
+  }
+}
+
+template <typename Policy, typename It, typename T,
+          std::enable_if_t<execution::is_execution_policy_v<Policy>, int> = 0>
+It find(Policy&& policy, It first, It last, const T& value) {
+  return cst::find_if(std::forward<Policy>(policy), first, last, [&value](const auto& e) { return e == value; });
+}
+
+template <typename Policy, typename It, typename Compare = std::less<>,
+          std::enable_if_t<execution::is_execution_policy_v<Policy>, int> = 0>
+void sort(Policy&& policy, It first, It last, Compare comp = {}) {
+  static_assert(detail::is_random_access_v<It>, "cst::sort requires random-access iterators");
+  if constexpr (std::is_same_v<std::decay_t<Policy>, execution::sequenced_policy>) {
+    std::sort(first, last, comp);
+  } else {
+    // Sort one run per chunk, then merge neighbouring runs pairwise, log2(runs) rounds.
+    detail::chunking c(last - first, detail::concurrency_of(policy), 1);
+    std::vector<std::size_t> bounds(c.count + 1);
+    for (std::size_t i = 0; i <= c.count; ++i) {
+      bounds[i] = c.begin(i);
+    }
+    detail::parallel_chunks(policy, c, [&](std::size_t, std::size_t b, std::size_t e) {
+      std::sort(first + b, first + e, comp);
+    });
+    while (bounds.size() > 2) {
+      std::size_t merges = (bounds.size() - 1) / 2;
+      thread_pool::shared().fork_join(merges, [&](std::size_t m) {
+        std::inplace_merge(first + bounds[2 * m], first + bounds[2 * m + 1], first + bounds[2 * m + 2], comp);
+      }, detail::concurrency_of(policy));
+      std::vector<std::size_t> next;
+      for (std::size_t i = 0; i < bounds.size(); i += 2) {
+        next.push_back(bounds[i]);
+      }
+      if (next.back() != bounds.back()) {
+        next.push_back(bounds.back());
+      }
+      bounds.swap(next);
+    }
+  }
+}
+
+template <typename Policy, typename It, typename T, typename Reduce, typename Transform,
+          std::enable_if_t<execution::is_execution_policy_v<Policy>, int> = 0>
+T transform_reduce(Policy&& policy, It first, It last, T init, Reduce reduce, Transform transform) {
+  static_assert(detail::is_random_access_v<It>, "cst::transform_reduce requires random-access iterators");
+  if constexpr (std::is_same_v<std::decay_t<Policy>, execution::sequenced_policy>) {
+    return std::transform_reduce(first, last, init, reduce, transform);
+  } else {
+    detail::chunking c(last - first, detail::concurrency_of(policy));
+    std::vector<std::optional<T>> partial(c.count);
+    detail::parallel_chunks(policy, c, [&](std::size_t i, std::size_t b, std::size_t e) {
+      if (b == e) {
+        return;
+      }
+      It it = first + b;
+      T acc = transform(it[0]);
+      if constexpr (detail::is_unsequenced_v<Policy>) {
+        CST_PRAGMA_IVDEP
+        for (std::size_t k = 1; k < e - b; ++k) {
+          acc = reduce(acc, transform(it[k]));
+        }
+      } else {
+        for (std::size_t k = 1; k < e - b; ++k) {
+          acc = reduce(std::move(acc), transform(it[k]));
+        }
+      }
+      partial[i] = std::move(acc);
+    });
+    for (auto& p : partial) {
+      if (p) {
+        init = reduce(std::move(init), std::move(*p));
+      }
+    }
+    return init;
+  }
+}
+
+// Inner product: init + sum of first1[i] * first2[i].
+template <typename Policy, typename It1, typename It2, typename T,
+          std::enable_if_t<execution::is_execution_policy_v<Policy>, int> = 0>
+T transform_reduce(Policy&& policy, It1 first1, It1 last1, It2 first2, T init) {
+  static_assert(detail::is_random_access_v<It1> && detail::is_random_access_v<It2>,
+                "cst::transform_reduce requires random-access iterators");
+  if constexpr (std::is_same_v<std::decay_t<Policy>, execution::sequenced_policy>) {
+    return std::transform_reduce(first1, last1, first2, init);
+  } else {
+    detail::chunking c(last1 - first1, detail::concurrency_of(policy));
+    std::vector<T> partial(c.count, T{});
+    detail::parallel_chunks(policy, c, [&](std::size_t i, std::size_t b, std::size_t e) {
+      It1 a = first1 + b;
+      It2 x = first2 + b;
+      T acc{};
+      CST_PRAGMA_IVDEP
+      for (std::size_t k = 0; k < e - b; ++k) {
+        acc = acc + a[k] * x[k];
+      }
+      partial[i] = acc;
+    });
+    for (const auto& p : partial) {
+      init = init + p;
+    }
+    return init;
+  }
+}
+
+template <typename Policy, typename It, typename Out, typename Op = std::plus<>,
+          std::enable_if_t<execution::is_execution_policy_v<Policy>, int> = 0>
+Out inclusive_scan(Policy&& policy, It first, It last, Out d_first, Op op = {}) {
+  static_assert(detail::is_random_access_v<It> && detail::is_random_access_v<Out>,
+                "cst::inclusive_scan requires random-access iterators");
+  if constexpr (std::is_same_v<std::decay_t<Policy>, execution::sequenced_policy>) {
+    return std::inclusive_scan(first, last, d_first, op);
+  } else {
+    using T = typename std::iterator_traits<It>::value_type;
+    const std::size_t n = last - first;
+    if (n == 0) {
+      return d_first;
+    }
+    // 1) reduce every chunk, 2) scan the chunk totals, 3) rescan chunks with their carry.
+    detail::chunking c(n, detail::concurrency_of(policy));
+    std::vector<std::optional<T>> carry(c.count);
+    detail::parallel_chunks(policy, c, [&](std::size_t i, std::size_t b, std::size_t e) {
+      if (i + 1 == c.count || b == e) {
+        return; // the last total is never used as a carry
+      }
+      T acc = first[b];
+      for (std::size_t k = b + 1; k < e; ++k) {
+        acc = op(std::move(acc), first[k]);
+      }
+      carry[i + 1] = std::move(acc);
+    });
+    for (std::size_t i = 2; i < c.count; ++i) {
+      if (carry[i - 1]) {
+        carry[i] = carry[i] ? op(*carry[i - 1], *carry[i]) : carry[i - 1];
+      }
+    }
+    detail::parallel_chunks(policy, c, [&](std::size_t i, std::size_t b, std::size_t e) {
+      if (b == e) {
+        return;
+      }
+      T acc = carry[i] ? op(*carry[i], first[b]) : T(first[b]);
+      d_first[b] = acc;
+      for (std::size_t k = b + 1; k < e; ++k) {
+        acc = op(std::move(acc), first[k]);
+        d_first[k] = acc;
+      }
+    });
+    return d_first + n;
+  }
+}
+
+} // namespace cst
+
+#undef CST_PRAGMA_IVDEP
@@ -0,0 +1,99 @@
+#pragma once
+
+// Integer parsing without std::string or the locale:
+//
+//   int n = cst::parse_int<int>("123");                      // std::from_chars underneath
+//   using namespace cst::literals;
+//   constexpr auto mask = 0xffff'ffff_i;                     // parsed by the compiler
+//   auto parsed = cst::simd::parse_integers(fields, values); // many at once, see simd.h
+//
+// parse_int is stricter than std::stoi: the whole string has to be the number, without
+// leading whitespace, '+' or trailing characters. _i is a literal operator template, so
+// its digits arrive as template arguments and a literal that does not fit is a compile
+// error; its type is the first of int, long and long long that holds the value, like a
+// decimal literal.
+
+#include <charconv>
+#include <climits>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+namespace cst {
+
+// Throws std::invalid_argument if `text` is not an integer and std::out_of_range if it
+// does not fit T, like std::stoi.
+template <typename T>
+T parse_int(std::string_view text) {
+  T value{};
+  const auto r = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (r.ec == std::errc::result_out_of_range) {
+    throw std::out_of_range("parse_int: out of range");
+  }
+  if (r.ec != std::errc() || r.ptr != text.data() + text.size()) {
+    throw std::invalid_argument("parse_int: not an integer");
+  }
+  return value;
+}
+
+namespace detail {
+
+// Throwing ends constant evaluation, which turns bad literals into compile errors.
+template <char... Chars>
+constexpr unsigned long long integer_literal() {
+  constexpr char text[] = {Chars...};
+  constexpr std::size_t n = sizeof...(Chars);
+  unsigned base = 10;
+  std::size_t i = 0;
+  if (n > 1 && text[0] == '0') {
+    if (text[1] == 'x' || text[1] == 'X') {
+      base = 16;
+      i = 2;
+    } else if (text[1] == 'b' || text[1] == 'B') {
+      base = 2;
+      i = 2;
+    } else {
+      base = 8;
+      i = 1;
+    }
+  }
+  unsigned long long value = 0;
+  for (; i < n; ++i) {
+    const char c = text[i];
+    if (c == '\'') {
+      continue; // digit separator
+    }
+    const unsigned digit = c >= '0' && c <= '9'   ? unsigned(c - '0')
+                           : c >= 'a' && c <= 'f' ? unsigned(c - 'a' + 10)
+                           : c >= 'A' && c <= 'F' ? unsigned(c - 'A' + 10)
+                                                  : 16u;
+    if (digit >= base) {
+      throw std::invalid_argument("_i: not an integer literal");
+    }
+    if (value > (ULLONG_MAX - digit) / base) {
+      throw std::out_of_range("_i: literal too large");
+    }
+    value = value * base + digit;
+  }
+  return value;
+}
+
+} // namespace detail
+
+namespace literals {
+
+template <char... Chars>
+constexpr auto operator""_i() {
+  constexpr unsigned long long value = detail::integer_literal<Chars...>();
+  if constexpr (value <= INT_MAX) {
+    return static_cast<int>(value);
+  } else if constexpr (value <= LONG_MAX) {
+    return static_cast<long>(value);
+  } else {
+    static_assert(value <= LLONG_MAX, "_i: literal does not fit long long");
+    return static_cast<long long>(value);
+  }
+}
+
+} // namespace literals
+} // namespace cst
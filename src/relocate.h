@@ -0,0 +1,55 @@
+#pragma once
+
+// Relocation: moving objects to new storage and ending the lifetime of the originals in
+// one step, which is what a container does when it grows.
+//
+//   T* p = allocate(new_capacity);
+//   cst::relocate(data, size, p); // memcpy when T is trivially relocatable
+//
+// Trivially copyable types relocate by memcpy. So do many types that are not trivially
+// copyable, because their move leaves nothing behind that the destructor would have to
+// undo: std::unique_ptr, or a class owning a heap buffer through a pointer. Such types
+// opt in by specializing the trait:
+//
+//   template <> struct cst::is_trivially_relocatable<my_string> : std::true_type {};
+//
+// Types holding pointers into themselves (small_vector's inline buffer, some std::string
+// implementations) must not.
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace cst {
+
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+template <typename T>
+struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+// Moves `count` elements to uninitialized `to` and destroys the originals. Copies
+// instead when moving could throw and copying is possible, like std::vector.
+template <typename T>
+void relocate(T* from, std::size_t count, T* to) {
+  if constexpr (is_trivially_relocatable_v<T>) {
+    if (count != 0) {
+      std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+    }
+  } else {
+    if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+      std::uninitialized_move_n(from, count, to);
+    } else {
+      std::uninitialized_copy_n(from, count, to);
+    }
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (std::size_t i = 0; i < count; ++i) {
+        from[i].~T();
+      }
+    }
+  }
+}
+
+} // namespace cst
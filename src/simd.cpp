@@ -0,0 +1,670 @@
+#include "simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CST_SIMD_X86 1
+#define CST_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#elif (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER)
+#define CST_SIMD_X86 1
+#define CST_TARGET(isa) // MSVC accepts every intrinsic without target options.
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace cst {
+namespace simd {
+
+namespace {
+
+// Register counts after which 32-bit lane counters are folded into a size_t.
+constexpr std::size_t count_flush_interval = std::size_t(1) << 24;
+
+template <typename T>
+T wrapping_add(T a, T b) {
+  if constexpr (std::is_integral<T>::value) {
+    using U = std::make_unsigned_t<T>;
+    return static_cast<T>(static_cast<U>(a) + static_cast<U>(b));
+  } else {
+    return a + b;
+  }
+}
+
+// The whole string as one integer, like std::stoi without its leniency.
+template <typename T>
+bool from_chars_exact(std::string_view s, T& value) {
+  const auto r = std::from_chars(s.data(), s.data() + s.size(), value);
+  return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+namespace scalar {
+
+#define CST_SIMD_TARGET
+
+inline bool parse_digits16(const char* p, std::uint64_t& value) {
+  std::uint64_t v = 0;
+  for (unsigned i = 0; i < 16; ++i) {
+    const unsigned digit = static_cast<unsigned char>(p[i]) - unsigned('0');
+    if (digit > 9) {
+      return false;
+    }
+    v = v * 10 + digit;
+  }
+  value = v;
+  return true;
+}
+
+template <typename T>
+struct ops {
+  using vec = T;
+  using counter = std::size_t;
+  static constexpr std::size_t lanes = 1;
+  static T zero() { return T(0); }
+  static T splat(T v) { return v; }
+  static T load(const T* p) { return *p; }
+  static void store(T* p, T v) { *p = v; }
+  static T add(T a, T b) { return wrapping_add(a, b); }
+  static T min(T a, T b) { return b < a ? b : a; }
+  static T max(T a, T b) { return a < b ? b : a; }
+  static counter counter_zero() { return 0; }
+  static counter count_eq(counter c, T a, T b) { return c + (a == b ? 1 : 0); }
+  static std::size_t count_total(counter c) { return c; }
+};
+
+#include "simd_kernels.inc"
+#undef CST_SIMD_TARGET
+
+std::uint64_t byte_mask64(const char* p, const byte_set& set) {
+  std::uint64_t mask = 0;
+  for (unsigned i = 0; i < 64; ++i) {
+    mask |= std::uint64_t(set.contains(p[i]) ? 1 : 0) << i;
+  }
+  return mask;
+}
+
+} // namespace scalar
+
+#ifdef CST_SIMD_X86
+
+namespace sse2 {
+
+#define CST_SIMD_TARGET CST_TARGET("sse2")
+
+CST_SIMD_TARGET inline __m128i select(__m128i mask, __m128i if_set, __m128i if_clear) {
+  return _mm_or_si128(_mm_and_si128(mask, if_set), _mm_andnot_si128(mask, if_clear));
+}
+
+// Signed 64-bit a > b, which SSE2 lacks: compare the high halves signed and, where they
+// are equal, the low halves unsigned.
+CST_SIMD_TARGET inline __m128i cmpgt_epi64(__m128i a, __m128i b) {
+  const __m128i flip_low = _mm_set_epi32(0, std::numeric_limits<int>::min(), 0, std::numeric_limits<int>::min());
+  const __m128i ax = _mm_xor_si128(a, flip_low);
+  const __m128i bx = _mm_xor_si128(b, flip_low);
+  const __m128i gt = _mm_cmpgt_epi32(ax, bx);
+  const __m128i eq = _mm_cmpeq_epi32(ax, bx);
+  const __m128i gt_low = _mm_shuffle_epi32(gt, _MM_SHUFFLE(2, 2, 0, 0));
+  const __m128i gt_high = _mm_shuffle_epi32(gt, _MM_SHUFFLE(3, 3, 1, 1));
+  const __m128i eq_high = _mm_shuffle_epi32(eq, _MM_SHUFFLE(3, 3, 1, 1));
+  return _mm_or_si128(gt_high, _mm_and_si128(eq_high, gt_low));
+}
+
+CST_SIMD_TARGET inline std::size_t total32(__m128i c) {
+  std::uint32_t lanes[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), c);
+  return std::size_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+}
+
+CST_SIMD_TARGET inline std::size_t total64(__m128i c) {
+  std::uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), c);
+  return static_cast<std::size_t>(lanes[0] + lanes[1]);
+}
+
+// Bytes below '0' wrap around to large values, so one unsigned compare checks both ends.
+CST_SIMD_TARGET inline __m128i decimal_digits(const char* p, bool& valid) {
+  const __m128i digits = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), _mm_set1_epi8('0'));
+  const __m128i nine = _mm_set1_epi8(9);
+  valid = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(digits, nine), nine)) == 0xffff;
+  return digits;
+}
+
+// Pairs of digits, then of pairs, then of quadruples, multiplied and added in 16 and
+// 32-bit lanes; the first digit is the most significant.
+CST_SIMD_TARGET inline bool parse_digits16(const char* p, std::uint64_t& value) {
+  bool valid;
+  const __m128i digits = decimal_digits(p, valid);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i by_10 = _mm_set_epi16(1, 10, 1, 10, 1, 10, 1, 10);
+  const __m128i pairs = _mm_packs_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(digits, zero), by_10),
+                                        _mm_madd_epi16(_mm_unpackhi_epi8(digits, zero), by_10));
+  const __m128i quads = _mm_madd_epi16(pairs, _mm_set_epi16(1, 100, 1, 100, 1, 100, 1, 100));
+  const __m128i octets =
+      _mm_madd_epi16(_mm_packs_epi32(quads, quads), _mm_set_epi16(1, 10000, 1, 10000, 1, 10000, 1, 10000));
+  value = std::uint64_t(static_cast<std::uint32_t>(_mm_cvtsi128_si32(octets))) * 100000000 +
+          static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(octets, 4)));
+  return valid;
+}
+
+template <typename T>
+struct ops;
+
+template <>
+struct ops<std::int32_t> {
+  using vec = __m128i;
+  using counter = __m128i;
+  static constexpr std::size_t lanes = 4;
+  CST_SIMD_TARGET static vec zero() { return _mm_setzero_si128(); }
+  CST_SIMD_TARGET static vec splat(std::int32_t v) { return _mm_set1_epi32(v); }
+  CST_SIMD_TARGET static vec load(const std::int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+  CST_SIMD_TARGET static void store(std::int32_t* p, vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm_add_epi32(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return select(_mm_cmpgt_epi32(a, b), b, a); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return select(_mm_cmpgt_epi32(a, b), a, b); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm_setzero_si128(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) { return _mm_sub_epi32(c, _mm_cmpeq_epi32(a, b)); }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total32(c); }
+};
+
+template <>
+struct ops<std::int64_t> {
+  using vec = __m128i;
+  using counter = __m128i;
+  static constexpr std::size_t lanes = 2;
+  CST_SIMD_TARGET static vec zero() { return _mm_setzero_si128(); }
+  CST_SIMD_TARGET static vec splat(std::int64_t v) { return _mm_set1_epi64x(v); }
+  CST_SIMD_TARGET static vec load(const std::int64_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+  CST_SIMD_TARGET static void store(std::int64_t* p, vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm_add_epi64(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return select(cmpgt_epi64(a, b), b, a); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return select(cmpgt_epi64(a, b), a, b); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm_setzero_si128(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) {
+    // Both 32-bit halves equal.
+    const __m128i eq = _mm_cmpeq_epi32(a, b);
+    return _mm_sub_epi64(c, _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1))));
+  }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total64(c); }
+};
+
+template <>
+struct ops<float> {
+  using vec = __m128;
+  using counter = __m128i;
+  static constexpr std::size_t lanes = 4;
+  CST_SIMD_TARGET static vec zero() { return _mm_setzero_ps(); }
+  CST_SIMD_TARGET static vec splat(float v) { return _mm_set1_ps(v); }
+  CST_SIMD_TARGET static vec load(const float* p) { return _mm_loadu_ps(p); }
+  CST_SIMD_TARGET static void store(float* p, vec v) { _mm_storeu_ps(p, v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm_add_ps(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return _mm_min_ps(a, b); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return _mm_max_ps(a, b); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm_setzero_si128(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) {
+    return _mm_sub_epi32(c, _mm_castps_si128(_mm_cmpeq_ps(a, b)));
+  }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total32(c); }
+};
+
+template <>
+struct ops<double> {
+  using vec = __m128d;
+  using counter = __m128i;
+  static constexpr std::size_t lanes = 2;
+  CST_SIMD_TARGET static vec zero() { return _mm_setzero_pd(); }
+  CST_SIMD_TARGET static vec splat(double v) { return _mm_set1_pd(v); }
+  CST_SIMD_TARGET static vec load(const double* p) { return _mm_loadu_pd(p); }
+  CST_SIMD_TARGET static void store(double* p, vec v) { _mm_storeu_pd(p, v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm_add_pd(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return _mm_min_pd(a, b); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return _mm_max_pd(a, b); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm_setzero_si128(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) {
+    return _mm_sub_epi64(c, _mm_castpd_si128(_mm_cmpeq_pd(a, b)));
+  }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total64(c); }
+};
+
+#include "simd_kernels.inc"
+
+CST_SIMD_TARGET std::uint64_t byte_mask64(const char* p, const byte_set& set) {
+  const __m128i b0 = _mm_set1_epi8(set[0]), b1 = _mm_set1_epi8(set[1]);
+  const __m128i b2 = _mm_set1_epi8(set[2]), b3 = _mm_set1_epi8(set[3]);
+  std::uint64_t mask = 0;
+  for (unsigned i = 0; i < 64; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    const __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, b0), _mm_cmpeq_epi8(v, b1)),
+                                    _mm_or_si128(_mm_cmpeq_epi8(v, b2), _mm_cmpeq_epi8(v, b3)));
+    mask |= std::uint64_t(static_cast<std::uint32_t>(_mm_movemask_epi8(eq))) << i;
+  }
+  return mask;
+}
+
+#undef CST_SIMD_TARGET
+
+} // namespace sse2
+
+namespace avx2 {
+
+#define CST_SIMD_TARGET CST_TARGET("avx2")
+
+CST_SIMD_TARGET inline std::size_t total32(__m256i c) {
+  std::uint32_t lanes[8];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), c);
+  std::size_t total = 0;
+  for (std::uint32_t x : lanes) {
+    total += x;
+  }
+  return total;
+}
+
+// AVX2 implies SSSE3 and SSE4.1, whose byte multiply-add and unsigned pack save the
+// widening steps of the SSE2 version.
+CST_SIMD_TARGET inline bool parse_digits16(const char* p, std::uint64_t& value) {
+  bool valid;
+  const __m128i digits = sse2::decimal_digits(p, valid);
+  const __m128i pairs = _mm_maddubs_epi16(digits, _mm_set_epi8(1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10));
+  const __m128i quads = _mm_madd_epi16(pairs, _mm_set_epi16(1, 100, 1, 100, 1, 100, 1, 100));
+  const __m128i octets =
+      _mm_madd_epi16(_mm_packus_epi32(quads, quads), _mm_set_epi16(1, 10000, 1, 10000, 1, 10000, 1, 10000));
+  value = std::uint64_t(static_cast<std::uint32_t>(_mm_cvtsi128_si32(octets))) * 100000000 +
+          static_cast<std::uint32_t>(_mm_extract_epi32(octets, 1));
+  return valid;
+}
+
+CST_SIMD_TARGET inline std::size_t total64(__m256i c) {
+  std::uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), c);
+  return static_cast<std::size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+
+template <typename T>
+struct ops;
+
+template <>
+struct ops<std::int32_t> {
+  using vec = __m256i;
+  using counter = __m256i;
+  static constexpr std::size_t lanes = 8;
+  CST_SIMD_TARGET static vec zero() { return _mm256_setzero_si256(); }
+  CST_SIMD_TARGET static vec splat(std::int32_t v) { return _mm256_set1_epi32(v); }
+  CST_SIMD_TARGET static vec load(const std::int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+  CST_SIMD_TARGET static void store(std::int32_t* p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm256_add_epi32(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return _mm256_min_epi32(a, b); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return _mm256_max_epi32(a, b); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm256_setzero_si256(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) { return _mm256_sub_epi32(c, _mm256_cmpeq_epi32(a, b)); }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total32(c); }
+};
+
+template <>
+struct ops<std::int64_t> {
+  using vec = __m256i;
+  using counter = __m256i;
+  static constexpr std::size_t lanes = 4;
+  CST_SIMD_TARGET static vec zero() { return _mm256_setzero_si256(); }
+  CST_SIMD_TARGET static vec splat(std::int64_t v) { return _mm256_set1_epi64x(v); }
+  CST_SIMD_TARGET static vec load(const std::int64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+  CST_SIMD_TARGET static void store(std::int64_t* p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm256_add_epi64(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm256_setzero_si256(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) { return _mm256_sub_epi64(c, _mm256_cmpeq_epi64(a, b)); }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total64(c); }
+};
+
+template <>
+struct ops<float> {
+  using vec = __m256;
+  using counter = __m256i;
+  static constexpr std::size_t lanes = 8;
+  CST_SIMD_TARGET static vec zero() { return _mm256_setzero_ps(); }
+  CST_SIMD_TARGET static vec splat(float v) { return _mm256_set1_ps(v); }
+  CST_SIMD_TARGET static vec load(const float* p) { return _mm256_loadu_ps(p); }
+  CST_SIMD_TARGET static void store(float* p, vec v) { _mm256_storeu_ps(p, v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm256_add_ps(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return _mm256_min_ps(a, b); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return _mm256_max_ps(a, b); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm256_setzero_si256(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) {
+    return _mm256_sub_epi32(c, _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)));
+  }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total32(c); }
+};
+
+template <>
+struct ops<double> {
+  using vec = __m256d;
+  using counter = __m256i;
+  static constexpr std::size_t lanes = 4;
+  CST_SIMD_TARGET static vec zero() { return _mm256_setzero_pd(); }
+  CST_SIMD_TARGET static vec splat(double v) { return _mm256_set1_pd(v); }
+  CST_SIMD_TARGET static vec load(const double* p) { return _mm256_loadu_pd(p); }
+  CST_SIMD_TARGET static void store(double* p, vec v) { _mm256_storeu_pd(p, v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm256_add_pd(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return _mm256_min_pd(a, b); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return _mm256_max_pd(a, b); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm256_setzero_si256(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) {
+    return _mm256_sub_epi64(c, _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)));
+  }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total64(c); }
+};
+
+#include "simd_kernels.inc"
+
+CST_SIMD_TARGET inline std::uint32_t byte_mask32(const char* p, __m256i b0, __m256i b1, __m256i b2, __m256i b3) {
+  const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  const __m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, b0), _mm256_cmpeq_epi8(v, b1)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, b2), _mm256_cmpeq_epi8(v, b3)));
+  return static_cast<std::uint32_t>(_mm256_movemask_epi8(eq));
+}
+
+// Also used at the AVX-512 level: byte compares need AVX512BW on top of AVX512F.
+CST_SIMD_TARGET std::uint64_t byte_mask64(const char* p, const byte_set& set) {
+  const __m256i b0 = _mm256_set1_epi8(set[0]), b1 = _mm256_set1_epi8(set[1]);
+  const __m256i b2 = _mm256_set1_epi8(set[2]), b3 = _mm256_set1_epi8(set[3]);
+  return byte_mask32(p, b0, b1, b2, b3) | std::uint64_t(byte_mask32(p + 32, b0, b1, b2, b3)) << 32;
+}
+
+#undef CST_SIMD_TARGET
+
+} // namespace avx2
+
+// GCC's _mm512_min/max_* pass _mm512_undefined_* as the unused merge source.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace avx512 {
+
+#define CST_SIMD_TARGET CST_TARGET("avx512f")
+
+CST_SIMD_TARGET inline std::size_t total32(__m512i c) {
+  std::uint32_t lanes[16];
+  _mm512_storeu_si512(lanes, c);
+  std::size_t total = 0;
+  for (std::uint32_t x : lanes) {
+    total += x;
+  }
+  return total;
+}
+
+CST_SIMD_TARGET inline std::size_t total64(__m512i c) {
+  std::uint64_t lanes[8];
+  _mm512_storeu_si512(lanes, c);
+  std::size_t total = 0;
+  for (std::uint64_t x : lanes) {
+    total += static_cast<std::size_t>(x);
+  }
+  return total;
+}
+
+using avx2::parse_digits16;
+
+// Comparisons produce bit masks here; matching lanes of the counter are incremented.
+template <typename T>
+struct ops;
+
+template <>
+struct ops<std::int32_t> {
+  using vec = __m512i;
+  using counter = __m512i;
+  static constexpr std::size_t lanes = 16;
+  CST_SIMD_TARGET static vec zero() { return _mm512_setzero_si512(); }
+  CST_SIMD_TARGET static vec splat(std::int32_t v) { return _mm512_set1_epi32(v); }
+  CST_SIMD_TARGET static vec load(const std::int32_t* p) { return _mm512_loadu_si512(p); }
+  CST_SIMD_TARGET static void store(std::int32_t* p, vec v) { _mm512_storeu_si512(p, v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm512_add_epi32(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return _mm512_min_epi32(a, b); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return _mm512_max_epi32(a, b); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm512_setzero_si512(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) {
+    return _mm512_mask_add_epi32(c, _mm512_cmpeq_epi32_mask(a, b), c, _mm512_set1_epi32(1));
+  }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total32(c); }
+};
+
+template <>
+struct ops<std::int64_t> {
+  using vec = __m512i;
+  using counter = __m512i;
+  static constexpr std::size_t lanes = 8;
+  CST_SIMD_TARGET static vec zero() { return _mm512_setzero_si512(); }
+  CST_SIMD_TARGET static vec splat(std::int64_t v) { return _mm512_set1_epi64(v); }
+  CST_SIMD_TARGET static vec load(const std::int64_t* p) { return _mm512_loadu_si512(p); }
+  CST_SIMD_TARGET static void store(std::int64_t* p, vec v) { _mm512_storeu_si512(p, v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm512_add_epi64(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return _mm512_min_epi64(a, b); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return _mm512_max_epi64(a, b); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm512_setzero_si512(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) {
+    return _mm512_mask_add_epi64(c, _mm512_cmpeq_epi64_mask(a, b), c, _mm512_set1_epi64(1));
+  }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total64(c); }
+};
+
+template <>
+struct ops<float> {
+  using vec = __m512;
+  using counter = __m512i;
+  static constexpr std::size_t lanes = 16;
+  CST_SIMD_TARGET static vec zero() { return _mm512_setzero_ps(); }
+  CST_SIMD_TARGET static vec splat(float v) { return _mm512_set1_ps(v); }
+  CST_SIMD_TARGET static vec load(const float* p) { return _mm512_loadu_ps(p); }
+  CST_SIMD_TARGET static void store(float* p, vec v) { _mm512_storeu_ps(p, v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm512_add_ps(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return _mm512_min_ps(a, b); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return _mm512_max_ps(a, b); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm512_setzero_si512(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) {
+    return _mm512_mask_add_epi32(c, _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ), c, _mm512_set1_epi32(1));
+  }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total32(c); }
+};
+
+template <>
+struct ops<double> {
+  using vec = __m512d;
+  using counter = __m512i;
+  static constexpr std::size_t lanes = 8;
+  CST_SIMD_TARGET static vec zero() { return _mm512_setzero_pd(); }
+  CST_SIMD_TARGET static vec splat(double v) { return _mm512_set1_pd(v); }
+  CST_SIMD_TARGET static vec load(const double* p) { return _mm512_loadu_pd(p); }
+  CST_SIMD_TARGET static void store(double* p, vec v) { _mm512_storeu_pd(p, v); }
+  CST_SIMD_TARGET static vec add(vec a, vec b) { return _mm512_add_pd(a, b); }
+  CST_SIMD_TARGET static vec min(vec a, vec b) { return _mm512_min_pd(a, b); }
+  CST_SIMD_TARGET static vec max(vec a, vec b) { return _mm512_max_pd(a, b); }
+  CST_SIMD_TARGET static counter counter_zero() { return _mm512_setzero_si512(); }
+  CST_SIMD_TARGET static counter count_eq(counter c, vec a, vec b) {
+    return _mm512_mask_add_epi64(c, _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ), c, _mm512_set1_epi64(1));
+  }
+  CST_SIMD_TARGET static std::size_t count_total(counter c) { return total64(c); }
+};
+
+#include "simd_kernels.inc"
+#undef CST_SIMD_TARGET
+
+} // namespace avx512
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // CST_SIMD_X86
+
+isa detect() {
+#if defined(CST_SIMD_X86) && defined(__GNUC__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return isa::avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return isa::avx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return isa::sse2;
+  }
+#elif defined(CST_SIMD_X86)
+  int regs[4];
+  __cpuid(regs, 0);
+  const int max_leaf = regs[0];
+  __cpuid(regs, 1);
+  const bool sse2 = (regs[3] & (1 << 26)) != 0;
+  // The OS must save the wide registers on context switches.
+  const bool osxsave = (regs[2] & (1 << 27)) != 0;
+  const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+  if (max_leaf >= 7) {
+    __cpuidex(regs, 7, 0);
+    if ((regs[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6) {
+      return isa::avx512;
+    }
+    if ((regs[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6) {
+      return isa::avx2;
+    }
+  }
+  if (sse2) {
+    return isa::sse2;
+  }
+#endif
+  return isa::scalar;
+}
+
+std::atomic<int> active_level{-1};
+
+template <typename T>
+std::size_t dispatch_count_equal(span<const T> data, T value) {
+  switch (active_isa()) {
+#ifdef CST_SIMD_X86
+    case isa::avx512: return avx512::count_equal(data.data(), data.size(), value);
+    case isa::avx2: return avx2::count_equal(data.data(), data.size(), value);
+    case isa::sse2: return sse2::count_equal(data.data(), data.size(), value);
+#endif
+    default: return scalar::count_equal(data.data(), data.size(), value);
+  }
+}
+
+template <typename T>
+T dispatch_sum(span<const T> data) {
+  switch (active_isa()) {
+#ifdef CST_SIMD_X86
+    case isa::avx512: return avx512::sum(data.data(), data.size());
+    case isa::avx2: return avx2::sum(data.data(), data.size());
+    case isa::sse2: return sse2::sum(data.data(), data.size());
+#endif
+    default: return scalar::sum(data.data(), data.size());
+  }
+}
+
+template <typename T>
+minmax_result<T> dispatch_minmax(span<const T> data) {
+  switch (active_isa()) {
+#ifdef CST_SIMD_X86
+    case isa::avx512: return avx512::minmax(data.data(), data.size());
+    case isa::avx2: return avx2::minmax(data.data(), data.size());
+    case isa::sse2: return sse2::minmax(data.data(), data.size());
+#endif
+    default: return scalar::minmax(data.data(), data.size());
+  }
+}
+
+template <typename T>
+std::size_t dispatch_parse_integers(span<const std::string_view> text, span<T> out) {
+  const std::size_t n = std::min(text.size(), out.size());
+  switch (active_isa()) {
+#ifdef CST_SIMD_X86
+    case isa::avx512: return avx512::parse_integers(text.data(), n, out.data());
+    case isa::avx2: return avx2::parse_integers(text.data(), n, out.data());
+    case isa::sse2: return sse2::parse_integers(text.data(), n, out.data());
+#endif
+    default: return scalar::parse_integers(text.data(), n, out.data());
+  }
+}
+
+} // namespace
+
+byte_set::byte_set(std::string_view bytes) {
+  if (bytes.empty() || bytes.size() > 4) {
+    throw std::invalid_argument("byte_set takes 1 to 4 bytes");
+  }
+  for (std::size_t i = 0; i < 4; ++i) {
+    bytes_[i] = i < bytes.size() ? bytes[i] : bytes[0];
+  }
+  filler_ = 0;
+  while (contains(filler_)) {
+    ++filler_;
+  }
+}
+
+std::uint64_t byte_mask64(const char* p, const byte_set& set) {
+  switch (active_isa()) {
+#ifdef CST_SIMD_X86
+    case isa::avx512:
+    case isa::avx2: return avx2::byte_mask64(p, set);
+    case isa::sse2: return sse2::byte_mask64(p, set);
+#endif
+    default: return scalar::byte_mask64(p, set);
+  }
+}
+
+const char* to_string(isa level) {
+  switch (level) {
+    case isa::sse2: return "sse2";
+    case isa::avx2: return "avx2";
+    case isa::avx512: return "avx512";
+    default: return "scalar";
+  }
+}
+
+isa best_isa() {
+  static const isa best = detect();
+  return best;
+}
+
+isa active_isa() {
+  int level = active_level.load(std::memory_order_relaxed);
+  if (level < 0) {
+    level = static_cast<int>(best_isa());
+    active_level.store(level, std::memory_order_relaxed);
+  }
+  return static_cast<isa>(level);
+}
+
+isa set_isa(isa level) {
+  level = std::min(level, best_isa());
+  active_level.store(static_cast<int>(level), std::memory_order_relaxed);
+  return level;
+}
+
+std::size_t count_equal(span<const std::int32_t> data, std::int32_t value) { return dispatch_count_equal(data, value); }
+std::size_t count_equal(span<const std::int64_t> data, std::int64_t value) { return dispatch_count_equal(data, value); }
+std::size_t count_equal(span<const float> data, float value) { return dispatch_count_equal(data, value); }
+std::size_t count_equal(span<const double> data, double value) { return dispatch_count_equal(data, value); }
+
+std::int32_t sum(span<const std::int32_t> data) { return dispatch_sum(data); }
+std::int64_t sum(span<const std::int64_t> data) { return dispatch_sum(data); }
+float sum(span<const float> data) { return dispatch_sum(data); }
+double sum(span<const double> data) { return dispatch_sum(data); }
+
+minmax_result<std::int32_t> minmax(span<const std::int32_t> data) { return dispatch_minmax(data); }
+minmax_result<std::int64_t> minmax(span<const std::int64_t> data) { return dispatch_minmax(data); }
+minmax_result<float> minmax(span<const float> data) { return dispatch_minmax(data); }
+minmax_result<double> minmax(span<const double> data) { return dispatch_minmax(data); }
+
+std::size_t parse_integers(span<const std::string_view> text, span<std::int32_t> out) {
+  return dispatch_parse_integers(text, out);
+}
+std::size_t parse_integers(span<const std::string_view> text, span<std::int64_t> out) {
+  return dispatch_parse_integers(text, out);
+}
+
+} // namespace simd
+} // namespace cst
@@ -0,0 +1,105 @@
+#pragma once
+
+// Vectorized counting and reduction kernels with runtime dispatch: the widest of
+// AVX-512, AVX2 and SSE2 that the CPU supports is picked on first use, other
+// architectures and compilers run the scalar loops.
+//
+//   std::vector<int> v = ...;
+//   auto twos = cst::simd::count_equal(v, 2);
+//   auto total = cst::simd::sum(v);
+//   auto [lo, hi] = cst::simd::minmax(v);
+//   auto commas = cst::simd::byte_mask64(line, cst::simd::byte_set(",\n")); // one bit per byte
+//   auto parsed = cst::simd::parse_integers(fields, numbers); // == fields.size() if all are numbers
+//
+// Integer sums wrap around like unsigned arithmetic; floating point sums are computed
+// in a different order than a sequential loop, so they may differ in the last bits.
+// min/max/minmax of floating point data containing NaN are unspecified.
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "span.h"
+
+namespace cst {
+namespace simd {
+
+enum class isa { scalar, sse2, avx2, avx512 };
+
+const char* to_string(isa level);
+// Widest instruction set supported by the CPU and the build.
+isa best_isa();
+// Instruction set the kernels currently dispatch to, best_isa() unless overridden.
+isa active_isa();
+// Dispatches to `level`, clamped to best_isa(); returns the level in use. Meant for
+// tests and benchmarks comparing the implementations.
+isa set_isa(isa level);
+
+template <typename T>
+struct is_supported
+    : std::bool_constant<std::is_same<T, std::int32_t>::value || std::is_same<T, std::int64_t>::value ||
+                         std::is_same<T, float>::value || std::is_same<T, double>::value> {};
+template <typename T>
+inline constexpr bool is_supported_v = is_supported<T>::value;
+
+template <typename T>
+struct minmax_result {
+  T min;
+  T max;
+};
+
+std::size_t count_equal(span<const std::int32_t> data, std::int32_t value);
+std::size_t count_equal(span<const std::int64_t> data, std::int64_t value);
+std::size_t count_equal(span<const float> data, float value);
+std::size_t count_equal(span<const double> data, double value);
+
+std::int32_t sum(span<const std::int32_t> data);
+std::int64_t sum(span<const std::int64_t> data);
+float sum(span<const float> data);
+double sum(span<const double> data);
+
+// Empty input yields {numeric_limits::max(), numeric_limits::lowest()}.
+minmax_result<std::int32_t> minmax(span<const std::int32_t> data);
+minmax_result<std::int64_t> minmax(span<const std::int64_t> data);
+minmax_result<float> minmax(span<const float> data);
+minmax_result<double> minmax(span<const double> data);
+
+// Up to four distinct bytes looked for at once, e.g. the delimiters of a tokenizer.
+// Throws std::invalid_argument for an empty set or more than four bytes.
+class byte_set {
+public:
+  explicit byte_set(std::string_view bytes);
+
+  bool contains(char c) const { return c == bytes_[0] || c == bytes_[1] || c == bytes_[2] || c == bytes_[3]; }
+  char operator[](std::size_t i) const { return bytes_[i]; }
+  // A byte outside the set, for padding the end of a buffer.
+  char filler() const { return filler_; }
+
+private:
+  char bytes_[4]; // unused slots repeat the first byte
+  char filler_;
+};
+
+// Bit i of the result is set when p[i] is in `set`. Reads exactly 64 bytes.
+std::uint64_t byte_mask64(const char* p, const byte_set& set);
+
+// Decimal integers as std::from_chars reads them, an optional '-' and digits, but each
+// string has to be a number as a whole. Parses text[i] into out[i] and returns how many
+// strings in a row succeeded; the one after them is not a number or out of range.
+// At most min(text.size(), out.size()) strings are parsed.
+std::size_t parse_integers(span<const std::string_view> text, span<std::int32_t> out);
+std::size_t parse_integers(span<const std::string_view> text, span<std::int64_t> out);
+
+// Precondition: !data.empty().
+template <typename Range>
+auto min(const Range& data) {
+  return minmax(data).min;
+}
+template <typename Range>
+auto max(const Range& data) {
+  return minmax(data).max;
+}
+
+} // namespace simd
+} // namespace cst
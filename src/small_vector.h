@@ -0,0 +1,379 @@
+#pragma once
+
+// std::vector with room for N elements inside the object, for the many short sequences
+// that would otherwise cost a heap allocation each:
+//
+//   cst::small_vector<int, 4> v{1, 2, 3}; // no allocation
+//   v.push_back(4);                       // still inline
+//   v.push_back(5);                       // moves to the heap, capacity doubles from here
+//
+// The interface is the one of std::vector without allocators. Unlike std::vector, moving
+// an inline small_vector moves the elements one by one, so it invalidates iterators and
+// is only noexcept when T's move constructor is. Growing relocates the elements with
+// memcpy when cst::is_trivially_relocatable<T> holds.
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "relocate.h"
+
+namespace cst {
+
+template <typename T, std::size_t N>
+class small_vector {
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static constexpr size_type inline_capacity = N;
+
+  small_vector() noexcept : data_(inline_data()), capacity_(N) {}
+  explicit small_vector(size_type count) : small_vector() { resize(count); }
+  small_vector(size_type count, const T& value) : small_vector() { assign(count, value); }
+  template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+  small_vector(InputIt first, InputIt last) : small_vector() {
+    assign(first, last);
+  }
+  small_vector(std::initializer_list<T> init) : small_vector() { assign(init.begin(), init.end()); }
+
+  small_vector(const small_vector& other) : small_vector() { assign(other.begin(), other.end()); }
+  small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) : small_vector() {
+    take(std::move(other));
+  }
+  ~small_vector() {
+    destroy(begin(), end());
+    release();
+  }
+
+  small_vector& operator=(const small_vector& other) {
+    if (this != &other) {
+      assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+  small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      clear();
+      release();
+      data_ = inline_data();
+      capacity_ = N;
+      take(std::move(other));
+    }
+    return *this;
+  }
+  small_vector& operator=(std::initializer_list<T> init) {
+    assign(init.begin(), init.end());
+    return *this;
+  }
+
+  void assign(size_type count, const T& value) {
+    const T copy(value); // `value` may be one of ours
+    clear();
+    reserve(count);
+    std::uninitialized_fill_n(data_, count, copy);
+    size_ = count;
+  }
+  template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+  void assign(InputIt first, InputIt last) {
+    clear();
+    append(first, last);
+  }
+  void assign(std::initializer_list<T> init) { assign(init.begin(), init.end()); }
+
+  reference at(size_type pos) {
+    check(pos);
+    return data_[pos];
+  }
+  const_reference at(size_type pos) const {
+    check(pos);
+    return data_[pos];
+  }
+  reference operator[](size_type pos) { return data_[pos]; }
+  const_reference operator[](size_type pos) const { return data_[pos]; }
+  reference front() { return data_[0]; }
+  const_reference front() const { return data_[0]; }
+  reference back() { return data_[size_ - 1]; }
+  const_reference back() const { return data_[size_ - 1]; }
+  T* data() noexcept { return data_; }
+  const T* data() const noexcept { return data_; }
+
+  iterator begin() noexcept { return data_; }
+  const_iterator begin() const noexcept { return data_; }
+  const_iterator cbegin() const noexcept { return data_; }
+  iterator end() noexcept { return data_ + size_; }
+  const_iterator end() const noexcept { return data_ + size_; }
+  const_iterator cend() const noexcept { return data_ + size_; }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crend() const noexcept { return const_reverse_iterator(begin()); }
+
+  bool empty() const noexcept { return size_ == 0; }
+  size_type size() const noexcept { return size_; }
+  size_type max_size() const noexcept { return std::allocator_traits<std::allocator<T>>::max_size(std::allocator<T>()); }
+  size_type capacity() const noexcept { return capacity_; }
+  // True while the elements live in the object itself.
+  bool is_inline() const noexcept { return data_ == inline_data(); }
+
+  void reserve(size_type new_capacity) {
+    if (new_capacity > capacity_) {
+      reallocate(new_capacity);
+    }
+  }
+  // Moves back inline when the elements fit, otherwise trims the heap block.
+  void shrink_to_fit() {
+    if (is_inline() || size_ == capacity_) {
+      return;
+    }
+    if (size_ <= N) {
+      T* old = data_;
+      const size_type old_capacity = capacity_;
+      cst::relocate(old, size_, inline_data());
+      data_ = inline_data();
+      capacity_ = N;
+      std::allocator<T>().deallocate(old, old_capacity);
+    } else {
+      reallocate(size_);
+    }
+  }
+
+  void clear() noexcept {
+    destroy(begin(), end());
+    size_ = 0;
+  }
+
+  iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+  iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+  iterator insert(const_iterator pos, size_type count, const T& value) {
+    const size_type offset = index(pos);
+    const T copy(value);
+    reserve(size_ + count);
+    std::uninitialized_fill_n(end(), count, copy);
+    size_ += count;
+    std::rotate(begin() + offset, end() - count, end());
+    return begin() + offset;
+  }
+  template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    const size_type offset = index(pos);
+    const size_type old_size = size_;
+    append(first, last);
+    std::rotate(begin() + offset, begin() + old_size, end());
+    return begin() + offset;
+  }
+  iterator insert(const_iterator pos, std::initializer_list<T> init) { return insert(pos, init.begin(), init.end()); }
+
+  template <typename... Args>
+  iterator emplace(const_iterator pos, Args&&... args) {
+    const size_type offset = index(pos);
+    emplace_back(std::forward<Args>(args)...);
+    std::rotate(begin() + offset, end() - 1, end());
+    return begin() + offset;
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    iterator f = begin() + index(first);
+    if (first != last) {
+      iterator new_end = std::move(begin() + index(last), end(), f);
+      destroy(new_end, end());
+      size_ = static_cast<size_type>(new_end - begin());
+    }
+    return f;
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    if (size_ == capacity_) {
+      return grow_emplace_back(std::forward<Args>(args)...);
+    }
+    T* p = ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+    ++size_;
+    return *p;
+  }
+  void pop_back() {
+    --size_;
+    data_[size_].~T();
+  }
+
+  void resize(size_type count) {
+    if (count < size_) {
+      erase(begin() + count, end());
+    } else {
+      reserve(count);
+      std::uninitialized_value_construct_n(end(), count - size_);
+      size_ = count;
+    }
+  }
+  void resize(size_type count, const T& value) {
+    if (count < size_) {
+      erase(begin() + count, end());
+    } else {
+      insert(end(), count - size_, value);
+    }
+  }
+
+  void swap(small_vector& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    small_vector tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+  friend void swap(small_vector& a, small_vector& b) noexcept(noexcept(a.swap(b))) { a.swap(b); }
+
+  friend bool operator==(const small_vector& a, const small_vector& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+  friend bool operator!=(const small_vector& a, const small_vector& b) { return !(a == b); }
+  friend bool operator<(const small_vector& a, const small_vector& b) {
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+  }
+  friend bool operator>(const small_vector& a, const small_vector& b) { return b < a; }
+  friend bool operator<=(const small_vector& a, const small_vector& b) { return !(b < a); }
+  friend bool operator>=(const small_vector& a, const small_vector& b) { return !(a < b); }
+
+private:
+  T* inline_data() noexcept { return std::launder(reinterpret_cast<T*>(inline_)); }
+  const T* inline_data() const noexcept { return std::launder(reinterpret_cast<const T*>(inline_)); }
+
+  size_type index(const_iterator pos) const { return static_cast<size_type>(pos - begin()); }
+  void check(size_type pos) const {
+    if (pos >= size_) {
+      throw std::out_of_range("small_vector::at");
+    }
+  }
+
+  static void destroy(T* first, T* last) noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (; first != last; ++first) {
+        first->~T();
+      }
+    }
+  }
+
+  size_type grown_capacity(size_type min_capacity) const {
+    return std::max(min_capacity, std::max<size_type>(2 * capacity_, 1));
+  }
+
+  void reallocate(size_type new_capacity) {
+    T* p = std::allocator<T>().allocate(new_capacity);
+    try {
+      cst::relocate(data_, size_, p);
+    } catch (...) {
+      std::allocator<T>().deallocate(p, new_capacity);
+      throw;
+    }
+    release();
+    data_ = p;
+    capacity_ = new_capacity;
+  }
+
+  // Constructs the new element before the old ones move, `args` may refer to them.
+  template <typename... Args>
+  reference grow_emplace_back(Args&&... args) {
+    const size_type new_capacity = grown_capacity(size_ + 1);
+    T* p = std::allocator<T>().allocate(new_capacity);
+    try {
+      ::new (static_cast<void*>(p + size_)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      std::allocator<T>().deallocate(p, new_capacity);
+      throw;
+    }
+    try {
+      cst::relocate(data_, size_, p);
+    } catch (...) {
+      p[size_].~T();
+      std::allocator<T>().deallocate(p, new_capacity);
+      throw;
+    }
+    release();
+    data_ = p;
+    capacity_ = new_capacity;
+    return data_[size_++];
+  }
+
+  template <typename InputIt>
+  void append(InputIt first, InputIt last) {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+      const auto count = static_cast<size_type>(std::distance(first, last));
+      if (size_ + count <= capacity_) {
+        std::uninitialized_copy(first, last, end());
+        size_ += count;
+        return;
+      }
+      // Copies before the old elements move, the range may be part of them.
+      const size_type new_capacity = grown_capacity(size_ + count);
+      T* p = std::allocator<T>().allocate(new_capacity);
+      try {
+        std::uninitialized_copy(first, last, p + size_);
+        try {
+          cst::relocate(data_, size_, p);
+        } catch (...) {
+          destroy(p + size_, p + size_ + count);
+          throw;
+        }
+      } catch (...) {
+        std::allocator<T>().deallocate(p, new_capacity);
+        throw;
+      }
+      release();
+      data_ = p;
+      capacity_ = new_capacity;
+      size_ += count;
+    } else {
+      for (; first != last; ++first) {
+        emplace_back(*first);
+      }
+    }
+  }
+
+  // Frees the heap block, if any; the elements must already be gone.
+  void release() noexcept {
+    if (!is_inline()) {
+      std::allocator<T>().deallocate(data_, capacity_);
+    }
+  }
+
+  // Expects *this to be empty and inline.
+  void take(small_vector&& other) {
+    if (!other.is_inline()) {
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.data_ = other.inline_data();
+      other.size_ = 0;
+      other.capacity_ = N;
+      return;
+    }
+    std::uninitialized_move(other.begin(), other.end(), data_);
+    size_ = other.size_;
+    other.clear();
+  }
+
+  T* data_;
+  size_type size_ = 0;
+  size_type capacity_;
+  alignas(T) unsigned char inline_[N == 0 ? 1 : N * sizeof(T)];
+};
+
+} // namespace cst
@@ -0,0 +1,256 @@
+#pragma once
+
+// A sequence of records stored as a structure of arrays: one contiguous column per
+// tuple element, for data that is mostly scanned a field at a time.
+//
+//   cst::soa_vector<std::tuple<int, std::string, std::string>> players;
+//   players.push_back({51, "Frans Nielsen", "NYI"});
+//   cst::span<int> numbers = cst::get<0>(players);   // the first field of every row
+//   auto [number, name, team] = players[0];          // references into the columns
+//   std::tie(n, std::ignore, t) = players.back();
+//
+// A scan over one column reads only that field, a std::vector<std::tuple<...>> drags the
+// whole record through the cache for it. Rows are proxies, std::tuple<Ts&...>: they bind
+// and assign like the tuple, and like references they dangle once the row is erased or
+// the columns reallocate.
+// push_back and erase touch every column; if constructing one field throws, the fields
+// already added are removed again.
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "span.h"
+
+namespace cst {
+
+template <typename Tuple>
+class soa_vector;
+
+template <typename... Ts>
+class soa_vector<std::tuple<Ts...>> {
+  static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one column");
+  static_assert(!(std::is_same<Ts, bool>::value || ...), "std::vector<bool> is not contiguous, store char");
+
+  template <bool Const>
+  class basic_iterator;
+
+public:
+  using value_type = std::tuple<Ts...>;
+  using reference = std::tuple<Ts&...>;
+  using const_reference = std::tuple<const Ts&...>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  template <std::size_t I>
+  using column_type = std::tuple_element_t<I, value_type>;
+
+  soa_vector() = default;
+  soa_vector(std::initializer_list<value_type> rows) {
+    reserve(rows.size());
+    for (const auto& row : rows) {
+      push_back(row);
+    }
+  }
+
+  size_type size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+  void reserve(size_type n) {
+    for_each_column([n](auto& c) { c.reserve(n); });
+  }
+  void clear() noexcept {
+    for_each_column([](auto& c) { c.clear(); });
+    size_ = 0;
+  }
+
+  reference operator[](size_type i) { return row(i, std::index_sequence_for<Ts...>{}); }
+  const_reference operator[](size_type i) const { return row(i, std::index_sequence_for<Ts...>{}); }
+  reference at(size_type i) {
+    check(i);
+    return (*this)[i];
+  }
+  const_reference at(size_type i) const {
+    check(i);
+    return (*this)[i];
+  }
+  reference front() { return (*this)[0]; }
+  const_reference front() const { return (*this)[0]; }
+  reference back() { return (*this)[size_ - 1]; }
+  const_reference back() const { return (*this)[size_ - 1]; }
+
+  // Field I of every row, contiguous.
+  template <std::size_t I>
+  span<column_type<I>> column() noexcept {
+    auto& c = std::get<I>(columns_);
+    return {c.data(), c.size()};
+  }
+  template <std::size_t I>
+  span<const column_type<I>> column() const noexcept {
+    const auto& c = std::get<I>(columns_);
+    return {c.data(), c.size()};
+  }
+
+  iterator begin() noexcept { return {this, 0}; }
+  iterator end() noexcept { return {this, size_}; }
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator end() const noexcept { return {this, size_}; }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  // One argument per column.
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    static_assert(sizeof...(Args) == sizeof...(Ts), "emplace_back takes one argument per column");
+    emplace_row(std::index_sequence_for<Ts...>{}, std::forward<Args>(args)...);
+    return back();
+  }
+  void push_back(const value_type& row) {
+    std::apply([this](const Ts&... fields) { emplace_back(fields...); }, row);
+  }
+  void push_back(value_type&& row) {
+    std::apply([this](Ts&... fields) { emplace_back(std::move(fields)...); }, row);
+  }
+  void pop_back() {
+    for_each_column([](auto& c) { c.pop_back(); });
+    --size_;
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    const auto i = static_cast<difference_type>(first.index());
+    const auto j = static_cast<difference_type>(last.index());
+    for_each_column([i, j](auto& c) { c.erase(c.begin() + i, c.begin() + j); });
+    size_ -= static_cast<size_type>(j - i);
+    return {this, static_cast<size_type>(i)};
+  }
+
+  void swap(soa_vector& other) noexcept {
+    columns_.swap(other.columns_);
+    std::swap(size_, other.size_);
+  }
+
+private:
+  template <std::size_t... I>
+  reference row(size_type i, std::index_sequence<I...>) {
+    return reference(std::get<I>(columns_)[i]...);
+  }
+  template <std::size_t... I>
+  const_reference row(size_type i, std::index_sequence<I...>) const {
+    return const_reference(std::get<I>(columns_)[i]...);
+  }
+
+  template <typename F>
+  void for_each_column(F f) {
+    std::apply([&f](auto&... c) { (f(c), ...); }, columns_);
+  }
+
+  template <std::size_t... I, typename... Args>
+  void emplace_row(std::index_sequence<I...>, Args&&... args) {
+    try {
+      (std::get<I>(columns_).emplace_back(std::forward<Args>(args)), ...);
+    } catch (...) {
+      // The columns before the one that threw are a row longer than the rest.
+      for_each_column([this](auto& c) {
+        if (c.size() > size_) {
+          c.pop_back();
+        }
+      });
+      throw;
+    }
+    ++size_;
+  }
+
+  void check(size_type i) const {
+    if (i >= size_) {
+      throw std::out_of_range("soa_vector::at");
+    }
+  }
+
+  std::tuple<std::vector<Ts>...> columns_;
+  size_type size_ = 0;
+};
+
+// Rows by position; dereferencing makes a proxy, so there is no operator->.
+template <typename... Ts>
+template <bool Const>
+class soa_vector<std::tuple<Ts...>>::basic_iterator {
+  using owner = std::conditional_t<Const, const soa_vector, soa_vector>;
+
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = std::tuple<Ts...>;
+  using difference_type = std::ptrdiff_t;
+  using reference = std::conditional_t<Const, std::tuple<const Ts&...>, std::tuple<Ts&...>>;
+  using pointer = void;
+
+  basic_iterator() = default;
+  basic_iterator(owner* v, size_type i) : v_(v), i_(i) {}
+  template <bool C = Const, typename = std::enable_if_t<C>>
+  basic_iterator(const basic_iterator<false>& it) : v_(it.v_), i_(it.i_) {}
+
+  reference operator*() const { return (*v_)[i_]; }
+  reference operator[](difference_type n) const { return (*v_)[i_ + static_cast<size_type>(n)]; }
+  size_type index() const { return i_; }
+
+  basic_iterator& operator++() {
+    ++i_;
+    return *this;
+  }
+  basic_iterator operator++(int) {
+    basic_iterator old = *this;
+    ++i_;
+    return old;
+  }
+  basic_iterator& operator--() {
+    --i_;
+    return *this;
+  }
+  basic_iterator operator--(int) {
+    basic_iterator old = *this;
+    --i_;
+    return old;
+  }
+  basic_iterator& operator+=(difference_type n) {
+    i_ = static_cast<size_type>(static_cast<difference_type>(i_) + n);
+    return *this;
+  }
+  basic_iterator& operator-=(difference_type n) { return *this += -n; }
+  friend basic_iterator operator+(basic_iterator it, difference_type n) { return it += n; }
+  friend basic_iterator operator+(difference_type n, basic_iterator it) { return it += n; }
+  friend basic_iterator operator-(basic_iterator it, difference_type n) { return it -= n; }
+  friend difference_type operator-(const basic_iterator& a, const basic_iterator& b) {
+    return static_cast<difference_type>(a.i_) - static_cast<difference_type>(b.i_);
+  }
+
+  friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.i_ == b.i_; }
+  friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return a.i_ != b.i_; }
+  friend bool operator<(const basic_iterator& a, const basic_iterator& b) { return a.i_ < b.i_; }
+  friend bool operator>(const basic_iterator& a, const basic_iterator& b) { return a.i_ > b.i_; }
+  friend bool operator<=(const basic_iterator& a, const basic_iterator& b) { return a.i_ <= b.i_; }
+  friend bool operator>=(const basic_iterator& a, const basic_iterator& b) { return a.i_ >= b.i_; }
+
+private:
+  friend class basic_iterator<!Const>;
+
+  owner* v_ = nullptr;
+  size_type i_ = 0;
+};
+
+// Column I of `v`, like std::get on one of its rows.
+template <std::size_t I, typename Tuple>
+auto get(soa_vector<Tuple>& v) noexcept {
+  return v.template column<I>();
+}
+template <std::size_t I, typename Tuple>
+auto get(const soa_vector<Tuple>& v) noexcept {
+  return v.template column<I>();
+}
+
+} // namespace cst
@@ -0,0 +1,65 @@
+#pragma once
+
+// Minimal non-owning view over contiguous elements, a C++17 stand-in for std::span
+// (dynamic extent only) so the kernels build with /std:c++17 as well.
+//
+//   std::vector<int> v {1, 2, 3};
+//   cst::span<const int> s = v;
+//   cst::span<const int> tail = s.subspan(1);
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace cst {
+
+template <typename T>
+class span {
+  template <typename C>
+  using element_of = std::remove_pointer_t<decltype(std::data(std::declval<C&>()))>;
+  // Only allow qualification conversions (int -> const int), not int -> long.
+  template <typename U>
+  static constexpr bool compatible = std::is_convertible<U (*)[], T (*)[]>::value;
+
+public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+  using iterator = T*;
+
+  static constexpr size_type npos = static_cast<size_type>(-1);
+
+  constexpr span() noexcept = default;
+  constexpr span(T* data, size_type size) noexcept : data_(data), size_(size) {}
+  template <typename C, typename = std::enable_if_t<!std::is_same<std::decay_t<C>, span>::value &&
+                                                    compatible<element_of<C>>>>
+  constexpr span(C&& c) noexcept : data_(std::data(c)), size_(std::size(c)) {}
+  template <typename U, typename = std::enable_if_t<compatible<U>>>
+  constexpr span(const span<U>& o) noexcept : data_(o.data()), size_(o.size()) {}
+
+  constexpr T* data() const noexcept { return data_; }
+  constexpr size_type size() const noexcept { return size_; }
+  constexpr size_type size_bytes() const noexcept { return size_ * sizeof(T); }
+  constexpr bool empty() const noexcept { return size_ == 0; }
+  constexpr T* begin() const noexcept { return data_; }
+  constexpr T* end() const noexcept { return data_ + size_; }
+  constexpr T& operator[](size_type i) const { return data_[i]; }
+  constexpr T& front() const { return data_[0]; }
+  constexpr T& back() const { return data_[size_ - 1]; }
+
+  constexpr span first(size_type n) const { return {data_, n}; }
+  constexpr span last(size_type n) const { return {data_ + size_ - n, n}; }
+  constexpr span subspan(size_type offset, size_type n = npos) const {
+    return {data_ + offset, n == npos ? size_ - offset : n};
+  }
+
+private:
+  T* data_ = nullptr;
+  size_type size_ = 0;
+};
+
+} // namespace cst
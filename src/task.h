@@ -0,0 +1,480 @@
+#pragma once
+
+// Lazy coroutine tasks, executors to run them on and combinators to wait for several:
+//
+//   cst::task<int> fetch(cst::pool_executor ex, int id) {
+//     co_await ex.schedule();        // continue on a pool worker
+//     co_return load(id);
+//   }
+//   cst::task<int> total(cst::pool_executor ex) {
+//     std::vector<cst::task<int>> parts;
+//     for (int id = 0; id < 100; ++id) parts.push_back(fetch(ex, id));
+//     auto values = co_await cst::when_all(std::move(parts)); // no thread blocks meanwhile
+//     co_return std::accumulate(values.begin(), values.end(), 0);
+//   }
+//   int n = cst::sync_wait(total(cst::pool_executor()));
+//
+// A task starts when it is awaited and resumes its awaiter when it finishes, so waiting
+// costs a suspended frame instead of a blocked thread. Exceptions travel to the awaiter.
+//
+// Executors: event_loop resumes coroutines on the thread that runs it, pool_executor on
+// the workers of a cst::thread_pool. Cancellation is cooperative: a cancellation_token
+// passed to schedule() makes the resumption throw operation_cancelled once the matching
+// cancellation_source was triggered, and tasks can poll the token themselves.
+
+#if !defined(__cpp_impl_coroutine)
+#error "task.h needs C++20 coroutines (-std=c++20, or -std=c++2a -fcoroutines on GCC 10)"
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "frame_cache.h"
+#include "thread_pool.h"
+
+namespace cst {
+
+class operation_cancelled : public std::exception {
+public:
+  const char* what() const noexcept override { return "operation cancelled"; }
+};
+
+// A view of a cancellation_source; default-constructed tokens are never cancelled.
+class cancellation_token {
+public:
+  cancellation_token() = default;
+
+  bool cancellation_requested() const noexcept {
+    return state_ != nullptr && state_->load(std::memory_order_acquire);
+  }
+  void throw_if_cancellation_requested() const {
+    if (cancellation_requested()) {
+      throw operation_cancelled();
+    }
+  }
+
+private:
+  friend class cancellation_source;
+  explicit cancellation_token(std::shared_ptr<std::atomic<bool>> state) : state_(std::move(state)) {}
+
+  std::shared_ptr<std::atomic<bool>> state_;
+};
+
+// Copies share their state, like std::stop_source.
+class cancellation_source {
+public:
+  cancellation_source() : state_(std::make_shared<std::atomic<bool>>(false)) {}
+
+  cancellation_token token() const { return cancellation_token(state_); }
+  void request_cancellation() noexcept { state_->store(true, std::memory_order_release); }
+  bool cancellation_requested() const noexcept { return state_->load(std::memory_order_acquire); }
+
+private:
+  std::shared_ptr<std::atomic<bool>> state_;
+};
+
+template <typename T = void>
+class task;
+
+namespace detail {
+
+struct recycled_frame {
+  static void* operator new(std::size_t size) { return frame_cache::local().allocate(size); }
+  static void operator delete(void* p, std::size_t size) noexcept { frame_cache::local().deallocate(p, size); }
+};
+
+// The value or exception a task finished with.
+template <typename T>
+struct task_result {
+  T get() && {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return std::move(*value);
+  }
+
+  std::optional<T> value;
+  std::exception_ptr error;
+};
+
+template <>
+struct task_result<void> {
+  void get() && {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  std::exception_ptr error;
+};
+
+class task_promise_base : public recycled_frame {
+public:
+  struct final_awaiter {
+    bool await_ready() const noexcept { return false; }
+    // Symmetric transfer: the awaiter resumes without growing the stack.
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) const noexcept {
+      return h.promise().continuation_;
+    }
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  final_awaiter final_suspend() const noexcept { return {}; }
+
+  std::coroutine_handle<> continuation_ = std::noop_coroutine();
+};
+
+template <typename T>
+class task_promise : public task_promise_base {
+public:
+  task<T> get_return_object() noexcept;
+  template <typename U = T>
+  void return_value(U&& value) {
+    result_.value.emplace(std::forward<U>(value));
+  }
+  void unhandled_exception() noexcept { result_.error = std::current_exception(); }
+
+  task_result<T> result_;
+};
+
+template <>
+class task_promise<void> : public task_promise_base {
+public:
+  task<void> get_return_object() noexcept;
+  void return_void() noexcept {}
+  void unhandled_exception() noexcept { result_.error = std::current_exception(); }
+
+  task_result<void> result_;
+};
+
+// Runs eagerly and frees itself at the end; the building block for starting tasks
+// from non-coroutine code and for the combinators.
+struct detached {
+  struct promise_type : recycled_frame {
+    detached get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+// Awaits `t`, stores its outcome in `result`, then calls done().
+template <typename T, typename Done>
+detached complete_into(task<T> t, task_result<T>& result, Done done) {
+  try {
+    if constexpr (std::is_void_v<T>) {
+      co_await std::move(t);
+    } else {
+      result.value.emplace(co_await std::move(t));
+    }
+  } catch (...) {
+    result.error = std::current_exception();
+  }
+  done();
+}
+
+} // namespace detail
+
+template <typename T>
+class [[nodiscard]] task {
+public:
+  using promise_type = detail::task_promise<T>;
+  using handle = std::coroutine_handle<promise_type>;
+
+  task() noexcept = default;
+  explicit task(handle h) noexcept : h_(h) {}
+  task(task&& other) noexcept : h_(std::exchange(other.h_, {})) {}
+  task& operator=(task&& other) noexcept {
+    if (this != &other) {
+      if (h_) {
+        h_.destroy();
+      }
+      h_ = std::exchange(other.h_, {});
+    }
+    return *this;
+  }
+  ~task() {
+    if (h_) {
+      h_.destroy();
+    }
+  }
+
+  // Starts the task; the awaiter resumes with its value once it finished. Await once.
+  auto operator co_await() && noexcept {
+    struct awaiter {
+      bool await_ready() const noexcept { return false; }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        h.promise().continuation_ = awaiting;
+        return h;
+      }
+      T await_resume() { return std::move(h.promise().result_).get(); }
+
+      handle h;
+    };
+    return awaiter{h_};
+  }
+
+private:
+  handle h_;
+};
+
+namespace detail {
+
+template <typename T>
+task<T> task_promise<T>::get_return_object() noexcept {
+  return task<T>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+inline task<void> task_promise<void>::get_return_object() noexcept {
+  return task<void>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+
+// schedule() of every executor: suspends, has `post` resume the coroutine later and
+// throws operation_cancelled on resumption if `token` was cancelled meanwhile.
+template <typename Executor>
+struct schedule_awaiter {
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> h) { executor.post(h); }
+  void await_resume() const { token.throw_if_cancellation_requested(); }
+
+  Executor executor;
+  cancellation_token token;
+};
+
+} // namespace detail
+
+// Runs coroutines on the thread that calls run_until_complete, one at a time, until the
+// given task finished and nothing else is queued. Other threads may schedule onto it;
+// the loop sleeps while there is nothing to do.
+class event_loop {
+public:
+  class executor {
+  public:
+    explicit executor(event_loop& loop) : loop_(&loop) {}
+    detail::schedule_awaiter<executor> schedule(cancellation_token token = {}) const { return {*this, std::move(token)}; }
+    void post(std::coroutine_handle<> h) const { loop_->post(h); }
+
+  private:
+    event_loop* loop_;
+  };
+
+  event_loop() = default;
+  event_loop(const event_loop&) = delete;
+  event_loop& operator=(const event_loop&) = delete;
+
+  executor get_executor() { return executor(*this); }
+  detail::schedule_awaiter<executor> schedule(cancellation_token token = {}) {
+    return get_executor().schedule(std::move(token));
+  }
+
+  template <typename T>
+  T run_until_complete(task<T> t) {
+    detail::task_result<T> result;
+    bool done = false;
+    detail::complete_into(std::move(t), result, [this, &done] {
+      // Notified under the lock: once it is released, the loop may return and be gone.
+      std::lock_guard<std::mutex> lk(mutex_);
+      done = true;
+      cv_.notify_one();
+    });
+    for (;;) {
+      std::unique_lock<std::mutex> lk(mutex_);
+      cv_.wait(lk, [&] { return done || !queue_.empty(); });
+      if (queue_.empty()) {
+        break; // done, and so is everything else scheduled here
+      }
+      std::coroutine_handle<> h = queue_.front();
+      queue_.pop_front();
+      lk.unlock();
+      h.resume();
+    }
+    return std::move(result).get();
+  }
+
+  // Coroutines waiting to be resumed.
+  std::size_t pending() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return queue_.size();
+  }
+
+private:
+  void post(std::coroutine_handle<> h) {
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      queue_.push_back(h);
+    }
+    cv_.notify_one();
+  }
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::coroutine_handle<>> queue_;
+};
+
+// Resumes coroutines on the workers of a thread pool, the shared one by default.
+class pool_executor {
+public:
+  explicit pool_executor(thread_pool& pool = thread_pool::shared()) : pool_(&pool) {}
+
+  detail::schedule_awaiter<pool_executor> schedule(cancellation_token token = {}) const {
+    return {*this, std::move(token)};
+  }
+  void post(std::coroutine_handle<> h) const {
+    pool_->execute([h] { h.resume(); });
+  }
+
+private:
+  thread_pool* pool_;
+};
+
+// Blocks the calling thread until `t` finished; the task runs on whatever executors it
+// schedules itself onto, or inline on this thread if it never does.
+template <typename T>
+T sync_wait(task<T> t) {
+  event_loop loop;
+  return loop.run_until_complete(std::move(t));
+}
+
+namespace detail {
+
+struct when_all_counter {
+  explicit when_all_counter(std::size_t children) : remaining(children + 1) {}
+  // True for the last of the children and the launching awaiter to arrive.
+  bool arrive() noexcept { return remaining.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+  std::atomic<std::size_t> remaining;
+  std::coroutine_handle<> parent;
+};
+
+template <typename T>
+struct when_all_awaiter {
+  bool await_ready() const noexcept { return tasks.empty(); }
+  // The +1 in the counter keeps children that finish during the launch from resuming
+  // the parent before it is suspended.
+  bool await_suspend(std::coroutine_handle<> h) {
+    counter.parent = h;
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+      complete_into(std::move(tasks[i]), results[i], [c = &counter] {
+        if (c->arrive()) {
+          c->parent.resume();
+        }
+      });
+    }
+    return !counter.arrive();
+  }
+  void await_resume() const noexcept {}
+
+  std::vector<task<T>>& tasks;
+  std::vector<task_result<T>>& results;
+  when_all_counter& counter;
+};
+
+template <typename T>
+struct when_any_state {
+  explicit when_any_state(cancellation_source cancel) : cancel(std::move(cancel)) {}
+
+  std::atomic<bool> decided{false};
+  std::atomic<int> remaining{2}; // the winner and the launching awaiter
+  std::coroutine_handle<> parent;
+  std::size_t index = 0;
+  task_result<T> result;
+  cancellation_source cancel;
+};
+
+template <typename T>
+detached when_any_child(task<T> t, std::size_t index, std::shared_ptr<when_any_state<T>> state) {
+  task_result<T> result;
+  try {
+    result.value.emplace(co_await std::move(t));
+  } catch (...) {
+    result.error = std::current_exception();
+  }
+  if (!state->decided.exchange(true, std::memory_order_acq_rel)) {
+    state->index = index;
+    state->result = std::move(result);
+    state->cancel.request_cancellation();
+    if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      state->parent.resume();
+    }
+  }
+}
+
+// Like when_all_awaiter, it only refers to state owned by the awaiting frame: GCC 12 may
+// destroy the awaiter temporary of a co_await twice, which an owning member would not survive.
+template <typename T>
+struct when_any_awaiter {
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> h) {
+    state->parent = h;
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+      when_any_child(std::move(tasks[i]), i, state);
+    }
+    return state->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+  }
+  void await_resume() const noexcept {}
+
+  std::vector<task<T>>& tasks;
+  const std::shared_ptr<when_any_state<T>>& state;
+};
+
+} // namespace detail
+
+// The results of all tasks, in order, once every one of them finished. If some threw,
+// the first of those exceptions (by position) is rethrown.
+template <typename T>
+task<std::vector<T>> when_all(std::vector<task<T>> tasks) {
+  std::vector<detail::task_result<T>> results(tasks.size());
+  detail::when_all_counter counter(tasks.size());
+  co_await detail::when_all_awaiter<T>{tasks, results, counter};
+  std::vector<T> values;
+  values.reserve(results.size());
+  for (auto& r : results) {
+    values.push_back(std::move(r).get());
+  }
+  co_return values;
+}
+
+inline task<> when_all(std::vector<task<>> tasks) {
+  std::vector<detail::task_result<void>> results(tasks.size());
+  detail::when_all_counter counter(tasks.size());
+  co_await detail::when_all_awaiter<void>{tasks, results, counter};
+  for (auto& r : results) {
+    std::move(r).get();
+  }
+}
+
+template <typename T>
+struct when_any_result {
+  std::size_t index;
+  T value;
+};
+
+// The first task to finish, value or exception. It triggers `cancel`, which the others
+// can watch to stop early; they keep running to completion in the background and their
+// results are dropped. Throws std::invalid_argument for no tasks.
+template <typename T>
+task<when_any_result<T>> when_any(std::vector<task<T>> tasks, cancellation_source cancel = {}) {
+  static_assert(!std::is_void_v<T>, "when_any needs tasks with a value");
+  if (tasks.empty()) {
+    throw std::invalid_argument("when_any of no tasks");
+  }
+  auto state = std::make_shared<detail::when_any_state<T>>(std::move(cancel));
+  co_await detail::when_any_awaiter<T>{tasks, state};
+  const std::size_t index = state->index;
+  co_return when_any_result<T>{index, std::move(state->result).get()};
+}
+
+} // namespace cst
@@ -0,0 +1,336 @@
+#include "test_runner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CST_TEST_RUNNER_FORK 1
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace cst {
+namespace test_runner {
+
+namespace {
+
+// Set while enumerating: the list reporter appends the filtered test case names here.
+std::vector<std::string>* listed_names = nullptr;
+// Set in worker processes: the shard listener writes the run totals here.
+std::FILE* shard_stats = nullptr;
+
+// Stands in for the console reporter during enumeration, collects instead of printing.
+struct list_reporter : doctest::IReporter {
+  explicit list_reporter(const doctest::ContextOptions&) {}
+
+  void report_query(const doctest::QueryData& query) override {
+    for (unsigned i = 0; listed_names != nullptr && i < query.num_data; ++i) {
+      listed_names->push_back(query.data[i]->m_name);
+    }
+  }
+  void test_run_start() override {}
+  void test_run_end(const doctest::TestRunStats&) override {}
+  void test_case_start(const doctest::TestCaseData&) override {}
+  void test_case_reenter(const doctest::TestCaseData&) override {}
+  void test_case_end(const doctest::CurrentTestCaseStats&) override {}
+  void test_case_exception(const doctest::TestCaseException&) override {}
+  void subcase_start(const doctest::SubcaseSignature&) override {}
+  void subcase_end() override {}
+  void log_assert(const doctest::AssertData&) override {}
+  void log_message(const doctest::MessageData&) override {}
+  void test_case_skipped(const doctest::TestCaseData&) override {}
+};
+
+REGISTER_REPORTER("cst-test-list", 0, list_reporter);
+
+// Active in every run, only reports when running as a worker.
+struct shard_listener : doctest::IReporter {
+  explicit shard_listener(const doctest::ContextOptions&) {}
+
+  void report_query(const doctest::QueryData&) override {}
+  void test_run_start() override {}
+  void test_run_end(const doctest::TestRunStats& stats) override {
+    if (shard_stats != nullptr) {
+      std::fprintf(shard_stats, "%u %u %u\n", stats.numAsserts, stats.numAssertsFailed, stats.numTestCasesFailed);
+      std::fflush(shard_stats);
+    }
+  }
+  void test_case_start(const doctest::TestCaseData&) override {}
+  void test_case_reenter(const doctest::TestCaseData&) override {}
+  void test_case_end(const doctest::CurrentTestCaseStats&) override {}
+  void test_case_exception(const doctest::TestCaseException&) override {}
+  void subcase_start(const doctest::SubcaseSignature&) override {}
+  void subcase_end() override {}
+  void log_assert(const doctest::AssertData&) override {}
+  void log_message(const doctest::MessageData&) override {}
+  void test_case_skipped(const doctest::TestCaseData&) override {}
+};
+
+REGISTER_LISTENER("cst-test-shard", 0, shard_listener);
+
+// 0 - one worker per hardware thread.
+unsigned parse_jobs(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--jobs=", 7) == 0) {
+      return static_cast<unsigned>(std::strtoul(argv[i] + 7, nullptr, 10));
+    }
+    if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+      return static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10));
+    }
+  }
+  return 0;
+}
+
+// Drops the per-process banner and summary of the console reporter from a worker's
+// output, the runner prints one merged summary instead.
+std::string strip_report(const std::string& output) {
+  std::vector<std::string> lines;
+  std::size_t begin = 0;
+  while (begin < output.size()) {
+    std::size_t end = output.find('\n', begin);
+    if (end == std::string::npos) {
+      end = output.size();
+    }
+    std::string line = output.substr(begin, end - begin);
+    if (line.compare(0, 9, "[doctest]") != 0) {
+      lines.push_back(std::move(line));
+    }
+    begin = end + 1;
+  }
+  while (!lines.empty() && lines.back().find_first_not_of('=') == std::string::npos) {
+    lines.pop_back();
+  }
+  std::string stripped;
+  for (const auto& line : lines) {
+    stripped += line;
+    stripped += '\n';
+  }
+  return stripped;
+}
+
+struct totals {
+  unsigned cases = 0;
+  unsigned cases_failed = 0;
+  unsigned asserts = 0;
+  unsigned asserts_failed = 0;
+};
+
+int run_serial(int argc, char** argv, Configure configure) {
+  doctest::Context context;
+  configure(context, argc, argv);
+  return context.run();
+}
+
+#ifdef CST_TEST_RUNNER_FORK
+
+std::vector<std::string> enumerate(int argc, char** argv, Configure configure) {
+  std::vector<std::string> names;
+  doctest::Context context;
+  configure(context, argc, argv);
+  // The workers address cases by their position in the full filtered list.
+  context.setOption("first", 0);
+  context.setOption("last", INT_MAX);
+  context.setOption("reporters", "cst-test-list");
+  context.setOption("list-test-cases", true);
+  listed_names = &names;
+  context.run();
+  listed_names = nullptr;
+  return names;
+}
+
+std::string read_all(std::FILE* file) {
+  std::string content;
+  std::rewind(file);
+  char buffer[4096];
+  std::size_t n;
+  while ((n = std::fread(buffer, 1, sizeof(buffer), file)) != 0) {
+    content.append(buffer, n);
+  }
+  return content;
+}
+
+struct worker {
+  pid_t pid = -1;
+  std::size_t index = 0;
+  std::FILE* output = nullptr;
+  std::FILE* stats = nullptr;
+};
+
+worker spawn(std::size_t index, int argc, char** argv, Configure configure) {
+  worker w;
+  w.index = index;
+  w.output = std::tmpfile();
+  w.stats = std::tmpfile();
+  std::cout.flush();
+  std::fflush(nullptr);
+  w.pid = w.output != nullptr && w.stats != nullptr ? fork() : -1;
+  if (w.pid == 0) {
+    dup2(fileno(w.output), STDOUT_FILENO);
+    dup2(fileno(w.output), STDERR_FILENO);
+    shard_stats = w.stats;
+    doctest::Context context;
+    configure(context, argc, argv);
+    context.setOption("first", static_cast<int>(index + 1));
+    context.setOption("last", static_cast<int>(index + 1));
+    const int result = context.run();
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    // Skip the static destructors, they belong to the parent.
+    _exit(result);
+  }
+  return w;
+}
+
+void collect(const worker& w, int status, const std::string& name, totals& sum) {
+  const std::string output = strip_report(read_all(w.output));
+  unsigned asserts = 0, asserts_failed = 0, cases_failed = 0;
+  std::rewind(w.stats);
+  const bool reported = std::fscanf(w.stats, "%u %u %u", &asserts, &asserts_failed, &cases_failed) == 3;
+  std::fclose(w.output);
+  std::fclose(w.stats);
+
+  std::cout << output;
+  ++sum.cases;
+  if (!reported) {
+    // Crashed or exited from inside the test case; the case counts as failed.
+    std::cout << "===============================================================================\n"
+              << "TEST CASE:  " << name << "\n\nworker process ";
+    if (WIFSIGNALED(status)) {
+      std::cout << "killed by signal " << WTERMSIG(status);
+    } else {
+      std::cout << "exited with code " << WEXITSTATUS(status) << " before the end of the run";
+    }
+    std::cout << "\n\n";
+    ++sum.cases_failed;
+    return;
+  }
+  sum.asserts += asserts;
+  sum.asserts_failed += asserts_failed;
+  sum.cases_failed += cases_failed;
+}
+
+int run_forked(int argc, char** argv, Configure configure, unsigned jobs) {
+  const auto start = std::chrono::steady_clock::now();
+  const std::vector<std::string> names = enumerate(argc, argv, configure);
+  totals sum;
+  std::vector<worker> running;
+  std::size_t next = 0;
+  while (next < names.size() || !running.empty()) {
+    while (running.size() < jobs && next < names.size()) {
+      worker w = spawn(next, argc, argv, configure);
+      if (w.pid < 0) {
+        std::cerr << "[doctest] cannot start a worker for \"" << names[next] << "\": " << std::strerror(errno) << "\n";
+        if (w.output != nullptr) std::fclose(w.output);
+        if (w.stats != nullptr) std::fclose(w.stats);
+        ++sum.cases;
+        ++sum.cases_failed;
+      } else {
+        running.push_back(w);
+      }
+      ++next;
+    }
+    if (running.empty()) {
+      continue;
+    }
+    int status = 0;
+    const pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    for (auto it = running.begin(); it != running.end(); ++it) {
+      if (it->pid == pid) {
+        collect(*it, status, names[it->index], sum);
+        running.erase(it);
+        break;
+      }
+    }
+  }
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const bool failed = sum.cases_failed != 0 || sum.asserts_failed != 0;
+  std::cout << "===============================================================================\n"
+            << "[doctest] test cases: " << std::setw(6) << sum.cases << " | " << std::setw(6)
+            << sum.cases - sum.cases_failed << " passed | " << std::setw(6) << sum.cases_failed << " failed |\n"
+            << "[doctest] assertions: " << std::setw(6) << sum.asserts << " | " << std::setw(6)
+            << sum.asserts - sum.asserts_failed << " passed | " << std::setw(6) << sum.asserts_failed << " failed |\n"
+            << "[doctest] Status: " << (failed ? "FAILURE!" : "SUCCESS!") << "\n"
+            << "[doctest] " << jobs << " worker processes, " << std::fixed << std::setprecision(2) << seconds
+            << " s wall time\n";
+  std::cout.unsetf(std::ios::floatfield);
+  return failed ? 1 : 0;
+}
+
+#endif // CST_TEST_RUNNER_FORK
+
+} // namespace
+
+bool requested(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--jobs") == 0 || std::strncmp(argv[i], "--jobs=", 7) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int run_main(int argc, char** argv, Configure configure) {
+  unsigned jobs = parse_jobs(argc, argv);
+  if (jobs == 0) {
+    jobs = std::max(1u, std::thread::hardware_concurrency());
+  }
+#ifdef CST_TEST_RUNNER_FORK
+  if (jobs > 1) {
+    return run_forked(argc, argv, configure, jobs);
+  }
+#else
+  std::cerr << "[doctest] --jobs needs fork(), running the test cases serially\n";
+#endif
+  return run_serial(argc, argv, configure);
+}
+
+} // namespace test_runner
+} // namespace cst
+
+TEST_CASE("Parallel test runner") {
+  const std::string worker_output =
+      "[doctest] doctest version is \"2.3.7\"\n"
+      "[doctest] run with \"--help\" for options\n"
+      "===============================================================================\n"
+      "src/cpp11.cpp:10:\n"
+      "TEST CASE:  nullptr\n"
+      "\n"
+      "src/cpp11.cpp:12: ERROR: CHECK( foo(NULL) == 2 ) is NOT correct!\n"
+      "\n"
+      "===============================================================================\n"
+      "[doctest] test cases: 1 | 0 passed | 1 failed | 86 skipped\n"
+      "[doctest] Status: FAILURE!\n";
+  const std::string stripped = cst::test_runner::strip_report(worker_output);
+  CHECK(stripped ==
+        "===============================================================================\n"
+        "src/cpp11.cpp:10:\n"
+        "TEST CASE:  nullptr\n"
+        "\n"
+        "src/cpp11.cpp:12: ERROR: CHECK( foo(NULL) == 2 ) is NOT correct!\n");
+  CHECK(cst::test_runner::strip_report("[doctest] Status: SUCCESS!\n").empty());
+
+  const char* args[] = {"cpp-std-test", "--jobs", "8"};
+  CHECK(cst::test_runner::requested(3, const_cast<char**>(args)));
+  CHECK(cst::test_runner::parse_jobs(3, const_cast<char**>(args)) == 8);
+  const char* no_jobs[] = {"cpp-std-test", "--jobsx"};
+  CHECK_FALSE(cst::test_runner::requested(2, const_cast<char**>(no_jobs)));
+}
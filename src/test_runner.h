@@ -0,0 +1,25 @@
+#pragma once
+
+// `cpp-std-test --jobs N` runs the TEST_CASEs in N worker processes instead of one.
+//
+// The test cases are enumerated through doctest (same filters and order as a normal
+// run), then every case runs in its own forked process with --first=--last=<index>,
+// at most N at a time, so slow cases do not hold up a fixed shard. Worker output is
+// captured and printed per case, the totals are merged into one summary, and a worker
+// that crashes only fails its own case. Without fork() the run falls back to serial.
+
+#include "doctest/doctest.h"
+
+namespace cst {
+namespace test_runner {
+
+// Applies the defaults, the command line and the overrides to a context; called once
+// for the enumeration and once in every worker.
+using Configure = void (*)(doctest::Context& context, int argc, char** argv);
+
+// True if argv contains --jobs.
+bool requested(int argc, char** argv);
+int run_main(int argc, char** argv, Configure configure);
+
+} // namespace test_runner
+} // namespace cst
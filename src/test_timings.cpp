@@ -0,0 +1,507 @@
+#include "test_timings.h"
+
+#include "bench.h"
+#include "doctest/doctest.h"
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+namespace cst {
+namespace test_timings {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ns(Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+double median_of(std::vector<double> values) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  const std::size_t mid = values.size() / 2;
+  return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+// Collects the durations of one run; every repetition adds one sample per entry.
+class recorder {
+public:
+  void begin_run() { run_.clear(); }
+  void end_run() {
+    for (const auto& entry : run_) {
+      auto it = index_.find(entry.first);
+      if (it == index_.end()) {
+        it = index_.emplace(entry.first, timings_.size()).first;
+        timings_.push_back(Timing{entry.first, entry.first != case_name(entry.first), {}});
+      }
+      timings_[it->second].samples_ns.push_back(entry.second);
+    }
+  }
+
+  void case_start(const char* name) {
+    case_ = name;
+    case_start_ = Clock::now();
+    open_.clear();
+    order(case_);
+  }
+  void case_reenter() { open_.clear(); }
+  void case_end() { add(case_, elapsed_ns(case_start_)); }
+  void subcase_start(const char* name) {
+    std::string path = open_.empty() ? case_ : open_.back().first;
+    open_.emplace_back(path + " / " + name, Clock::now());
+    order(open_.back().first);
+  }
+  void subcase_end() {
+    if (!open_.empty()) {
+      add(open_.back().first, elapsed_ns(open_.back().second));
+      open_.pop_back();
+    }
+  }
+
+  const std::vector<Timing>& timings() const { return timings_; }
+
+private:
+  static std::string case_name(const std::string& key) { return key.substr(0, key.find(" / ")); }
+  void add(const std::string& key, double ns) {
+    for (auto& entry : run_) {
+      if (entry.first == key) {
+        entry.second += ns;
+        return;
+      }
+    }
+    run_.emplace_back(key, ns);
+  }
+  // Creates the entry on first sight so that a test case stays ahead of its subcases.
+  void order(const std::string& key) {
+    auto it = std::find_if(run_.begin(), run_.end(), [&](const auto& e) { return e.first == key; });
+    if (it == run_.end()) {
+      run_.emplace_back(key, 0.0);
+    }
+  }
+
+  std::string case_;
+  Clock::time_point case_start_;
+  std::vector<std::pair<std::string, Clock::time_point>> open_;
+  std::vector<std::pair<std::string, double>> run_;
+  std::map<std::string, std::size_t> index_;
+  std::vector<Timing> timings_;
+};
+
+// Set while run_main records.
+recorder* active = nullptr;
+
+struct timing_listener : doctest::IReporter {
+  explicit timing_listener(const doctest::ContextOptions&) {}
+
+  void report_query(const doctest::QueryData&) override {}
+  void test_run_start() override {}
+  void test_run_end(const doctest::TestRunStats&) override {}
+  void test_case_start(const doctest::TestCaseData& tc) override {
+    if (active) active->case_start(tc.m_name);
+  }
+  void test_case_reenter(const doctest::TestCaseData&) override {
+    if (active) active->case_reenter();
+  }
+  void test_case_end(const doctest::CurrentTestCaseStats&) override {
+    if (active) active->case_end();
+  }
+  void test_case_exception(const doctest::TestCaseException&) override {}
+  void subcase_start(const doctest::SubcaseSignature& signature) override {
+    if (active) active->subcase_start(signature.m_name);
+  }
+  void subcase_end() override {
+    if (active) active->subcase_end();
+  }
+  void log_assert(const doctest::AssertData&) override {}
+  void log_message(const doctest::MessageData&) override {}
+  void test_case_skipped(const doctest::TestCaseData&) override {}
+};
+
+REGISTER_LISTENER("cst-test-timings", 1, timing_listener);
+
+// Just enough JSON for the files write_json produces.
+class json_reader {
+public:
+  explicit json_reader(std::string text) : text_(std::move(text)) {}
+
+  std::vector<Timing> timings() {
+    std::vector<Timing> result;
+    expect('{');
+    while (!consume('}')) {
+      const std::string key = string();
+      expect(':');
+      if (key == "timings") {
+        expect('[');
+        while (!consume(']')) {
+          result.push_back(timing());
+          consume(',');
+        }
+      } else {
+        skip_value();
+      }
+      consume(',');
+    }
+    return result;
+  }
+
+private:
+  Timing timing() {
+    Timing t;
+    expect('{');
+    while (!consume('}')) {
+      const std::string key = string();
+      expect(':');
+      if (key == "name") {
+        t.name = string();
+      } else if (key == "subcase") {
+        t.subcase = literal() == "true";
+      } else if (key == "samples_ns") {
+        expect('[');
+        while (!consume(']')) {
+          t.samples_ns.push_back(number());
+          consume(',');
+        }
+      } else {
+        skip_value();
+      }
+      consume(',');
+    }
+    return t;
+  }
+
+  void skip_value() {
+    skip_space();
+    if (peek() == '"') {
+      string();
+    } else if (peek() == '{' || peek() == '[') {
+      const char open = text_[pos_], close = open == '{' ? '}' : ']';
+      ++pos_;
+      while (!consume(close)) {
+        if (open == '{') {
+          string();
+          expect(':');
+        }
+        skip_value();
+        consume(',');
+      }
+    } else {
+      literal();
+    }
+  }
+  std::string string() {
+    expect('"');
+    std::string s;
+    while (pos_ < text_.size() && text_[pos_] != '"') {
+      char c = text_[pos_++];
+      if (c == '\\' && pos_ < text_.size()) {
+        c = text_[pos_++];
+        if (c == 'n') {
+          c = '\n';
+        } else if (c == 't') {
+          c = '\t';
+        } else if (c == 'u') {
+          c = static_cast<char>(std::stoi(text_.substr(pos_, 4), nullptr, 16));
+          pos_ += 4;
+        }
+      }
+      s += c;
+    }
+    expect('"');
+    return s;
+  }
+  std::string literal() {
+    skip_space();
+    const std::size_t start = pos_;
+    while (pos_ < text_.size() && std::strchr(",}] \t\r\n", text_[pos_]) == nullptr) {
+      ++pos_;
+    }
+    if (start == pos_) {
+      fail();
+    }
+    return text_.substr(start, pos_ - start);
+  }
+  double number() {
+    const std::string s = literal();
+    char* end = nullptr;
+    const double v = std::strtod(s.c_str(), &end);
+    if (end != s.c_str() + s.size()) {
+      fail();
+    }
+    return v;
+  }
+  void skip_space() {
+    while (pos_ < text_.size() && std::strchr(" \t\r\n", text_[pos_]) != nullptr) {
+      ++pos_;
+    }
+  }
+  char peek() {
+    skip_space();
+    return pos_ < text_.size() ? text_[pos_] : '\0';
+  }
+  bool consume(char c) {
+    if (peek() == c) {
+      ++pos_;
+      return true;
+    }
+    if (pos_ >= text_.size()) {
+      fail();
+    }
+    return false;
+  }
+  void expect(char c) {
+    if (!consume(c)) {
+      fail();
+    }
+  }
+  [[noreturn]] void fail() {
+    throw std::runtime_error("malformed timings file at offset " + std::to_string(pos_));
+  }
+
+  std::string text_;
+  std::size_t pos_ = 0;
+};
+
+Options parse_options(int argc, char** argv) {
+  Options opt;
+  for (int i = 1; i < argc; ++i) {
+    std::string value;
+    if (bench::parse_option(argv[i], "--timings-out", value)) {
+      opt.out_path = value;
+    } else if (bench::parse_option(argv[i], "--timings-compare", value)) {
+      opt.compare_path = value;
+    } else if (bench::parse_option(argv[i], "--timings-repeat", value)) {
+      opt.repeats = static_cast<unsigned>(std::max(1, std::stoi(value)));
+    } else if (bench::parse_option(argv[i], "--timings-threshold", value)) {
+      opt.threshold = std::stod(value) / 100;
+    } else if (bench::parse_option(argv[i], "--timings-min-delta", value)) {
+      opt.min_delta_ns = std::stod(value) * 1e6;
+    }
+  }
+  return opt;
+}
+
+int report(const std::vector<Comparison>& comparisons, const Options& opt) {
+  std::size_t regressions = 0;
+  for (const auto& c : comparisons) {
+    regressions += c.regression ? 1 : 0;
+  }
+  std::cout << "\n[timings] " << regressions << " of " << comparisons.size()
+            << " test cases and subcases are slower than " << opt.compare_path << " by more than "
+            << opt.threshold * 100 << "% and the noise\n";
+  if (regressions == 0) {
+    return 0;
+  }
+  char line[512];
+  std::snprintf(line, sizeof(line), "  %-60s %12s %12s %9s\n", "name", "baseline", "current", "change");
+  std::cout << line;
+  for (const auto& c : comparisons) {
+    if (c.regression) {
+      std::snprintf(line, sizeof(line), "  %-60s %12s %12s %+8.1f%%\n", c.name.c_str(),
+                    bench::format_time(c.baseline_ns).c_str(), bench::format_time(c.current_ns).c_str(),
+                    100 * (c.current_ns / c.baseline_ns - 1));
+      std::cout << line;
+    }
+  }
+  return 1;
+}
+
+} // namespace
+
+double Timing::median_ns() const {
+  return median_of(samples_ns);
+}
+
+double Timing::mad_ns() const {
+  const double m = median_ns();
+  std::vector<double> deviations;
+  deviations.reserve(samples_ns.size());
+  for (double s : samples_ns) {
+    deviations.push_back(std::fabs(s - m));
+  }
+  return 1.4826 * median_of(std::move(deviations));
+}
+
+std::vector<Comparison> compare(const std::vector<Timing>& baseline, const std::vector<Timing>& current,
+                                const Options& opt) {
+  std::map<std::string, const Timing*> before;
+  for (const auto& t : baseline) {
+    before[t.name] = &t;
+  }
+  std::vector<Comparison> result;
+  for (const auto& t : current) {
+    auto it = before.find(t.name);
+    if (it == before.end() || it->second->samples_ns.empty() || t.samples_ns.empty()) {
+      continue; // new or renamed case, nothing to compare with
+    }
+    Comparison c;
+    c.name = t.name;
+    c.baseline_ns = it->second->median_ns();
+    c.current_ns = t.median_ns();
+    const double delta = c.current_ns - c.baseline_ns;
+    const double noise = std::hypot(it->second->mad_ns(), t.mad_ns());
+    c.regression = c.current_ns > c.baseline_ns * (1 + opt.threshold) && delta > 3 * noise &&
+                   delta >= opt.min_delta_ns;
+    result.push_back(c);
+  }
+  return result;
+}
+
+void write_json(std::ostream& os, const std::vector<Timing>& timings, unsigned repeats) {
+  const auto precision = os.precision(17); // round-trips a double, the default 6 digits do not
+  os << "{\n  \"context\": {\"repeats\": " << repeats << ", \"compiler\": \"" << bench::json_escape(
+#if defined(__clang__)
+            "clang " __clang_version__
+#elif defined(__GNUC__)
+            "gcc " __VERSION__
+#elif defined(_MSC_VER)
+            "msvc " + std::to_string(_MSC_VER)
+#else
+            "unknown"
+#endif
+            ) << "\"},\n  \"timings\": [";
+  for (std::size_t i = 0; i < timings.size(); ++i) {
+    const auto& t = timings[i];
+    os << (i ? ",\n" : "\n") << "    {\"name\": \"" << bench::json_escape(t.name)
+       << "\", \"subcase\": " << (t.subcase ? "true" : "false") << ", \"median_ns\": " << t.median_ns()
+       << ", \"mad_ns\": " << t.mad_ns() << ", \"samples_ns\": [";
+    for (std::size_t j = 0; j < t.samples_ns.size(); ++j) {
+      os << (j ? ", " : "") << t.samples_ns[j];
+    }
+    os << "]}";
+  }
+  os << "\n  ]\n}\n";
+  os.precision(precision);
+}
+
+std::vector<Timing> read_json(std::istream& is) {
+  std::stringstream ss;
+  ss << is.rdbuf();
+  return json_reader(ss.str()).timings();
+}
+
+bool requested(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--timings-", 10) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int run_main(int argc, char** argv, test_runner::Configure configure) {
+  const Options opt = parse_options(argc, argv);
+
+  std::vector<Timing> baseline;
+  if (!opt.compare_path.empty()) {
+    std::ifstream in(opt.compare_path);
+    if (!in) {
+      std::cerr << "cannot read " << opt.compare_path << "\n";
+      return 1;
+    }
+    try {
+      baseline = read_json(in);
+    } catch (const std::exception& e) {
+      std::cerr << opt.compare_path << ": " << e.what() << "\n";
+      return 1;
+    }
+  }
+
+  // With the JSON on stdout the doctest report would corrupt it.
+  std::streambuf* console = nullptr;
+  std::ostringstream discard;
+  if (opt.out_path == "-") {
+    console = std::cout.rdbuf(discard.rdbuf());
+  }
+
+  recorder rec;
+  active = &rec;
+  int result = 0;
+  for (unsigned i = 0; i < opt.repeats; ++i) {
+    doctest::Context context;
+    configure(context, argc, argv);
+    rec.begin_run();
+    result = std::max(result, context.run());
+    rec.end_run();
+  }
+  active = nullptr;
+
+  if (console != nullptr) {
+    std::cout.rdbuf(console);
+    write_json(std::cout, rec.timings(), opt.repeats);
+  } else if (!opt.out_path.empty()) {
+    std::ofstream out(opt.out_path);
+    if (!out) {
+      std::cerr << "cannot write " << opt.out_path << "\n";
+      return 1;
+    }
+    write_json(out, rec.timings(), opt.repeats);
+  }
+  if (!opt.compare_path.empty()) {
+    result = std::max(result, report(compare(baseline, rec.timings(), opt), opt));
+  }
+  return result;
+}
+
+} // namespace test_timings
+} // namespace cst
+
+TEST_CASE("Test timings") {
+  using cst::test_timings::Timing;
+
+  SUBCASE("median and MAD") {
+    Timing t{"a", false, {10, 12, 11, 13, 100}};
+    CHECK(t.median_ns() == 12);
+    CHECK(t.mad_ns() == doctest::Approx(1.4826));
+    CHECK(Timing{"b", false, {4, 2}}.median_ns() == 3);
+  }
+
+  SUBCASE("compare") {
+    cst::test_timings::Options opt;
+    opt.min_delta_ns = 0;
+    std::vector<Timing> before {{"stable", false, {100, 101, 99}},
+                                {"slower", false, {100, 101, 99}},
+                                {"noisy", false, {100, 160, 40}},
+                                {"gone", false, {100}}};
+    std::vector<Timing> after {{"stable", false, {105, 104, 106}},
+                               {"slower", false, {150, 151, 149}},
+                               {"noisy", false, {150, 210, 90}},
+                               {"new", false, {100}}};
+    auto result = cst::test_timings::compare(before, after, opt);
+    REQUIRE(result.size() == 3);
+    CHECK_FALSE(result[0].regression); // within the threshold
+    CHECK(result[1].regression);
+    CHECK_FALSE(result[2].regression); // +50%, but within the noise
+    opt.min_delta_ns = 1e3;
+    CHECK_FALSE(cst::test_timings::compare(before, after, opt)[1].regression); // too small to matter
+  }
+
+  SUBCASE("JSON round trip") {
+    std::vector<Timing> timings {{"Move semantics && std::move", false, {1500, 12345678.25}}, // past 6 digits
+                                 {"Move semantics && std::move / \"quoted\"", true, {10}}};
+    std::stringstream ss;
+    cst::test_timings::write_json(ss, timings, 2);
+    auto read = cst::test_timings::read_json(ss);
+    REQUIRE(read.size() == 2);
+    CHECK(read[0].name == timings[0].name);
+    CHECK(read[0].samples_ns == timings[0].samples_ns);
+    CHECK_FALSE(read[0].subcase);
+    CHECK(read[1].name == timings[1].name);
+    CHECK(read[1].subcase);
+
+    std::stringstream broken("{\"timings\": [{\"name\": \"x\", \"samples_ns\": [1, oops]}]}");
+    CHECK_THROWS_AS(cst::test_timings::read_json(broken), std::runtime_error);
+  }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// Wall time of every TEST_CASE and SUBCASE, recorded by a doctest listener, saved as a
+// JSON baseline and compared against one to catch compiler or stdlib regressions.
+//
+//   cpp-std-test --timings-repeat=5 --timings-out=baseline.json      # before the upgrade
+//   cpp-std-test --timings-repeat=5 --timings-compare=baseline.json  # after it
+//
+// Each entry keeps one sample per repetition. A case is reported as slower when its
+// median grew by more than --timings-threshold (percent, default 10), by more than
+// three times the combined noise (scaled MAD of both sample sets) and by at least
+// --timings-min-delta (ms, default 0.1). The compare run exits with 1 on regressions.
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "test_runner.h"
+
+namespace cst {
+namespace test_timings {
+
+struct Options {
+  std::string out_path;       // "-" writes to stdout
+  std::string compare_path;
+  unsigned repeats = 1;
+  double threshold = 0.10;    // relative growth of the median
+  double min_delta_ns = 1e5;
+};
+
+struct Timing {
+  std::string name;           // "<test case>" or "<test case> / <subcase> / ..."
+  bool subcase = false;
+  std::vector<double> samples_ns;
+
+  double median_ns() const;
+  // Median absolute deviation, scaled by 1.4826 to estimate the standard deviation.
+  double mad_ns() const;
+};
+
+struct Comparison {
+  std::string name;
+  double baseline_ns = 0;
+  double current_ns = 0;
+  bool regression = false;
+};
+
+std::vector<Comparison> compare(const std::vector<Timing>& baseline, const std::vector<Timing>& current,
+                                const Options& opt);
+void write_json(std::ostream& os, const std::vector<Timing>& timings, unsigned repeats);
+// Reads a file written by write_json; throws std::runtime_error on malformed input.
+std::vector<Timing> read_json(std::istream& is);
+
+// True if argv contains one of the --timings-* options.
+bool requested(int argc, char** argv);
+int run_main(int argc, char** argv, test_runner::Configure configure);
+
+} // namespace test_timings
+} // namespace cst
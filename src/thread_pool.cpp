@@ -0,0 +1,168 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace cst {
+
+namespace {
+
+// Pool and queue index of the worker running on this thread, if any.
+thread_local const thread_pool* current_pool = nullptr;
+thread_local std::size_t current_index = 0;
+
+} // namespace
+
+thread_pool::thread_pool(unsigned threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (unsigned i = 0; i < threads; ++i) {
+    queues_.push_back(std::make_unique<worker_queue>());
+  }
+  workers_.reserve(threads);
+  for (unsigned i = 0; i < threads; ++i) {
+    workers_.emplace_back([this, i] { worker_loop(i); });
+  }
+}
+
+thread_pool::~thread_pool() {
+  {
+    std::lock_guard<std::mutex> lk(sleep_mutex_);
+    stop_ = true;
+  }
+  sleep_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+thread_pool& thread_pool::shared() {
+  static thread_pool pool;
+  return pool;
+}
+
+void thread_pool::post(job j) {
+  // Counted before it is visible so that a thief never drives the counter below zero.
+  pending_.fetch_add(1);
+  worker_queue& q = current_pool == this ? *queues_[current_index] : injection_;
+  {
+    std::lock_guard<std::mutex> lk(q.mutex);
+    q.jobs.push_back(std::move(j));
+  }
+  if (sleepers_.load() != 0) {
+    { std::lock_guard<std::mutex> lk(sleep_mutex_); }
+    sleep_cv_.notify_one();
+  }
+}
+
+thread_pool::job thread_pool::take(std::size_t self) {
+  job j;
+  {
+    // Own deque: newest first.
+    worker_queue& own = *queues_[self];
+    std::lock_guard<std::mutex> lk(own.mutex);
+    if (!own.jobs.empty()) {
+      j = std::move(own.jobs.back());
+      own.jobs.pop_back();
+    }
+  }
+  if (!j) {
+    std::lock_guard<std::mutex> lk(injection_.mutex);
+    if (!injection_.jobs.empty()) {
+      j = std::move(injection_.jobs.front());
+      injection_.jobs.pop_front();
+    }
+  }
+  // Steal the oldest job of another worker, it tends to be the biggest piece of work.
+  for (std::size_t k = 1; !j && k < queues_.size(); ++k) {
+    worker_queue& victim = *queues_[(self + k) % queues_.size()];
+    std::unique_lock<std::mutex> lk(victim.mutex, std::try_to_lock);
+    if (lk.owns_lock() && !victim.jobs.empty()) {
+      j = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+    }
+  }
+  if (j) {
+    pending_.fetch_sub(1);
+  }
+  return j;
+}
+
+void thread_pool::worker_loop(std::size_t index) {
+  current_pool = this;
+  current_index = index;
+  for (;;) {
+    if (job j = take(index)) {
+      j();
+      continue;
+    }
+    std::unique_lock<std::mutex> lk(sleep_mutex_);
+    sleepers_.fetch_add(1);
+    sleep_cv_.wait(lk, [this] { return pending_.load() != 0 || stop_.load(); });
+    sleepers_.fetch_sub(1);
+    if (stop_.load() && pending_.load() == 0) {
+      return;
+    }
+  }
+}
+
+namespace {
+
+struct fork_join_state {
+  explicit fork_join_state(std::size_t n, function_ref<void(std::size_t)> fn) : n(n), fn(fn) {}
+
+  // Claims indices until none are left; safe to call from any number of threads.
+  void drain() {
+    for (std::size_t i = next.fetch_add(1); i < n; i = next.fetch_add(1)) {
+      try {
+        fn(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lk(mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      if (done.fetch_add(1) + 1 == n) {
+        std::lock_guard<std::mutex> lk(mutex);
+        cv.notify_all();
+      }
+    }
+  }
+
+  const std::size_t n;
+  const function_ref<void(std::size_t)> fn;
+  std::atomic<std::size_t> next{0};
+  std::atomic<std::size_t> done{0};
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::exception_ptr error;
+};
+
+} // namespace
+
+void thread_pool::fork_join(std::size_t n, function_ref<void(std::size_t)> fn, unsigned concurrency) {
+  if (n == 0) {
+    return;
+  }
+  if (concurrency == 0 || concurrency > size() + 1) {
+    concurrency = size() + 1;
+  }
+  // Helpers may start after the caller already finished all the work, so the state
+  // outlives this call; `fn` is only touched while indices are left. The caller
+  // claims indices too, so nested calls from busy workers cannot deadlock.
+  auto state = std::make_shared<fork_join_state>(n, fn);
+  auto helpers = std::min<std::size_t>(concurrency - 1, n - 1);
+  for (std::size_t i = 0; i < helpers; ++i) {
+    post(job([state] { state->drain(); }));
+  }
+  state->drain();
+  {
+    std::unique_lock<std::mutex> lk(state->mutex);
+    state->cv.wait(lk, [&] { return state->done.load() == n; });
+  }
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+} // namespace cst
@@ -0,0 +1,132 @@
+#pragma once
+
+// Work-stealing thread pool, shared by the parallel algorithms in parallel.h.
+//
+// Every worker owns a deque: jobs submitted from a worker go to the back of its own
+// deque and are popped LIFO (hot in cache), idle workers steal from the front of the
+// others. Jobs submitted from outside the pool go through a shared injection queue.
+//
+//   auto f = cst::thread_pool::shared().submit(async_task); // no thread per call
+//   cst::thread_pool::shared().parallel_for(0, v.size(), [&](std::size_t i) { v[i] *= 2; });
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "function.h"
+
+namespace cst {
+
+class thread_pool {
+public:
+  // 0 - one worker per hardware thread.
+  explicit thread_pool(unsigned threads = 0);
+  // Runs the jobs that are still queued, then joins the workers.
+  ~thread_pool();
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+  // Note: blocking on the returned future from inside a job of the same pool ties up
+  // that worker; use fork_join/parallel_for for nested parallelism.
+  template <typename F>
+  auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+    using R = std::invoke_result_t<std::decay_t<F>>;
+    std::packaged_task<R()> task(std::forward<F>(f));
+    auto future = task.get_future();
+    post(job(std::move(task)));
+    return future;
+  }
+
+  // Fire and forget: runs f() on a worker, without the future and packaged_task of
+  // submit. f must not throw; the coroutine executors in task.h resume through this.
+  template <typename F>
+  void execute(F&& f) {
+    post(job(std::forward<F>(f)));
+  }
+
+  // Calls fn(0) .. fn(n - 1) on at most `concurrency` threads (0 - all workers), the
+  // calling thread included, and returns when every call has finished. The first
+  // exception thrown by fn is rethrown here. Safe to nest inside pool jobs.
+  void fork_join(std::size_t n, function_ref<void(std::size_t)> fn, unsigned concurrency = 0);
+
+  // Calls f(i) for every i in [first, last), `grain` indices per job (0 - automatic).
+  template <typename F>
+  void parallel_for(std::size_t first, std::size_t last, F&& f, std::size_t grain = 0) {
+    if (last <= first) {
+      return;
+    }
+    const std::size_t n = last - first;
+    if (grain == 0) {
+      grain = std::max<std::size_t>(1, n / (8 * (size() + 1)));
+    }
+    const std::size_t chunks = (n + grain - 1) / grain;
+    fork_join(chunks, [&](std::size_t c) {
+      const std::size_t end = std::min(last, first + (c + 1) * grain);
+      for (std::size_t i = first + c * grain; i < end; ++i) {
+        f(i);
+      }
+    });
+  }
+
+  // Process-wide pool, created on first use.
+  static thread_pool& shared();
+
+private:
+  // Move-only type-erased job; std::function would require copyable packaged_tasks.
+  class job {
+  public:
+    job() = default;
+    template <typename F>
+    explicit job(F&& f) : impl_(new model<std::decay_t<F>>(std::forward<F>(f))) {}
+    void operator()() { impl_->call(); }
+    explicit operator bool() const { return impl_ != nullptr; }
+
+  private:
+    struct concept_t {
+      virtual ~concept_t() = default;
+      virtual void call() = 0;
+    };
+    template <typename F>
+    struct model : concept_t {
+      explicit model(F&& f) : f(std::move(f)) {}
+      void call() override { f(); }
+      F f;
+    };
+    std::unique_ptr<concept_t> impl_;
+  };
+
+  struct alignas(64) worker_queue {
+    std::mutex mutex;
+    std::deque<job> jobs;
+  };
+
+  void post(job j);
+  job take(std::size_t self);
+  void worker_loop(std::size_t index);
+
+  std::vector<std::unique_ptr<worker_queue>> queues_;
+  worker_queue injection_;
+  std::vector<std::thread> workers_;
+
+  // Jobs queued but not yet taken; idle workers sleep while it is zero.
+  std::atomic<std::size_t> pending_{0};
+  std::atomic<unsigned> sleepers_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  std::atomic<bool> stop_{false};
+};
+
+} // namespace cst
@@ -0,0 +1,293 @@
+#pragma once
+
+// Zero-copy tokenizers over one large buffer. Tokens are string_views into the buffer,
+// produced lazily while iterating; delimiters are found 64 bytes at a time with
+// cst::simd::byte_mask64.
+//
+//   for (std::string_view word : cst::split(text)) {}                // whitespace, like istream >>
+//   for (std::string_view cell : cst::split(line, ",", true)) {}     // one token per delimiter
+//   for (const cst::csv_field& f : cst::csv(text)) {                 // RFC 4180 quoting
+//     use(f.raw);
+//     if (f.last) end_row();
+//   }
+//
+// Nothing is allocated per token. A quoted CSV field keeps doubled quotes in `raw`;
+// value() copies it out unescaped when needed.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include "simd.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace cst {
+namespace detail {
+
+inline unsigned count_trailing_zeros64(std::uint64_t x) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward64(&index, x);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctzll(x));
+#endif
+}
+
+// Finds the bytes of a set in a buffer, keeping the mask of the current 64-byte block.
+class byte_scanner {
+public:
+  byte_scanner(std::string_view text, const simd::byte_set& set) : text_(text), set_(set) {}
+
+  std::string_view text() const { return text_; }
+  // First position >= from whose byte is in the set, text().size() if there is none.
+  std::size_t find(std::size_t from) { return search(from, false); }
+  // First position >= from whose byte is not in the set.
+  std::size_t find_not(std::size_t from) { return search(from, true); }
+
+private:
+  std::size_t search(std::size_t from, bool outside) {
+    while (from < text_.size()) {
+      const std::size_t block = from - from % 64;
+      if (block != block_) {
+        load(block);
+      }
+      std::uint64_t m = (outside ? ~mask_ : mask_) & (~std::uint64_t(0) << (from - block));
+      if (m != 0) {
+        return std::min(block + count_trailing_zeros64(m), text_.size());
+      }
+      from = block + 64;
+    }
+    return text_.size();
+  }
+
+  void load(std::size_t block) {
+    if (text_.size() - block >= 64) {
+      mask_ = simd::byte_mask64(text_.data() + block, set_);
+    } else {
+      // The last partial block, padded with a byte outside the set.
+      char tail[64];
+      std::memset(tail, set_.filler(), sizeof(tail));
+      std::memcpy(tail, text_.data() + block, text_.size() - block);
+      mask_ = simd::byte_mask64(tail, set_);
+    }
+    block_ = block;
+  }
+
+  std::string_view text_;
+  simd::byte_set set_;
+  std::size_t block_ = static_cast<std::size_t>(-1);
+  std::uint64_t mask_ = 0;
+};
+
+// Input iterator over a parser with `bool next(value_type&)`.
+template <typename Parser, typename Value>
+class token_iterator {
+public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = Value;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const Value*;
+  using reference = const Value&;
+
+  token_iterator() = default;
+  explicit token_iterator(const Parser& parser) : parser_(parser), done_(false) { ++*this; }
+
+  reference operator*() const { return value_; }
+  pointer operator->() const { return &value_; }
+  token_iterator& operator++() {
+    done_ = !parser_.next(value_);
+    return *this;
+  }
+  void operator++(int) { ++*this; }
+
+  // Only the end state is compared: iterators of one range are equal once exhausted.
+  friend bool operator==(const token_iterator& a, const token_iterator& b) { return a.done_ == b.done_; }
+  friend bool operator!=(const token_iterator& a, const token_iterator& b) { return !(a == b); }
+
+private:
+  Parser parser_;
+  Value value_{};
+  bool done_ = true;
+};
+
+class split_parser {
+public:
+  split_parser() : split_parser({}, simd::byte_set(" "), false) {}
+  split_parser(std::string_view text, const simd::byte_set& delimiters, bool keep_empty)
+      : scanner_(text, delimiters), keep_empty_(keep_empty) {}
+
+  bool next(std::string_view& token) {
+    const std::string_view text = scanner_.text();
+    if (pos_ > text.size()) {
+      return false;
+    }
+    std::size_t start = pos_;
+    if (!keep_empty_) {
+      start = scanner_.find_not(pos_);
+      if (start == text.size()) {
+        pos_ = text.size() + 1;
+        return false;
+      }
+    }
+    const std::size_t end = scanner_.find(start);
+    token = text.substr(start, end - start);
+    pos_ = end + 1; // past the delimiter, or past the end
+    return true;
+  }
+
+private:
+  byte_scanner scanner_;
+  bool keep_empty_;
+  std::size_t pos_ = 0;
+};
+
+} // namespace detail
+
+// Tokens separated by any of up to four delimiter bytes. Runs of delimiters count as one
+// and leading/trailing ones are skipped unless `keep_empty`, which yields one token more
+// than there are delimiters, like std::getline(stream, token, delimiter).
+class split {
+public:
+  using iterator = detail::token_iterator<detail::split_parser, std::string_view>;
+
+  explicit split(std::string_view text, std::string_view delimiters = " \t\n\r", bool keep_empty = false)
+      : parser_(text, simd::byte_set(delimiters), keep_empty) {}
+
+  iterator begin() const { return iterator(parser_); }
+  iterator end() const { return iterator(); }
+
+private:
+  detail::split_parser parser_;
+};
+
+struct csv_field {
+  std::string_view raw; // without the enclosing quotes, doubled quotes still doubled
+  bool quoted = false;
+  bool escaped = false; // raw contains doubled quotes
+  bool last = false;    // the last field of its record
+
+  // The field with doubled quotes collapsed; allocates, unlike raw.
+  std::string value(char quote = '"') const {
+    std::string out(raw);
+    if (escaped) {
+      const char pair[2] = {quote, quote};
+      std::size_t write = 0;
+      for (std::size_t read = 0; read < out.size(); ++read) {
+        out[write++] = out[read];
+        if (out.compare(read, 2, pair, 2) == 0) {
+          ++read;
+        }
+      }
+      out.resize(write);
+    }
+    return out;
+  }
+};
+
+namespace detail {
+
+class csv_parser {
+public:
+  csv_parser() : csv_parser({}, ',', '"') {}
+  csv_parser(std::string_view text, char delimiter, char quote)
+      : scanner_(text, separators(delimiter, quote)), delimiter_(delimiter), quote_(quote) {}
+
+  bool next(csv_field& field) {
+    const std::string_view text = scanner_.text();
+    if (pos_ > text.size() || (record_start_ && pos_ == text.size())) {
+      return false; // no empty record after the final line break
+    }
+    field = csv_field();
+    std::size_t end;
+    if (pos_ < text.size() && text[pos_] == quote_) {
+      field.quoted = true;
+      const std::size_t start = pos_ + 1;
+      std::size_t close = start;
+      for (;;) {
+        close = find_quote(close);
+        if (close + 1 < text.size() && text[close + 1] == quote_) {
+          field.escaped = true;
+          close += 2;
+          continue;
+        }
+        break;
+      }
+      field.raw = text.substr(start, std::min(close, text.size()) - start);
+      // Anything between the closing quote and the separator is malformed and dropped.
+      end = close < text.size() ? find_separator(close + 1) : text.size();
+    } else {
+      end = find_separator(pos_);
+      field.raw = text.substr(pos_, end - pos_);
+    }
+
+    if (end == text.size()) {
+      field.last = true;
+      pos_ = text.size() + 1;
+    } else if (text[end] == delimiter_) {
+      pos_ = end + 1;
+      record_start_ = false;
+    } else {
+      field.last = true;
+      pos_ = end + (text[end] == '\r' && end + 1 < text.size() && text[end + 1] == '\n' ? 2 : 1);
+      record_start_ = true;
+    }
+    return true;
+  }
+
+private:
+  static simd::byte_set separators(char delimiter, char quote) {
+    const char bytes[] = {delimiter, '\n', '\r', quote};
+    return simd::byte_set(std::string_view(bytes, sizeof(bytes)));
+  }
+
+  std::size_t find_quote(std::size_t from) {
+    const std::string_view text = scanner_.text();
+    std::size_t i = scanner_.find(from);
+    while (i < text.size() && text[i] != quote_) {
+      i = scanner_.find(i + 1);
+    }
+    return i;
+  }
+  // A quote inside an unquoted field is taken literally.
+  std::size_t find_separator(std::size_t from) {
+    const std::string_view text = scanner_.text();
+    std::size_t i = scanner_.find(from);
+    while (i < text.size() && text[i] == quote_) {
+      i = scanner_.find(i + 1);
+    }
+    return i;
+  }
+
+  byte_scanner scanner_;
+  char delimiter_;
+  char quote_;
+  std::size_t pos_ = 0;
+  bool record_start_ = true;
+};
+
+} // namespace detail
+
+// The fields of CSV text, record after record; csv_field::last marks the end of a record.
+// Line breaks are \n or \r\n; delimiters and line breaks inside quotes belong to the field.
+class csv {
+public:
+  using iterator = detail::token_iterator<detail::csv_parser, csv_field>;
+
+  explicit csv(std::string_view text, char delimiter = ',', char quote = '"') : parser_(text, delimiter, quote) {}
+
+  iterator begin() const { return iterator(parser_); }
+  iterator end() const { return iterator(); }
+
+private:
+  detail::csv_parser parser_;
+};
+
+} // namespace cst
@@ -0,0 +1,133 @@
+#pragma once
+
+// std::visit with switch statements instead of a table of function pointers:
+//
+//   std::variant<int, double, std::string> v = 1.5;
+//   auto size = cst::fast_visit([](const auto& x) { return sizeof(x); }, v);
+//   cst::fast_visit([](auto a, auto b) { ... }, v1, v2); // nested switches, one per variant
+//
+// A switch over the index lets the compiler inline the visitor into every case and turn
+// the dispatch into a jump table or a few compares, where some standard libraries call
+// through a pointer that blocks inlining. Variants with more than 64 alternatives fall
+// back to std::visit. Like std::visit, a valueless variant throws std::bad_variant_access
+// and every alternative has to produce the same return type.
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace cst {
+namespace detail {
+
+constexpr std::size_t fast_visit_max_alternatives = 64;
+
+// std::unreachable before C++23.
+[[noreturn]] inline void unreachable() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+  __assume(0);
+#else
+  __builtin_unreachable();
+#endif
+}
+
+template <typename V>
+constexpr std::size_t variant_size_of = std::variant_size_v<std::remove_cv_t<std::remove_reference_t<V>>>;
+
+// std::get without the index check, the switch already did it.
+template <std::size_t I, typename V>
+constexpr decltype(auto) get_alternative(V&& v) noexcept {
+  auto* p = std::get_if<I>(&v);
+  if constexpr (std::is_rvalue_reference_v<V&&>) {
+    return std::move(*p);
+  } else {
+    return *p;
+  }
+}
+
+#define CST_VISIT_CASE(i)                                                                \
+  case i:                                                                                \
+    if constexpr ((i) < n) {                                                             \
+      return std::invoke(std::forward<F>(f), get_alternative<(i)>(std::forward<V>(v))); \
+    } else {                                                                             \
+      break;                                                                             \
+    }
+#define CST_VISIT_CASE4(i) CST_VISIT_CASE(i) CST_VISIT_CASE(i + 1) CST_VISIT_CASE(i + 2) CST_VISIT_CASE(i + 3)
+#define CST_VISIT_CASE16(i) CST_VISIT_CASE4(i) CST_VISIT_CASE4(i + 4) CST_VISIT_CASE4(i + 8) CST_VISIT_CASE4(i + 12)
+
+template <typename R, typename F, typename V>
+constexpr R visit_one(F&& f, V&& v) {
+  constexpr std::size_t n = variant_size_of<V>;
+  switch (v.index()) {
+    CST_VISIT_CASE16(0)
+    CST_VISIT_CASE16(16)
+    CST_VISIT_CASE16(32)
+    CST_VISIT_CASE16(48)
+  default:
+    break;
+  }
+  unreachable();
+}
+
+#undef CST_VISIT_CASE16
+#undef CST_VISIT_CASE4
+#undef CST_VISIT_CASE
+
+// Dispatches on the first variant, then on the rest with the first alternative bound.
+template <typename R, typename F, typename V, typename... Vs>
+constexpr R visit_all(F&& f, V&& v, Vs&&... vs) {
+  if constexpr (sizeof...(Vs) == 0) {
+    return visit_one<R>(std::forward<F>(f), std::forward<V>(v));
+  } else {
+    return visit_one<R>(
+        [&](auto&& first) -> R {
+          return visit_all<R>(
+              [&](auto&&... rest) -> R {
+                return std::invoke(std::forward<F>(f), std::forward<decltype(first)>(first),
+                                   std::forward<decltype(rest)>(rest)...);
+              },
+              std::forward<Vs>(vs)...);
+        },
+        std::forward<V>(v));
+  }
+}
+
+template <typename... Ts>
+struct type_list {};
+
+// Whether `f` returns R for every combination of alternatives, one from each variant.
+template <typename R, typename F, typename Bound, typename... Vs>
+struct visit_returns;
+template <typename R, typename F, typename... Args>
+struct visit_returns<R, F, type_list<Args...>> : std::is_same<R, std::invoke_result_t<F, Args...>> {};
+template <typename R, typename F, typename... Args, typename V, typename... Vs>
+struct visit_returns<R, F, type_list<Args...>, V, Vs...> {
+  template <std::size_t... I>
+  static constexpr bool each(std::index_sequence<I...>) {
+    return (visit_returns<R, F, type_list<Args..., decltype(get_alternative<I>(std::declval<V>()))>, Vs...>::value && ...);
+  }
+  static constexpr bool value = each(std::make_index_sequence<variant_size_of<V>>());
+};
+template <typename R, typename F, typename... Vs>
+inline constexpr bool visit_returns_v = visit_returns<R, F, type_list<>, Vs...>::value;
+
+} // namespace detail
+
+template <typename F, typename... Vs>
+constexpr decltype(auto) fast_visit(F&& f, Vs&&... vs) {
+  static_assert(sizeof...(Vs) > 0, "fast_visit needs at least one variant");
+  if constexpr (((detail::variant_size_of<Vs> > detail::fast_visit_max_alternatives) || ...)) {
+    return std::visit(std::forward<F>(f), std::forward<Vs>(vs)...);
+  } else {
+    using R = std::invoke_result_t<F, decltype(detail::get_alternative<0>(std::declval<Vs>()))...>;
+    static_assert(detail::visit_returns_v<R, F, Vs...>,
+                  "fast_visit: the visitor has to return the same type for every alternative");
+    if ((vs.valueless_by_exception() || ...)) {
+      throw std::bad_variant_access();
+    }
+    return detail::visit_all<R>(std::forward<F>(f), std::forward<Vs>(vs)...);
+  }
+}
+
+} // namespace cst